@@ -1,9 +1,11 @@
 #include <Arduino.h>
 #include <string.h>
 #include "MyServo.h"
+#include "MoveCore.h"
 #include "SequenceManager.h"
 #include "Config.h"
 #include "API.h"
+#include "TxQueue.h"
 #include "Types.h"
 
 #define MAX_TOKENS  5
@@ -13,7 +15,7 @@ static char* tokens[MAX_TOKENS];
 
 void APISetup()
 {
-    Serial.println("Listening for API commands, type 'HELP' for list of commands.");
+    txVerbose.println(F("Listening for API commands, type 'HELP' for list of commands."));
     Serial.setTimeout(2000); // safer for long lines
 }
 
@@ -47,6 +49,20 @@ static int tokenize(char* line, char** tokens, int maxTokens)
     return count;
 }
 
+// Reply to startMoves(), for MOVE and SCRAMBLE
+static void replyMoves(int res)
+{
+    if (res == 0 && seqManager.etaMs > 0)
+    {
+        txEvent.print(F("OK eta="));
+        txEvent.println(seqManager.etaMs);
+    }
+    else if (res == 0) txEvent.println(F("OK"));
+    else if (res == -1) txEvent.println(F("ERR busy"));
+    else if (res == -2) txEvent.println(F("ERR format"));
+    else txEvent.println(F("ERR"));
+}
+
 void APILoop()
 {
     if (!Serial.available())
@@ -71,29 +87,38 @@ void APILoop()
     // --- HELP ---
     if (strcmp(cmd, "HELP") == 0)
     {
-        Serial.println("Commands:");
-        Serial.println("HELP");
-        Serial.println("PING");
-        Serial.println("STATUS [servo]");
-        Serial.println("SEQ <string>|C");
-        Serial.println("MOVE <delay_ms> <orientation> <moves>");
+        txVerbose.println(F("Commands:"));
+        txVerbose.println(F("HELP"));
+        txVerbose.println(F("PING"));
+        txVerbose.println(F("STATUS [servo]"));
+        txVerbose.println(F("SEQ <string> [+]|C"));
+        txVerbose.println(F("MOVE <delay_ms|0> <orientation> <moves> [+]"));
+        txVerbose.println(F("APPEND [<moves|string> [+]]"));
+        txVerbose.println(F("STATE [<facelets>]"));
+        txVerbose.println(F("RESUME [+|?]"));
+        txVerbose.println(F("SCRAMBLE <seed> <n> <delay_ms|0>"));
+        txVerbose.println(F("DRYRUN [0|1]"));
+        txVerbose.println(F("CPU"));
+        txVerbose.println(F("POWER"));
         return;
     }
 
     // --- SEQ ---
     if (strcmp(cmd, "SEQ") == 0)
     {
-        if (tokenCount != 2)
+        // A trailing + keeps the stream open for APPEND
+        bool stream = tokenCount == 3 && strcmp(tokens[2], "+") == 0;
+        if (tokenCount != 2 && !stream)
         {
-            Serial.println("ERR args");
+            txEvent.println(F("ERR args"));
             return;
         }
 
-        int res = seqManager.startSequence(tokens[1]);
-        if (res == 0) Serial.println("OK");
-        else if (res == -1) Serial.println("ERR busy");
-        else if (res == -2) Serial.println("ERR format");
-        else Serial.println("ERR");
+        int res = seqManager.startSequence(tokens[1], stream);
+        if (res == 0) txEvent.println(F("OK"));
+        else if (res == -1) txEvent.println(F("ERR busy"));
+        else if (res == -2) txEvent.println(F("ERR format"));
+        else txEvent.println(F("ERR"));
 
         return;
     }
@@ -101,16 +126,18 @@ void APILoop()
     // --- MOVE ---
     if (strcmp(cmd, "MOVE") == 0)
     {
-        if (tokenCount != 4)
+        // A trailing + keeps the stream open for APPEND
+        bool stream = tokenCount == 5 && strcmp(tokens[4], "+") == 0;
+        if (tokenCount != 4 && !stream)
         {
-            Serial.println("ERR args");
+            txEvent.println(F("ERR args"));
             return;
         }
 
         int delay = atoi(tokens[1]);
-        if (delay < 0)
+        if (delay < 0 || delay > MOVE_MAX_DELAY_MS)
         {
-            Serial.println("ERR delay");
+            txEvent.println(F("ERR delay"));
             return;
         }
 
@@ -121,15 +148,64 @@ void APILoop()
             seqManager.orientation = ORIENT_INVERT;
         else
         {
-            Serial.println("ERR orientation");
+            txEvent.println(F("ERR orientation"));
+            return;
+        }
+
+        replyMoves(seqManager.startMoves(tokens[3], delay, stream));
+        return;
+    }
+
+    // --- SCRAMBLE ---
+    if (strcmp(cmd, "SCRAMBLE") == 0)
+    {
+        // A MOVE of n random moves (scrambleMoves() in MoveCore.h), from the orientation the cube is in
+        if (tokenCount != 4)
+        {
+            txEvent.println(F("ERR args"));
+            return;
+        }
+
+        unsigned long seed = strtoul(tokens[1], NULL, 10);
+        int n = atoi(tokens[2]);
+        int delay = atoi(tokens[3]);
+        if (n < 1 || n >= MOVE_BUFFER_SIZE)
+        {
+            txEvent.println(F("ERR count"));
+            return;
+        }
+        if (delay < 0 || delay > MOVE_MAX_DELAY_MS)
+        {
+            txEvent.println(F("ERR delay"));
+            return;
+        }
+
+        // The tokens are read, rxBuf is free again
+        scrambleMoves(seed, n, rxBuf, sizeof(rxBuf));
+        replyMoves(seqManager.startMoves(rxBuf, delay));
+        return;
+    }
+
+    // --- APPEND ---
+    if (strcmp(cmd, "APPEND") == 0)
+    {
+        // "APPEND" alone just closes the stream
+        bool more = tokenCount == 3 && strcmp(tokens[2], "+") == 0;
+        if (tokenCount > 2 && !more)
+        {
+            txEvent.println(F("ERR args"));
             return;
         }
 
-        int res = seqManager.startMoves(tokens[3], delay);
-        if (res == 0) Serial.println("OK");
-        else if (res == -1) Serial.println("ERR busy");
-        else if (res == -2) Serial.println("ERR format");
-        else Serial.println("ERR");
+        // Goes to whichever is streaming, a SEQ or a MOVE
+        const char* text = tokenCount > 1 ? tokens[1] : "";
+        int res = seqManager.appendSequence(text, more);
+        if (res == -1)
+            res = seqManager.appendMoves(text, more);
+        if (res == 0) txEvent.println(F("OK"));
+        else if (res == -1) txEvent.println(F("ERR no_stream"));
+        else if (res == -3) txEvent.println(F("ERR full"));
+        else txEvent.println(F("ERR"));
 
         return;
     }
@@ -139,43 +215,189 @@ void APILoop()
     {
         if (tokenCount == 1)
         {
-            Serial.println(seqManager.isBusy() ? "BUSY" : "IDLE");
+            txEvent.println(seqManager.isBusy() ? "BUSY" : "IDLE");
             return;
         }
 
         if (tokenCount != 2)
         {
-            Serial.println("ERR args");
+            txEvent.println(F("ERR args"));
             return;
         }
 
         ServoType servo;
         if (!parseServoType(tokens[1][0], servo))
         {
-            Serial.println("ERR servo_type");
+            txEvent.println(F("ERR servo_type"));
             return;
         }
 
         switch (servos[servo].getState())
         {
-            case STATE_R: Serial.println('R'); break;
-            case STATE_L: Serial.println('L'); break;
-            case STATE_C: Serial.println('C'); break;
-            case STATE_r: Serial.println('r'); break;
-            case STATE_l: Serial.println('l'); break;
-            default: Serial.println("ERR state"); break;
+            case STATE_R: txEvent.println('R'); break;
+            case STATE_L: txEvent.println('L'); break;
+            case STATE_C: txEvent.println('C'); break;
+            case STATE_r: txEvent.println('r'); break;
+            case STATE_l: txEvent.println('l'); break;
+            default: txEvent.println(F("ERR state")); break;
+        }
+        return;
+    }
+
+    // --- RESUME ---
+    if (strcmp(cmd, "RESUME") == 0)
+    {
+        bool stream = tokenCount == 2 && strcmp(tokens[1], "+") == 0;
+        bool query = tokenCount == 2 && strcmp(tokens[1], "?") == 0;
+        if (tokenCount > 1 && !stream && !query)
+        {
+            txEvent.println(F("ERR args"));
+            return;
+        }
+
+        if (query)
+        {
+            // RESUME <moves done> <orientation to start with> <moves left, the interrupted one first>
+            int done;
+            CubeOrientation startOrientation;
+            char interrupted;
+            const char* rest;
+            if (!seqManager.getCheckpoint(done, startOrientation, interrupted, rest))
+            {
+                txEvent.println(F("ERR nothing"));
+                return;
+            }
+            txEvent.print(F("RESUME "));
+            txEvent.print(done);
+            txEvent.print(' ');
+            txEvent.print(startOrientation == ORIENT_INVERT ? '1' : '0');
+            txEvent.print(' ');
+            if (interrupted)
+                txEvent.print(interrupted);
+            txEvent.println(interrupted || *rest ? rest : "-");
+            return;
+        }
+
+        int res = seqManager.resumeMoves(stream);
+        if (res == 0) txEvent.println(F("OK"));
+        else if (res == -1) txEvent.println(F("ERR busy"));
+        else if (res == -3) txEvent.println(F("ERR nothing"));
+        else txEvent.println(F("ERR"));
+
+        return;
+    }
+
+    // --- STATE ---
+    if (strcmp(cmd, "STATE") == 0)
+    {
+        if (tokenCount == 2)
+        {
+            if (seqManager.isBusy())
+            {
+                txEvent.println(F("ERR busy"));
+                return;
+            }
+            if (!seqManager.cube.setFacelets(tokens[1]))
+            {
+                txEvent.println(F("ERR facelets"));
+                return;
+            }
+            seqManager.cube.known = true;
+            seqManager.pendingMove = 0;
+            txEvent.println(F("OK"));
+            return;
+        }
+
+        if (tokenCount != 1)
+        {
+            txEvent.println(F("ERR args"));
+            return;
+        }
+
+        // STATE <facelets or ?> <orientation> <move that may or may not have happened, or ->
+        char facelets[55];
+        if (seqManager.cube.known)
+            seqManager.cube.getFacelets(facelets);
+        else
+            strcpy(facelets, "?");
+        txEvent.print(F("STATE "));
+        txEvent.print(facelets);
+        txEvent.print(' ');
+        txEvent.print(seqManager.orientation == ORIENT_INVERT ? '1' : '0');
+        txEvent.print(' ');
+        txEvent.println(seqManager.pendingMove ? seqManager.pendingMove : '-');
+        return;
+    }
+
+    // --- POWER ---
+    if (strcmp(cmd, "POWER") == 0)
+    {
+        // What the power model thinks, see Config.h. One line per servo: <servo> <% of the time travelling> <heat %>
+        unsigned long now = millis();
+        txVerbose.print(F("POWER "));
+        txVerbose.print(totalCurrentMa(now));
+        txVerbose.print(F("mA peak "));
+        txVerbose.print(powerStats.peakMa);
+        txVerbose.print(F("mA waits "));
+        txVerbose.print(powerStats.waits);
+        txVerbose.print(F(" relaxed "));
+        txVerbose.println(powerStats.relaxed);
+        static const char servoChars[] = "rRlLfFbB";    // In ServoType order
+        for (int i = 0; i < NUM_SERVOS; i++)
+        {
+            txVerbose.print(servoChars[i]);
+            txVerbose.print(' ');
+            txVerbose.print(servos[i].dutyPercent(now));
+            txVerbose.print(F("% "));
+            txVerbose.print(servos[i].heatPercent());
+            txVerbose.println(servos[i].isOverheated() ? "% hot" : "%");
+        }
+        return;
+    }
+
+    // --- DRYRUN ---
+    if (strcmp(cmd, "DRYRUN") == 0)
+    {
+        if (tokenCount == 1)
+        {
+            txEvent.println(servoDryRun ? "DRYRUN 1" : "DRYRUN 0");
+            return;
+        }
+
+        if (tokenCount != 2 || (strcmp(tokens[1], "0") != 0 && strcmp(tokens[1], "1") != 0))
+        {
+            txEvent.println(F("ERR args"));
+            return;
         }
+
+        if (seqManager.setDryRun(tokens[1][0] == '1') == 0) txEvent.println(F("OK"));
+        else txEvent.println(F("ERR busy"));
+        return;
+    }
+
+    // --- CPU ---
+    if (strcmp(cmd, "CPU") == 0)
+    {
+        // What tick() took for the current or last MOVE per finished move (all of it for a SEQ), the longest tick()
+        // and how many there were
+        int moves = seqManager.movesFinished();
+        txVerbose.print(F("CPU "));
+        txVerbose.print(moves > 0 ? seqManager.cpuUs / moves : seqManager.cpuUs);
+        txVerbose.print(F("us/move max "));
+        txVerbose.print(seqManager.cpuMaxUs);
+        txVerbose.print(F("us ticks "));
+        txVerbose.println(seqManager.cpuTicks);
         return;
     }
 
     // --- PING ---
     if (strcmp(cmd, "PING") == 0)
     {
-        Serial.println("PONG");
+        txEvent.println(F("PONG"));
         return;
     }
 
     // --- UNKNOWN ---
-    Serial.print("ERR cmd: ");
-    Serial.println(cmd);
+    txEvent.print(F("ERR cmd: "));
+    txEvent.println(cmd);
 }
@@ -2,6 +2,8 @@
 #include "MyServo.h"
 #include "SequenceManager.h"
 #include "API.h"
+#include "StageTimer.h"
+#include "TxQueue.h"
 
 void setup() {
     Serial.begin(9600);
@@ -10,6 +12,7 @@ void setup() {
 #if !CALIBRATE
     APISetup();        // Setup API if not in calibration mode
 #endif
+    stageTimerBegin();  // Does nothing until a sequence arms it
 }
 
 void loop() {
@@ -26,8 +29,9 @@ void loop() {
     int res = seqManager.tick();    // If ongoing sequence, keep going
     if (res < 0)
     {
-        Serial.print("SEQ ERR ");
-        Serial.println(res);
+        txEvent.print(F("SEQ ERR "));
+        txEvent.println(res);
     }
+    txDrain();  // Whatever fits in the serial buffer right now
 #endif
 }
@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// EEPROM layout of the servo calibrations.
+// This header is shared with the host tools (Host/Tools/CalTool.cpp), so keep it free of Arduino stuff.
+//
+// Layout, little endian, starting at CALSTORE_ADDR:
+//     CalStoreHeader  header
+//     CalRecord       records[CALSTORE_NUM_SERVOS]    (indexed by ServoType)
+// The CRC in the header covers the records only.
+//
+// Before the layout was versioned, the EEPROM held the 16 bit magic 0xCAFE at address 100
+// followed by raw ServoCal structs (L, R, C, CD) at address 102. That is "version 0" and it
+// is migrated automatically on startup, like every older version below.
+
+#define CALSTORE_ADDR 100
+#define CALSTORE_MAGIC 0xCA1B
+#define CALSTORE_VERSION 2
+#define CALSTORE_NUM_SERVOS 8
+
+#define CALSTORE_LEGACY_MAGIC 0xCAFE
+#define CALSTORE_LEGACY_DATA_ADDR 102
+
+// Used when there are no calibrations at all (fresh EEPROM)
+#define CALSTORE_DEFAULT_L_US 1000
+#define CALSTORE_DEFAULT_R_US 1500
+#define CALSTORE_DEFAULT_C_US 2000
+
+// Used when a record has no timing data yet (fresh or migrated EEPROM)
+#define CALSTORE_DEFAULT_SPEED 6        // Pulse microseconds per millisecond, around 0.1s per 60 degrees
+#define CALSTORE_DEFAULT_SETTLE_MS 30
+#define CALSTORE_DEFAULT_ACCEL 0        // No ramping, jump straight to the target like before version 2
+
+struct CalStoreHeader
+{
+    uint16_t magic;
+    uint8_t version;
+    uint8_t count;      // Number of records following the header
+    uint16_t crc;       // CRC-16/CCITT of the records
+};
+
+// Version 0 record, only used for migration
+struct CalRecordV0
+{
+    uint16_t L_us;
+    uint16_t R_us;
+    uint16_t C_us;
+    uint16_t CD_us;
+};
+
+// Version 1 record, travel speed and settle time added
+struct CalRecordV1
+{
+    uint16_t L_us;
+    uint16_t R_us;
+    uint16_t C_us;
+    uint16_t CD_us;
+    uint16_t speed;
+    uint16_t settleMs;
+};
+
+struct CalRecord
+{
+    uint16_t L_us;
+    uint16_t R_us;
+    uint16_t C_us;
+    uint16_t CD_us;
+    uint16_t speed;     // Travel speed in pulse microseconds per millisecond
+    uint16_t settleMs;  // How long the horn keeps wobbling after the pulse reached its target
+    uint16_t accel;     // Ramp acceleration, (pulse microseconds per millisecond) gained per second, 0 = no ramp
+};
+
+#define CALSTORE_RECORDS_ADDR (CALSTORE_ADDR + sizeof(CalStoreHeader))
+#define CALSTORE_RECORDS_SIZE (CALSTORE_NUM_SERVOS * sizeof(CalRecord))
+
+// Size of the records of an older version, for checking its CRC before migrating it
+inline size_t calStoreRecordsSize(int version)
+{
+    return CALSTORE_NUM_SERVOS * (version == 1 ? sizeof(CalRecordV1) : sizeof(CalRecord));
+}
+
+// CRC-16/CCITT (poly 0x1021, init 0xFFFF), one byte at a time so it can be fed straight from EEPROM.read()
+#define CALSTORE_CRC_INIT 0xFFFF
+
+inline uint16_t calStoreCrcUpdate(uint16_t crc, uint8_t data)
+{
+    crc ^= (uint16_t)data << 8;
+    for (int i = 0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    return crc;
+}
+
+inline uint16_t calStoreCrc(const uint8_t* data, size_t len)
+{
+    uint16_t crc = CALSTORE_CRC_INIT;
+    for (size_t i = 0; i < len; i++)
+        crc = calStoreCrcUpdate(crc, data[i]);
+    return crc;
+}
+
+// The records of a whole EEPROM image, for the host tools. Only the current layout (caltool restore writes
+// that, and the firmware migrates older ones when it starts), false for anything else
+inline bool calStoreReadImage(const uint8_t* image, CalRecord* records)
+{
+    const uint8_t* h = image + CALSTORE_ADDR;
+    if ((h[0] | h[1] << 8) != CALSTORE_MAGIC || h[2] != CALSTORE_VERSION || h[3] != CALSTORE_NUM_SERVOS)
+        return false;
+    if (calStoreCrc(image + CALSTORE_RECORDS_ADDR, CALSTORE_RECORDS_SIZE) != (h[4] | h[5] << 8))
+        return false;
+
+    // Little endian whatever the host is
+    const uint8_t* p = image + CALSTORE_RECORDS_ADDR;
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+    {
+        uint16_t v[7];
+        for (int j = 0; j < 7; j++, p += 2)
+            v[j] = p[0] | p[1] << 8;
+        records[i] = {v[0], v[1], v[2], v[3], v[4], v[5], v[6]};
+    }
+    return true;
+}
@@ -0,0 +1,378 @@
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "MyServo.h"
+#include "Calibrate.h"
+#include "Config.h"
+#include "CalStore.h"
+
+// Select one servo and calibrate one at a time
+static int selectedServo = 0;
+static ServoState mode = STATE_C;
+static const int step = 5;
+
+static ServoCal recordToCal(const CalRecord& rec)
+{
+    ServoCal cal = {rec.L_us, rec.R_us, rec.C_us, rec.CD_us, rec.speed, rec.settleMs, rec.accel};
+    return cal;
+}
+
+static CalRecord calToRecord(const ServoCal& cal)
+{
+    CalRecord rec = {(uint16_t)cal.L_us, (uint16_t)cal.R_us, (uint16_t)cal.C_us, (uint16_t)cal.CD_us,
+                     (uint16_t)cal.speed, (uint16_t)cal.settleMs, (uint16_t)cal.accel};
+    return rec;
+}
+
+static CalRecord defaultRecord()
+{
+    CalRecord rec = {CALSTORE_DEFAULT_L_US, CALSTORE_DEFAULT_R_US, CALSTORE_DEFAULT_C_US, 0,
+                     CALSTORE_DEFAULT_SPEED, CALSTORE_DEFAULT_SETTLE_MS, CALSTORE_DEFAULT_ACCEL};
+    return rec;
+}
+
+// Returns the layout version found in EEPROM, 0 for the legacy layout, -1 if there is nothing valid
+static int storedVersion()
+{
+    CalStoreHeader header;
+    EEPROM.get(CALSTORE_ADDR, header);
+
+    if (header.magic == CALSTORE_LEGACY_MAGIC)
+        return 0;
+    if (header.magic != CALSTORE_MAGIC || header.version < 1 || header.version > CALSTORE_VERSION || header.count != CALSTORE_NUM_SERVOS)
+        return -1;
+
+    uint16_t crc = CALSTORE_CRC_INIT;
+    for (unsigned int i = 0; i < calStoreRecordsSize(header.version); i++)
+        crc = calStoreCrcUpdate(crc, EEPROM.read(CALSTORE_RECORDS_ADDR + i));
+
+    return crc == header.crc ? header.version : -1;
+}
+
+// Reads a record of any known version, filling in defaults for whatever that version didn't have
+static CalRecord readRecord(int version, int index)
+{
+    CalRecord rec = defaultRecord();
+    if (version == 0)
+    {
+        CalRecordV0 old;
+        EEPROM.get(CALSTORE_LEGACY_DATA_ADDR + index * sizeof(CalRecordV0), old);
+        rec.L_us = old.L_us;
+        rec.R_us = old.R_us;
+        rec.C_us = old.C_us;
+        rec.CD_us = old.CD_us;
+    }
+    else if (version == 1)
+    {
+        CalRecordV1 old;
+        EEPROM.get(CALSTORE_RECORDS_ADDR + index * sizeof(CalRecordV1), old);
+        rec.L_us = old.L_us;
+        rec.R_us = old.R_us;
+        rec.C_us = old.C_us;
+        rec.CD_us = old.CD_us;
+        rec.speed = old.speed;
+        rec.settleMs = old.settleMs;
+    }
+    else if (version == CALSTORE_VERSION)
+    {
+        EEPROM.get(CALSTORE_RECORDS_ADDR + index * sizeof(CalRecord), rec);
+    }
+    return rec;
+}
+
+static void writeStore(const CalRecord* records)
+{
+    CalStoreHeader header;
+    header.magic = CALSTORE_MAGIC;
+    header.version = CALSTORE_VERSION;
+    header.count = CALSTORE_NUM_SERVOS;
+    header.crc = calStoreCrc((const uint8_t*)records, CALSTORE_RECORDS_SIZE);
+
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+        EEPROM.put(CALSTORE_RECORDS_ADDR + i * sizeof(CalRecord), records[i]);
+    EEPROM.put(CALSTORE_ADDR, header);  // Header last, so a reset halfway leaves an invalid CRC behind
+}
+
+void initEEPROM()
+{
+    int version = storedVersion();
+    if (version == CALSTORE_VERSION)
+        return;
+
+    // Older layouts are migrated, anything else (fresh chip, bad CRC) gets defaults
+    // The old data overlaps the new header and records, so read everything before writing
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+        records[i] = readRecord(version, i);
+
+    if (version >= 0)
+        Serial.println(F("Migrating calibrations to the new EEPROM layout"));
+    else
+        Serial.println(F("No valid calibrations in EEPROM, writing defaults"));
+
+    writeStore(records);
+}
+
+ServoCal readCalibration(ServoType type)
+{
+    // Type is just an enum from 0 to NUM_SERVOS-1, so we can use it directly as index
+    // This runs before setup() (servos are global), so it must cope with an old or empty EEPROM too
+    return recordToCal(readRecord(storedVersion(), type));
+}
+
+void writeAllCalibrations()
+{
+    Serial.println(F("Writing all calibrations to EEPROM..."));
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        records[i] = calToRecord(servos[i].getCalibration());
+    }
+    writeStore(records);
+    Serial.println(F("Done writing calibrations, please set #define CALIBRATE false and re-upload the sketch."));
+}
+
+// Print status of selected servo
+void printStatus()
+{
+    Serial.print(F("Selected Servo: "));
+    Serial.print(selectedServo);
+    Serial.print(F(" ("));
+    char buffer[20];
+    servoTypeToString(servos[selectedServo].getType(), buffer, sizeof(buffer));
+    Serial.print(buffer);
+    Serial.print(F(")"));
+    Serial.print(F(" | Mode: "));
+    ServoCal cal = servos[selectedServo].getCalibration();
+    switch (mode)
+    {
+    case STATE_C:
+        Serial.print(F("CENTER"));
+        Serial.print(F(" | Center us: "));
+        Serial.print(cal.C_us);
+        Serial.print(F(" | Deviation: "));
+        Serial.print(cal.CD_us);
+        Serial.println(F(" us"));
+        Serial.print(F(" | Pulse: "));
+        Serial.print(servos[selectedServo].pulseWidth());
+        break;
+    case STATE_L:
+        Serial.print(F("LEFT"));
+        Serial.print(F(" | Pulse: "));
+        Serial.print(servos[selectedServo].pulseWidth());
+        Serial.println(F(" us"));
+        break;
+    case STATE_R:
+        Serial.print(F("RIGHT"));
+        Serial.print(F(" | Pulse: "));
+        Serial.print(servos[selectedServo].pulseWidth());
+        Serial.println(F(" us"));
+        break;
+    }
+    Serial.print(F(" | Speed: "));
+    Serial.print(cal.speed);
+    Serial.print(F(" us/ms | Settle: "));
+    Serial.print(cal.settleMs);
+    Serial.print(F(" ms | Accel: "));
+    Serial.print(cal.accel);
+    Serial.println(F(" us/ms/s"));
+}
+
+void printCalibrations()
+{
+    char buffer[20];
+
+    Serial.println();
+    Serial.println(F("Idx Pin Type     L(us) R(us) C(us) Dev(us) Speed(us/ms) Settle(ms) Accel(us/ms/s)"));
+    Serial.println(F("--- --- -------- ----- ----- ----- ------- ------------ ---------- --------------"));
+
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        ServoCal cal = servos[i].getCalibration();
+
+        Serial.print(i);
+        Serial.print(F("   "));
+        Serial.print(servos[i].getPin());
+        Serial.print(F("   "));
+
+        servoTypeToString(servos[i].getType(), buffer, sizeof(buffer));
+        Serial.print(buffer);
+        Serial.print(F(" "));
+
+        Serial.print(cal.L_us);
+        Serial.print(F("  "));
+        Serial.print(cal.R_us);
+        Serial.print(F("  "));
+        Serial.print(cal.C_us);
+        Serial.print(F("  "));
+        Serial.print(cal.CD_us);
+        Serial.print(F("  "));
+        Serial.print(cal.speed);
+        Serial.print(F("  "));
+        Serial.print(cal.settleMs);
+        Serial.print(F("  "));
+        Serial.println(cal.accel);
+    }
+
+    Serial.println();
+}
+
+
+void printHelp()
+{
+    Serial.println(F("Servo calibration tool commands:"));
+    Serial.println(F("0-7 : select servo"));
+    Serial.println(F("c   : set state CENTER to calibrate center"));
+    Serial.println(F("l   : set state LEFT to calibrate left"));
+    Serial.println(F("r   : set state RIGHT to calibrate right"));
+    Serial.println(F("+/- : increase/decrease step size"));
+    Serial.println(F("*// : increase/decrease step size * 10"));
+    Serial.println(F("</> : increase/decrease center deviation (spinners only)"));
+    Serial.println(F("v/V : decrease/increase travel speed (us per ms)"));
+    Serial.println(F("t/T : decrease/increase settle time"));
+    Serial.println(F("a/A : decrease/increase ramp acceleration (0 = no ramp)"));
+    Serial.println(F("i   : import a row printed by p (idx L R C Dev Speed Settle Accel)"));
+    Serial.println(F("p   : Print current calibration values"));
+    Serial.println(F("w   : Write calibration to EEPROM"));
+    Serial.println();
+}
+
+void calibrateSetup()
+{
+    initEEPROM();
+
+#if CALIBRATE // Only setup if in calibration mode, otherwise this is not your concern
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        pinMode(servos[i].getPin(), OUTPUT);
+        servos[i].setState(STATE_C);
+    }
+    printStatus();
+#endif
+}
+
+void calibrateLoop()
+{
+    updateAllServos(millis());  // Ramped servos still need to get to where we sent them
+
+    if (!Serial.available())
+        return;
+
+    char c = Serial.read();
+
+    if (c == 'h')
+    {
+        printHelp();
+    }
+    else if (c >= '0' && c <= '7')
+    {
+        selectedServo = c - '0';
+        printStatus();
+    }
+    else if (c == 'c')
+    {
+        mode = STATE_C;
+        servos[selectedServo].setState(STATE_C);
+        printStatus();
+    }
+    else if (c == 'l')
+    {
+        mode = STATE_L;
+        servos[selectedServo].setState(STATE_L);
+        printStatus();
+    }
+    else if (c == 'r')
+    {
+        mode = STATE_R;
+        servos[selectedServo].setState(STATE_R);
+        printStatus();
+    }
+    else if (c == '+')
+    {
+        servos[selectedServo].adjustCalibration(step);
+        printStatus();
+    }
+    else if (c == '-')
+    {
+        servos[selectedServo].adjustCalibration(-step);
+        printStatus();
+    }
+    else if (c == '*')
+    {
+        servos[selectedServo].adjustCalibration(step * 10);
+        printStatus();
+    }
+    else if (c == '/')
+    {
+        servos[selectedServo].adjustCalibration(-step * 10);
+        printStatus();
+    }
+    else if (c == '>')
+    {
+        servos[selectedServo].adjustDeviation(step);
+        printStatus();
+    }
+    else if (c == '<')
+    {
+        servos[selectedServo].adjustDeviation(-step);
+        printStatus();
+    }
+    else if (c == 'v')
+    {
+        servos[selectedServo].adjustTiming(-1, 0, 0);
+        printStatus();
+    }
+    else if (c == 'V')
+    {
+        servos[selectedServo].adjustTiming(1, 0, 0);
+        printStatus();
+    }
+    else if (c == 't')
+    {
+        servos[selectedServo].adjustTiming(0, -step, 0);
+        printStatus();
+    }
+    else if (c == 'T')
+    {
+        servos[selectedServo].adjustTiming(0, step, 0);
+        printStatus();
+    }
+    else if (c == 'a')
+    {
+        servos[selectedServo].adjustTiming(0, 0, -step * 10);
+        printStatus();
+    }
+    else if (c == 'A')
+    {
+        servos[selectedServo].adjustTiming(0, 0, step * 10);
+        printStatus();
+    }
+    else if (c == 'i')
+    {
+        // Same numbers as a row of the p table, minus pin and type. Host/Tools/CalTool.cpp generates these.
+        int idx = Serial.parseInt();
+        ServoCal cal;
+        cal.L_us = Serial.parseInt();
+        cal.R_us = Serial.parseInt();
+        cal.C_us = Serial.parseInt();
+        cal.CD_us = Serial.parseInt();
+        cal.speed = Serial.parseInt();
+        cal.settleMs = Serial.parseInt();
+        cal.accel = Serial.parseInt();
+        if (idx < 0 || idx >= NUM_SERVOS)
+        {
+            Serial.println(F("Bad servo index"));
+            return;
+        }
+        servos[idx].setCalibration(cal);
+        selectedServo = idx;
+        printStatus();
+    }
+    else if (c == 'p')
+    {
+        printCalibrations();
+    }
+    else if (c == 'w')
+    {
+        writeAllCalibrations();
+    }
+}
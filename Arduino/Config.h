@@ -26,3 +26,46 @@
 // (Realistically, we will almost never find a perfect 20-move solution, unless its an easy scramble)
 // But, based on real testing, 32 moves were exceeded, so make it larger.
 #define MOVE_BUFFER_SIZE 64
+
+// Longest delay MOVE and SCRAMBLE take between stages. Nothing needs more than a few hundred ms.
+#define MOVE_MAX_DELAY_MS 30000
+// That delay as it goes into the sequence (moveDelayToken() in MoveCore.h), big enough for any int
+#define MOVE_DELAY_TOKEN_SIZE 12
+
+// How often (in ms) SequenceManager::tick() advances the servo motion profiles.
+// Only matters for servos calibrated with a ramp acceleration, the others jump straight to their target.
+#define MOTION_TICK_MS 5
+
+// Power model of the servos, they all share one 5V supply (see the Circuit section in README.md).
+// Rough numbers for MG90S-size servos, measure yours if you want it tighter.
+// Timeline::dispatch() holds a command back while it would take the total over POWER_BUDGET_MA,
+// anything that fits goes out at once like before.
+#define POWER_BUDGET_MA 2700        // What all servos may draw together, a 3A supply with some margin
+#define SERVO_IDLE_MA 10            // Holding still
+#define SERVO_MOVING_MA 400         // Travelling to a new position, with the cube to push around
+#define SERVO_STALL_MA 600          // Slider at STATE_L, pressing into the cube
+
+// Sliders at STATE_L are stalled and heat up. They can do that for STALL_HEAT_MAX_MS in one go,
+// and cool down STALL_COOL_DIV times slower than they heat up (so a third of the time at L is fine forever).
+// A hot slider only goes to L again once it cooled down to half that, and is let go to C if the robot is idle.
+#define STALL_HEAT_MAX_MS 15000
+#define STALL_COOL_DIV 2
+
+// If true, the stage after a delay in a sequence is fired by a timer interrupt (StageTimer.h) at the exact
+// microsecond it is due, instead of by loop() whenever it gets around to it. Only stages of commands without
+// @ dependencies, up to STAGE_MAX_COMMANDS of them, the rest goes through loop() like before.
+#define STAGE_TIMER true
+#define STAGE_MAX_COMMANDS 8
+
+// How many commands each servo can have queued in SequenceManager (8 servos * 6 bytes each).
+// Parsing a sequence just pauses while a servo's queue is full, so this only limits how far ahead it looks.
+// A command only ever waits for ones parsed before it, and cubebench times came out the same with 2, 3 and 4.
+#define TIMELINE_QUEUE_DEPTH 2
+
+// Serial output queues (TxQueue.h), so printing never makes loop() wait for the 9600 baud port.
+// Events (replies, BUSY/IDLE) go out as soon as the hardware buffer (64 bytes) has room, so with it empty even
+// a STATE or RESUME ? (about 80 characters) fits. Telemetry (MOVED) keeps the newest lines, verbose text (HELP,
+// POWER) gets what is left.
+#define TX_EVENT_SIZE 64
+#define TX_TELEMETRY_SIZE 24
+#define TX_VERBOSE_SIZE 48
@@ -0,0 +1,208 @@
+#include "CubeState.h"
+#include <Arduino.h>
+#include <string.h>
+
+static const char faceChars[] = "URFDLB";
+
+// Clockwise quarter turn of each face, what ends up at each position: cubie | twist << 3 and cubie | flip << 4.
+// Same as CubieCube::basicMove() on the host.
+static const uint8_t turnCorners[6][8] PROGMEM = {
+    {3, 0, 1, 2, 4, 5, 6, 7},                                           // U
+    {4 | 2 << 3, 1, 2, 0 | 1 << 3, 7 | 1 << 3, 5, 6, 3 | 2 << 3},       // R
+    {1 | 1 << 3, 5 | 2 << 3, 2, 3, 0 | 2 << 3, 4 | 1 << 3, 6, 7},       // F
+    {0, 1, 2, 3, 5, 6, 7, 4},                                           // D
+    {0, 2 | 1 << 3, 6 | 2 << 3, 3, 4, 1 | 2 << 3, 5 | 1 << 3, 7},       // L
+    {0, 1, 3 | 1 << 3, 7 | 2 << 3, 4, 5, 2 | 2 << 3, 6 | 1 << 3},       // B
+};
+static const uint8_t turnEdges[6][12] PROGMEM = {
+    {3, 0, 1, 2, 4, 5, 6, 7, 8, 9, 10, 11},                             // U
+    {8, 1, 2, 3, 11, 5, 6, 7, 4, 9, 10, 0},                             // R
+    {0, 9 | 16, 2, 3, 4, 8 | 16, 6, 7, 1 | 16, 5 | 16, 10, 11},         // F
+    {0, 1, 2, 3, 5, 6, 7, 4, 8, 9, 10, 11},                             // D
+    {0, 1, 10, 3, 4, 5, 9, 7, 8, 2, 6, 11},                             // L
+    {0, 1, 2, 11 | 16, 4, 5, 6, 10 | 16, 8, 9, 3 | 16, 7 | 16},         // B
+};
+
+// Facelets of each corner/edge position, starting with the U or D facelet (or F/B for the slice edges).
+// The colors of a cubie are the faces of the facelets at its own home position.
+static const uint8_t cornerFacelet[8][3] PROGMEM = {
+    {8, 9, 20}, {6, 18, 38}, {0, 36, 47}, {2, 45, 11},
+    {29, 26, 15}, {27, 44, 24}, {33, 53, 42}, {35, 17, 51}
+};
+static const uint8_t edgeFacelet[12][2] PROGMEM = {
+    {5, 10}, {7, 19}, {3, 37}, {1, 46}, {32, 16}, {28, 25},
+    {30, 43}, {34, 52}, {23, 12}, {21, 41}, {50, 39}, {48, 14}
+};
+
+static uint8_t cornerFace(uint8_t corner, uint8_t n) { return pgm_read_byte(&cornerFacelet[corner][n]) / 9; }
+static uint8_t edgeFace(uint8_t edge, uint8_t n) { return pgm_read_byte(&edgeFacelet[edge][n]) / 9; }
+
+// Face number of the color at a facelet, the string is checked already
+static uint8_t faceAt(const char* facelets, uint8_t pos)
+{
+    return strchr(faceChars, facelets[pos]) - faceChars;
+}
+
+static uint8_t parity(const uint8_t* cubies, uint8_t n, uint8_t mask)
+{
+    uint8_t s = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        for (uint8_t j = 0; j < i; j++)
+        {
+            if ((cubies[j] & mask) > (cubies[i] & mask))
+                s++;
+        }
+    }
+    return s & 1;
+}
+
+void CubeState::setSolved()
+{
+    for (uint8_t i = 0; i < 8; i++)
+        corners[i] = i;
+    for (uint8_t i = 0; i < 12; i++)
+        edges[i] = i;
+}
+
+bool CubeState::isSolved() const
+{
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (corners[i] != i)
+            return false;
+    }
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        if (edges[i] != i)
+            return false;
+    }
+    return true;
+}
+
+void CubeState::turnFace(uint8_t face)
+{
+    uint8_t c[8], e[12];
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t t = pgm_read_byte(&turnCorners[face][i]);
+        uint8_t from = corners[t & 7];
+        c[i] = (from & 7) | (((from >> 3) + (t >> 3)) % 3) << 3;
+    }
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        uint8_t t = pgm_read_byte(&turnEdges[face][i]);
+        e[i] = edges[t & 15] ^ (t & 16);
+    }
+    memcpy(corners, c, sizeof(corners));
+    memcpy(edges, e, sizeof(edges));
+}
+
+void CubeState::turn(char moveChar)
+{
+    const char* f = strchr(faceChars, toupper(moveChar));
+    if (!f || *f == '\0')
+        return;
+
+    // Counter-clockwise is three clockwise, a few microseconds once per move
+    uint8_t times = isupper(moveChar) ? 1 : 3;
+    while (times--)
+        turnFace(f - faceChars);
+}
+
+void CubeState::getFacelets(char* out) const
+{
+    for (uint8_t i = 0; i < 6; i++)
+        out[9 * i + 4] = faceChars[i];
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t cubie = corners[i] & 7, twist = corners[i] >> 3;
+        for (uint8_t n = 0; n < 3; n++)
+            out[pgm_read_byte(&cornerFacelet[i][(n + twist) % 3])] = faceChars[cornerFace(cubie, n)];
+    }
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        uint8_t cubie = edges[i] & 15, flip = edges[i] >> 4;
+        for (uint8_t n = 0; n < 2; n++)
+            out[pgm_read_byte(&edgeFacelet[i][(n + flip) % 2])] = faceChars[edgeFace(cubie, n)];
+    }
+    out[54] = '\0';
+}
+
+bool CubeState::setFacelets(const char* facelets)
+{
+    if (strlen(facelets) != 54)
+        return false;
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        if (facelets[9 * i + 4] != faceChars[i])
+            return false;   // Centers must be in URFDLB order
+    }
+
+    for (uint8_t i = 0; i < 54; i++)
+    {
+        if (!strchr(faceChars, facelets[i]))
+            return false;
+    }
+
+    uint8_t c[8], e[12];
+    uint8_t seenCorners = 0, twistSum = 0;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t twist;
+        for (twist = 0; twist < 3; twist++)
+        {
+            uint8_t face = faceAt(facelets, pgm_read_byte(&cornerFacelet[i][twist]));
+            if (face == 0 || face == 3)
+                break;  // U or D
+        }
+        if (twist == 3)
+            return false;
+        uint8_t col1 = faceAt(facelets, pgm_read_byte(&cornerFacelet[i][(twist + 1) % 3]));
+        uint8_t col2 = faceAt(facelets, pgm_read_byte(&cornerFacelet[i][(twist + 2) % 3]));
+        uint8_t j;
+        for (j = 0; j < 8; j++)
+        {
+            if (col1 == cornerFace(j, 1) && col2 == cornerFace(j, 2) &&
+                faceAt(facelets, pgm_read_byte(&cornerFacelet[i][twist])) == cornerFace(j, 0))
+                break;
+        }
+        if (j == 8 || (seenCorners & (1 << j)))
+            return false;
+        seenCorners |= 1 << j;
+        twistSum += twist;
+        c[i] = j | twist << 3;
+    }
+
+    uint16_t seenEdges = 0;
+    uint8_t flipSum = 0;
+    for (uint8_t i = 0; i < 12; i++)
+    {
+        uint8_t a = faceAt(facelets, pgm_read_byte(&edgeFacelet[i][0]));
+        uint8_t b = faceAt(facelets, pgm_read_byte(&edgeFacelet[i][1]));
+        uint8_t j, flip = 0;
+        for (j = 0; j < 12; j++)
+        {
+            if (a == edgeFace(j, 0) && b == edgeFace(j, 1))
+                break;
+            if (a == edgeFace(j, 1) && b == edgeFace(j, 0))
+            {
+                flip = 1;
+                break;
+            }
+        }
+        if (j == 12 || (seenEdges & (1 << j)))
+            return false;
+        seenEdges |= 1 << j;
+        flipSum += flip;
+        e[i] = j | flip << 4;
+    }
+
+    // Twisted corner, flipped edge or two swapped pieces: nobody turned that
+    if (twistSum % 3 != 0 || flipSum % 2 != 0 || parity(c, 8, 7) != parity(e, 12, 15))
+        return false;
+
+    memcpy(corners, c, sizeof(corners));
+    memcpy(edges, e, sizeof(edges));
+    return true;
+}
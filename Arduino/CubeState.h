@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+
+// What the cube looks like, as far as the firmware knows, so the host can pick up from there after a
+// cancelled or failed MOVE instead of scanning the cube again (STATE command).
+//
+// Cubie level, same numbering as Host/Solver/CubieCube.h (Kociemba's):
+//     corners URF UFL ULB UBR DFR DLF DBL DRB, each byte is cubie | twist << 3
+//     edges   UR UF UL UB DR DF DL DB FR FL BL BR, each byte is cubie | flip << 4
+// That's 20 bytes of RAM, the move and facelet tables are in flash.
+// Facelet strings are 54 characters U1..U9 R1..R9 F1..F9 D1..D9 L1..L9 B1..B9, like the app and the host use.
+//
+// Moves are in the cube's own frame, like MOVE: flipping the cube around (appendRotateCube() in MoveCore.h)
+// doesn't change which face is U, it only changes SequenceManager::orientation.
+class CubeState
+{
+public:
+    CubeState() { setSolved(); }
+
+    void setSolved();
+
+    // Parse 54 facelets. Returns false (and keeps the old state) if it isn't a cube you can get to by turning faces
+    bool setFacelets(const char* facelets);
+
+    // Writes 54 facelets and a terminating null, out must hold 55 chars
+    void getFacelets(char* out) const;
+
+    // One MOVE character: URFDLB clockwise, lowercase counter-clockwise. Anything else does nothing
+    void turn(char moveChar);
+
+    bool isSolved() const;
+
+    bool known = false;     // False until the host tells us (STATE <facelets>), and after a SEQ moved things around
+
+private:
+    uint8_t corners[8];
+    uint8_t edges[12];
+
+    void turnFace(uint8_t face);
+};
@@ -0,0 +1,432 @@
+#pragma once
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Config.h"
+#include "Types.h"
+
+// The templates stay in flash on the nano, where RAM is 2kB, and are read a byte at a time from there
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define MOVE_PROGMEM PROGMEM
+#define moveTemplateChar(p) ((char)pgm_read_byte(p))
+#else
+#define MOVE_PROGMEM
+#define moveTemplateChar(p) (*(p))
+#endif
+
+// How a MOVE turns into servo commands: which orientation each face needs, the templates that flip the cube
+// and turn a face, how long the robot takes for them, the "U R2 F'" notation the solvers print, and the
+// scrambles SCRAMBLE makes.
+// This header is shared with the host tools (Host/Solver/ScheduleCompiler.cpp) and the app (through
+// CubeSolver/app/src/main/jni/MoveCoreJni.cpp), so everything that plans for the robot expands moves exactly
+// like the firmware does. Keep it header only and free of Arduino stuff and the heap.
+//
+// The append functions add to a null-terminated string in a buffer of size bytes. They return false if a move
+// isn't one, or if it didn't fit, then the string stops before the part that didn't and the orientation
+// may be off.
+
+// The spinner that turns a face ('l', 'r', 'f' or 'b'), 0 if the character isn't a move.
+// U and D are on the left and right spinners once the cube is inverted, L and R when it's normal
+static inline char moveSpinner(char moveChar)
+{
+    switch (toupper(moveChar))
+    {
+    case 'U': case 'L': return 'l';
+    case 'D': case 'R': return 'r';
+    case 'F': return 'f';
+    case 'B': return 'b';
+    default: return 0;
+    }
+}
+
+// The orientation the cube has to be in for the move, -1 for F and B, they can be reached either way
+static inline int moveNeedsOrientation(char moveChar)
+{
+    switch (toupper(moveChar))
+    {
+    case 'U': case 'D': return ORIENT_INVERT;    // Up face must be on right or left to access it
+    case 'L': case 'R': return ORIENT_NORMAL;
+    default: return -1;
+    }
+}
+
+// After an snprintf() of n characters at used, false if they didn't all fit
+static inline bool moveCoreAppend(char* out, size_t size, size_t& used, int n)
+{
+    if (n < 0 || used + n >= size)
+    {
+        out[used] = '\0';
+        return false;
+    }
+    used += n;
+    return true;
+}
+
+// ---- Templates ----
+// A face turn and a flip of the cube as SEQ strings with placeholders. cubetpl (Host/Tools/TemplateSearch.cpp)
+// looks for faster ones on a model of the grippers and prints this block, to paste over it.
+//   Face turn: s is the spinner of the face and S its slider, d the way it turns the face (R clockwise,
+//              L counter-clockwise) and e the other way
+//   Flip:      x is the way the front spinner turns the cube over (R to INVERT, L back to NORMAL) and y the other way
+//   |          Ends a stage, the MOVE delay goes there
+// The _deps ones are for MOVE 0: every command only waits for the servos it needs (@), W for all of them.
+// A turn ends with all sliders and spinners at C, a flip may leave its last stage to go with the turn after it
+
+// TEMPLATES BEGIN
+static const char moveTurnTemplate[] MOVE_PROGMEM =
+    "sd|"                       // Turn the face
+    "SR|"                       // Release it
+    "sCsC|"                     // Spinner to true center (twice, no gap compensation)
+    "SC|";                      // Slider back
+
+static const char moveTurnTemplateDeps[] MOVE_PROGMEM =
+    "sd@SC"                     // Turn the face once its slider holds it
+    "SR@sd"                     // Release once turned
+    "sC@SRsC"                   // Spinner to true center once released
+    "SC@sC"                     // Slider back
+    "W";                        // The next move needs the whole cube held again
+
+// The first stage sends RIGHT and LEFT to grab together with FRONT and BACK letting go. On the gripper model
+// (cubetpl) the cube drops if FR or BR lands before RL and LL, the robots have run it like this all along though.
+// cubetpl prints a version with "RLLL|" as a stage of its own (a flip is one stage longer then, see
+// ROBOT_STAGES_PER_FLIP and the fallback in the app's ScanTab.kt), try that on a robot before swapping it in
+static const char moveFlipTemplate[] MOVE_PROGMEM =
+    "RLLL"                      // RIGHT and LEFT grab
+    "FRBR|"                     // FRONT and BACK release
+    "fxby|"                     // Turn the cube
+    "FLBL|"                     // FRONT and BACK grab
+    "RRLR|"                     // RIGHT and LEFT release
+    "fCfCbCbC|"                 // front and back spin to true center
+    "RCLC|"                     // RIGHT and LEFT sliders go back
+    "FCBC";                     // Relax FRONT and BACK, they don't need to grab anymore
+
+static const char moveFlipTemplateDeps[] MOVE_PROGMEM =
+    "RLLL"                      // RIGHT and LEFT grab
+    "FR@RL@LLBR@RL@LL"          // FRONT and BACK release once both grab
+    "fx@FRby@BR"                // Each spinner turns as soon as its own slider is out
+    "FL@fxBL@by"                // and grabs again as soon as it has turned
+    "RR@FL@BLLR@FL@BL"          // RIGHT and LEFT release once FRONT and BACK both grab
+    "fC@RR@LRfCbC@RR@LRbC"      // Turn the cube, spinners to true center
+    "RC@fC@bCLC@fC@bC"          // RIGHT and LEFT sliders go back
+    "FC@RC@LCBC@RC@LC";         // Relax FRONT and BACK
+// TEMPLATES END
+
+// Add a template (one of the above, read with moveTemplateChar()): every character in from becomes the one at
+// the same place in to, | becomes delayToken (nothing if it's null)
+static inline bool appendTemplate(char* out, size_t size, const char* tpl, const char* from, const char* to,
+                                  const char* delayToken)
+{
+    size_t used = strlen(out);
+    for (char c; (c = moveTemplateChar(tpl)) != '\0'; tpl++)
+    {
+        if (c == '|')
+        {
+            if (delayToken && !moveCoreAppend(out, size, used, snprintf(out + used, size - used, "%s", delayToken)))
+                return false;
+            continue;
+        }
+        const char* placeholder = strchr(from, c);
+        if (!moveCoreAppend(out, size, used, snprintf(out + used, size - used, "%c",
+                                                      placeholder ? to[placeholder - from] : c)))
+            return false;
+    }
+    return true;
+}
+
+// Flip the cube over to newOrientation, nothing if it is there already. delayToken goes after every stage,
+// the MOVE delay or "W"
+static inline bool appendRotateCube(char* out, size_t size, CubeOrientation& orientation, CubeOrientation newOrientation,
+                                    const char* delayToken)
+{
+    if (orientation == newOrientation)
+        return true;
+
+    const char* turns = newOrientation == ORIENT_INVERT ? "RL" : "LR";     // Front spins right, back left when inverting
+    if (!appendTemplate(out, size, moveFlipTemplate, "xy", turns, delayToken))
+        return false;
+    orientation = newOrientation;
+    return true;
+}
+
+// Same flip for MOVE 0. Instead of a fixed delay between stages, each command only waits for the servos it
+// actually needs, so a slider that is done early doesn't wait for the slowest servo of its stage
+static inline bool appendRotateCubeDeps(char* out, size_t size, CubeOrientation& orientation, CubeOrientation newOrientation)
+{
+    if (orientation == newOrientation)
+        return true;
+
+    const char* turns = newOrientation == ORIENT_INVERT ? "RL" : "LR";
+    if (!appendTemplate(out, size, moveFlipTemplateDeps, "xy", turns, nullptr))
+        return false;
+    orientation = newOrientation;
+    return true;
+}
+
+// The placeholders of a face turn for moveChar, see the templates
+static inline void moveTurnPlaceholders(char moveChar, char* to)
+{
+    to[0] = moveSpinner(moveChar);
+    to[1] = toupper(to[0]);
+    to[2] = isupper(moveChar) ? 'R' : 'L';
+    to[3] = isupper(moveChar) ? 'L' : 'R';
+    to[4] = '\0';
+}
+
+// The delay of a MOVE as it goes after every stage, "W" for 0. out holds MOVE_DELAY_TOKEN_SIZE bytes
+static inline void moveDelayToken(char* out, int delayMs)
+{
+    if (delayMs > 0)
+        snprintf(out, MOVE_DELAY_TOKEN_SIZE, "%d", delayMs);
+    else
+        strcpy(out, "W");
+}
+
+// One move of a MOVE with a delay: flip the cube if the face needs it, then turn the face and let go of it
+static inline bool appendMove(char* out, size_t size, CubeOrientation& orientation, char moveChar, const char* delayToken)
+{
+    if (!moveSpinner(moveChar))
+        return false;
+    int needed = moveNeedsOrientation(moveChar);
+    if (needed >= 0 && !appendRotateCube(out, size, orientation, (CubeOrientation)needed, delayToken))
+        return false;
+
+    char to[5];
+    moveTurnPlaceholders(moveChar, to);
+    return appendTemplate(out, size, moveTurnTemplate, "sSde", to, delayToken);
+}
+
+// The same for MOVE 0, every command waits for what it needs, and at the end for all servos (W)
+static inline bool appendMoveDeps(char* out, size_t size, CubeOrientation& orientation, char moveChar)
+{
+    if (!moveSpinner(moveChar))
+        return false;
+    int needed = moveNeedsOrientation(moveChar);
+    if (needed >= 0 && !appendRotateCubeDeps(out, size, orientation, (CubeOrientation)needed))
+        return false;
+
+    char to[5];
+    moveTurnPlaceholders(moveChar, to);
+    return appendTemplate(out, size, moveTurnTemplateDeps, "sSde", to, nullptr);
+}
+
+// "U R2 F' B2'" -> "URRfbb", what MOVE takes: one character per quarter turn, lowercase counter-clockwise.
+// Spaces between moves are optional. False on anything else
+static inline bool parseNotation(const char* text, char* out, size_t size)
+{
+    size_t used = 0;
+    while (*text)
+    {
+        if (*text == ' ')
+        {
+            text++;
+            continue;
+        }
+        if (!moveSpinner(*text) || !isupper(*text))
+            return false;
+        char face = *text++;
+        int turns = 1;
+        if (*text == '2')
+        {
+            turns = 2;
+            text++;
+        }
+        bool prime = *text == '\'';
+        if (prime)
+            text++;
+        if (*text && *text != ' ' && !moveSpinner(*text))
+            return false;
+        if (used + turns >= size)
+            return false;
+        for (int i = 0; i < turns; i++)
+            out[used++] = prime ? tolower(face) : face;
+    }
+    out[used] = '\0';
+    return true;
+}
+
+// The moves of SCRAMBLE <seed> <n>: n random quarter turns, never one right after its inverse ("Uu" does
+// nothing). xorshift32, so the same seed gives the same moves on the robot and anywhere else, seed 0 is
+// the same as 2654435769. False if they don't fit
+static inline bool scrambleMoves(uint32_t seed, int n, char* out, size_t size)
+{
+    static const char moves[] = "UuRrFfDdLlBb";     // Every move next to its inverse
+    if (n < 0 || (size_t)n >= size)
+        return false;
+    uint32_t x = seed ? seed : 2654435769UL;    // xorshift never gets away from 0
+    int last = -1;
+    for (int i = 0; i < n; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        int pick = (int)(x % (last < 0 ? 12 : 11));
+        if (last >= 0 && pick >= (last ^ 1))
+            pick++;     // Skip the inverse of the last one
+        out[i] = moves[pick];
+        last = pick;
+    }
+    out[n] = '\0';
+    return true;
+}
+
+// ---- Timing ----
+
+#define MOVE_START_MS 100   // startMoves() gives the servos this long to attach before the first command
+#define MOVE_SERVOS 8       // NUM_SERVOS, MyServo.h needs the Arduino headers
+
+// Where a servo is sent for a state, coming from the state it is in. A spinner going back to C goes a little
+// further to make up for the gap between gripper and cube, unless it is at C already (see SequenceManager.h)
+static inline int servoTargetPulse(const ServoCal& cal, int servo, int from, int to)
+{
+    switch (to)
+    {
+    case STATE_L: return cal.L_us;
+    case STATE_R: return cal.R_us;
+    case STATE_r: return (cal.C_us + cal.R_us) / 2;
+    case STATE_l: return (cal.C_us + cal.L_us) / 2;
+    }
+    if (servo % 2 == 1)     // Slider
+        return cal.C_us;
+    if (from == STATE_L || from == STATE_l)
+        return cal.C_us + cal.CD_us;
+    if (from == STATE_R || from == STATE_r)
+        return cal.C_us - cal.CD_us;
+    return cal.C_us;    // Double center is absolute center
+}
+
+// Until a servo covered distance us of pulse and settled, like MyServo moves it: without a ramp at its travel
+// speed, with one on a trapezoid that only advances every MOTION_TICK_MS
+static inline double servoTravelMs(const ServoCal& cal, double distance)
+{
+    double speed = cal.speed > 0 ? cal.speed : 1;
+    if (cal.accel == 0)
+        return floor(distance / speed) + cal.settleMs;
+
+    double accel = cal.accel / 1000.0;
+    double t = distance >= speed * speed / accel ? distance / speed + speed / accel : 2 * sqrt(distance / accel);
+    return t + MOTION_TICK_MS + cal.settleMs;
+}
+
+// Plays SEQ strings out the way SequenceManager and Timeline run them, to tell how long they take. With fixed
+// delays a delay counts from when the commands before it went out and nothing waits for a servo. Without (MOVE 0)
+// each command waits for its @ dependencies and W for every servo, that's where calOf(servo) (the ServoCal of
+// each ServoType) comes in, every servo is taken to start at C. It doesn't know about the power budget holding
+// commands back (POWER)
+struct MoveTimer
+{
+    double fireAt[MOVE_SERVOS], arriveAt[MOVE_SERVOS];      // Latest command of each servo
+    int state[MOVE_SERVOS], from[MOVE_SERVOS], to[MOVE_SERVOS];   // Pulses, from is where a ramped servo may still be coming from
+    double parseAt;         // Where parsing got to, when the string ends this is when the robot goes IDLE
+    double lastFire;
+    int stages;             // Delays and W so far
+};
+
+template <typename CalOf>
+static inline void moveTimerStart(MoveTimer& timer, bool delayed, CalOf calOf)
+{
+    for (int i = 0; i < MOVE_SERVOS; i++)
+    {
+        timer.fireAt[i] = timer.arriveAt[i] = 0;
+        timer.state[i] = STATE_C;
+        timer.from[i] = timer.to[i] = delayed ? 0 : calOf(i).C_us;
+    }
+    timer.parseAt = MOVE_START_MS;
+    timer.lastFire = 0;
+    timer.stages = 0;
+}
+
+template <typename CalOf>
+static inline void moveTimerPlay(MoveTimer& timer, const char* seq, bool delayed, CalOf calOf)
+{
+    for (const char* p = seq; *p; )
+    {
+        if (*p == 'W')
+        {
+            timer.stages++;
+            for (int i = 0; i < MOVE_SERVOS; i++)
+                timer.parseAt = timer.arriveAt[i] > timer.parseAt ? timer.arriveAt[i] : timer.parseAt;
+            p++;
+            continue;
+        }
+        if (isdigit(*p))
+        {
+            timer.stages++;
+            char* end;
+            double delay = strtod(p, &end);
+            timer.parseAt = (timer.lastFire > timer.parseAt ? timer.lastFire : timer.parseAt) + delay;
+            p = end;
+            continue;
+        }
+
+        int s = (int)(strchr("rRlLfFbB", *p) - "rRlLfFbB");     // ServoType order
+        int next = (int)(strchr("CLRrl", p[1]) - "CLRrl");      // ServoState order
+        p += 2;
+        double t = timer.parseAt > timer.fireAt[s] ? timer.parseAt : timer.fireAt[s];   // A servo's commands go in order
+        for (; *p == '@'; p += 3)
+        {
+            int dep = (int)(strchr("rRlLfFbB", p[1]) - "rRlLfFbB");
+            t = timer.arriveAt[dep] > t ? timer.arriveAt[dep] : t;
+        }
+
+        double arrive = t;
+        if (!delayed)
+        {
+            // Without a ramp MyServo counts from the target before, like the pulse jumped there. A ramped
+            // servo sent somewhere else before it got there could be anywhere in between
+            ServoCal cal = calOf(s);
+            int target = servoTargetPulse(cal, s, timer.state[s], next);
+            bool moving = cal.accel > 0 && t < timer.arriveAt[s];
+            int start = moving && abs(target - timer.from[s]) > abs(target - timer.to[s]) ? timer.from[s] : timer.to[s];
+            arrive = t + servoTravelMs(cal, abs(target - start));
+            timer.from[s] = start;
+            timer.to[s] = target;
+        }
+        timer.fireAt[s] = t;
+        timer.arriveAt[s] = arrive;
+        timer.state[s] = next;
+        timer.lastFire = t > timer.lastFire ? t : timer.lastFire;
+    }
+}
+
+struct MovePrediction
+{
+    int stages;             // Delays and W in the expanded moves
+    int flips;              // Times the cube was turned over
+    double ms;              // From the MOVE until the robot says IDLE
+    CubeOrientation endOrientation;
+};
+
+// What MOVE <delayMs> <orientation> <moves> will take: every move expanded with the templates above into scratch
+// (SEQUENCE_BUFFER_SIZE is enough for one) and played out with a MoveTimer. With a delay that is MOVE_START_MS
+// plus a delay per stage. False on a character that isn't a move
+template <typename CalOf>
+static inline bool predictMoves(const char* moves, CubeOrientation orientation, int delayMs, CalOf calOf,
+                                char* scratch, size_t size, MovePrediction& out)
+{
+    char delayToken[MOVE_DELAY_TOKEN_SIZE];
+    moveDelayToken(delayToken, delayMs);
+
+    MoveTimer timer;
+    moveTimerStart(timer, delayMs > 0, calOf);
+    out.flips = 0;
+    for (; *moves; moves++)
+    {
+        CubeOrientation before = orientation;
+        scratch[0] = '\0';
+        bool ok = delayMs > 0 ? appendMove(scratch, size, orientation, *moves, delayToken)
+                              : appendMoveDeps(scratch, size, orientation, *moves);
+        if (!ok)
+            return false;
+        if (orientation != before)
+            out.flips++;
+        moveTimerPlay(timer, scratch, delayMs > 0, calOf);
+    }
+    out.stages = timer.stages;
+    out.ms = timer.parseAt;
+    out.endOrientation = orientation;
+    return true;
+}
@@ -3,6 +3,7 @@
 #include "MyServo.h"
 #include "Config.h"
 #include "Calibrate.h"
+#include "MoveCore.h"
 
 #define MIN_PULSE_WIDTH 250
 #define MAX_PULSE_WIDTH 3000
@@ -17,36 +18,126 @@ MyServo::MyServo(int pin, ServoType type, ServoCal calibration) :
     } else {
         pulse = calibration.R_us;  // We want sliders in release by default
     }
+    target = pulse;
+    position = pulse;
 }
 
 void MyServo::setState(ServoState next)
 {
-    switch (next)
+    target = servoTargetPulse(cal, type, state, next);
+    state = next;
+
+    unsigned long now = millis();
+    if (cal.accel == 0)
     {
-    case STATE_L:
-        pulse = cal.L_us; break;
-    case STATE_R:
-        pulse = cal.R_us; break;
-    case STATE_C:
-        if (type % 2 == 1) // Slider
-        {
-            pulse = cal.C_us;
-            break;
-        }  
-        if (state == STATE_L || state == STATE_l)
-            pulse = cal.C_us + cal.CD_us;
-        else if (state == STATE_R || state == STATE_r)
-            pulse = cal.C_us - cal.CD_us;
-        else
-            pulse = cal.C_us;   // Double center is absolute center
-        break;
-    case STATE_r:
-        pulse = (cal.C_us + cal.R_us) / 2; break;
-    case STATE_l:
-        pulse = (cal.C_us + cal.L_us) / 2; break;
+        // No ramp, jump to the target and let the servo get there as fast as it can
+        unsigned int travel = abs(target - pulse);
+        unsigned int speed = cal.speed > 0 ? cal.speed : 1;
+        pulse = target;
+        position = target;
+        velocity = 0;
+        moving = false;
+        arrivedAt = now + travel / speed + cal.settleMs;
+        write();
     }
-    state = next;
-    thisServo.writeMicroseconds(pulse);
+    else if (target == position)
+    {
+        // Already there, a ramp would only brake away from it and come back
+        velocity = 0;
+        moving = false;
+        arrivedAt = now + cal.settleMs;
+    }
+    else
+    {
+        moving = true;
+        lastUpdate = now;
+    }
+}
+
+// Trapezoidal profile: accelerate up to the travel speed, cruise, and brake once the
+// stopping distance reaches what's left. The servo only ever gets small steps, so it
+// follows the ramp instead of slamming into the target and wobbling around it.
+void MyServo::update(unsigned long now)
+{
+    if (!moving)
+        return;
+
+    float dt = now - lastUpdate;
+    lastUpdate = now;
+    if (dt <= 0)
+        return;
+
+    float accel = cal.accel / 1000.0f;     // us per ms per ms
+    float remaining = target - position;
+    float dir = remaining >= 0 ? 1 : -1;
+    float speed = velocity * dir;           // Negative if we are still going the other way
+
+    if (speed < 0 || speed * speed / (2 * accel) < remaining * dir)
+        speed += accel * dt;
+    else
+        speed -= accel * dt;
+
+    if (speed > (float)cal.speed)
+        speed = cal.speed;
+    if (speed >= 0 && speed < accel * dt)
+        speed = accel * dt;     // Don't stall just short of the target while braking
+
+    position += speed * dir * dt;
+    velocity = speed * dir;
+
+    if ((target - position) * dir <= 0)
+    {
+        position = target;
+        velocity = 0;
+        moving = false;
+        arrivedAt = now + cal.settleMs;
+    }
+
+    int next = (int)(position + 0.5f);
+    if (next != pulse)
+    {
+        pulse = next;
+        write();
+    }
+}
+
+void MyServo::updatePower(unsigned long now)
+{
+    unsigned long dt = now - lastPowerUpdate;
+    lastPowerUpdate = now;
+
+    if (isTravelling(now))
+        travelMs += dt;
+
+    unsigned int maxHeat = (unsigned int)STALL_HEAT_MAX_MS * STALL_COOL_DIV;
+    if (isStalling(now))
+        stallHeat = dt * STALL_COOL_DIV > maxHeat - stallHeat ? maxHeat : stallHeat + dt * STALL_COOL_DIV;
+    else
+        stallHeat = dt > stallHeat ? 0 : stallHeat - dt;
+
+    if (stallHeat >= maxHeat)
+        hot = true;
+    else if (stallHeat < maxHeat / 2)
+        hot = false;
+}
+
+unsigned int MyServo::currentMa(unsigned long now) const
+{
+    if (isTravelling(now))
+        return SERVO_MOVING_MA;
+    if (isStalling(now))
+        return SERVO_STALL_MA;
+    return SERVO_IDLE_MA;
+}
+
+uint8_t MyServo::dutyPercent(unsigned long now) const
+{
+    return now > 0 ? travelMs * 100 / now : 0;
+}
+
+uint8_t MyServo::heatPercent() const
+{
+    return (unsigned long)stallHeat * 100 / ((unsigned int)STALL_HEAT_MAX_MS * STALL_COOL_DIV);
 }
 
 void MyServo::attach()
@@ -54,11 +145,22 @@ void MyServo::attach()
     if (!attached)
     {
         thisServo.attach(pin, MIN_PULSE_WIDTH, MAX_PULSE_WIDTH);
-        thisServo.writeMicroseconds(pulse);
+        write();
         attached = true;
     }
 }
 
+void MyServo::write()
+{
+    if (!servoDryRun)
+        thisServo.writeMicroseconds(pulse);
+}
+
+void MyServo::resync()
+{
+    write();
+}
+
 void MyServo::detach()
 {
     if (attached)
@@ -137,6 +239,64 @@ void detachAllServos()
     }
 }
 
+PowerStats powerStats;
+
+bool servoDryRun = false;
+
+void setServoDryRun(bool on)
+{
+    bool was = servoDryRun;
+    servoDryRun = on;
+    if (was && !on)
+    {
+        for (int i = 0; i < NUM_SERVOS; i++)
+            servos[i].resync();
+    }
+}
+
+void updateAllServos(unsigned long now)
+{
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        servos[i].update(now);
+        servos[i].updatePower(now);
+    }
+
+    unsigned int total = totalCurrentMa(now);
+    if (total > powerStats.peakMa)
+        powerStats.peakMa = total;
+}
+
+unsigned int totalCurrentMa(unsigned long now)
+{
+    unsigned int total = 0;
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        total += servos[i].currentMa(now);
+    }
+    return total;
+}
+
+bool anyServoTravelling(unsigned long now)
+{
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        if (servos[i].isTravelling(now))
+            return true;
+    }
+    return false;
+}
+
+bool allServosArrived(unsigned long now)
+{
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        if (!servos[i].isArrived(now))
+            return false;
+    }
+    return true;
+}
+
 // ====================
 // Calibration adjustment
 // ====================
@@ -156,6 +316,8 @@ void MyServo::adjustCalibration(int delta)
         cal.R_us += delta;
     }
     pulse += delta;
+    target = pulse;
+    position = pulse;
     thisServo.writeMicroseconds(pulse);
 }
 
@@ -176,6 +338,32 @@ void MyServo::adjustDeviation(int delta)
             cal.CD_us += delta;
             pulse = cal.C_us + cal.CD_us;
         }
+        target = pulse;
+        position = pulse;
         thisServo.writeMicroseconds(pulse);
     }
 }
+
+void MyServo::adjustTiming(int speedDelta, int settleDelta, int accelDelta)
+{
+    if (speedDelta < 0 && cal.speed <= 1)
+        cal.speed = 1;  // Zero speed would mean the servo never arrives
+    else
+        cal.speed += speedDelta;
+
+    if (settleDelta < 0 && cal.settleMs < (unsigned int)-settleDelta)
+        cal.settleMs = 0;
+    else
+        cal.settleMs += settleDelta;
+
+    if (accelDelta < 0 && cal.accel < (unsigned int)-accelDelta)
+        cal.accel = 0;
+    else
+        cal.accel += accelDelta;
+}
+
+void MyServo::setCalibration(ServoCal calibration)
+{
+    cal = calibration;
+    setState(state);    // Re-apply the current state with the new pulses
+}
@@ -21,14 +21,69 @@ private:
     int pulse{};    // Current pulse width in microseconds
     bool attached{false};
 
+    // Motion profile, see update()
+    int target{};               // Pulse width we are heading to
+    float position{};           // Exact commanded pulse while ramping, pulse is this rounded
+    float velocity{};           // Pulse microseconds per millisecond, signed
+    bool moving{false};         // Still ramping towards target
+    unsigned long lastUpdate{};
+    unsigned long arrivedAt{};  // When the horn should be at target and done wobbling (millis)
+
+    // Power model, see Config.h
+    unsigned long travelMs{};   // Time spent travelling, for the duty
+    unsigned int stallHeat{};   // Time spent stalling, in ms * STALL_COOL_DIV, going down by 1 each ms it doesn't
+    bool hot{false};            // Reached STALL_HEAT_MAX_MS, until it cooled down to half of that
+    unsigned long lastPowerUpdate{};
+
+    // Send pulse to the servo, unless it's a dry run
+    void write();
+
 public:
 
     // Constructor
     MyServo(int pin, ServoType type, ServoCal calibration);
 
     // State control
+    // With a ramp acceleration in the calibration, this only sets the target, update() does the moving
     void setState(ServoState next);
 
+    // Advance the motion profile, call this every MOTION_TICK_MS
+    void update(unsigned long now);
+
+    // Keep track of the time spent travelling and stalling, updateAllServos() does it
+    void updatePower(unsigned long now);
+
+    // Still on its way to the target (settling doesn't count, that's mostly the cube wobbling)
+    bool isTravelling(unsigned long now) const
+    {
+        return moving || (long)(now - (arrivedAt - cal.settleMs)) < 0;
+    }
+
+    // A slider pressing into the cube
+    bool isStalling(unsigned long now) const
+    {
+        return type % 2 == 1 && state == STATE_L && !isTravelling(now);
+    }
+
+    // What it draws from the supply right now, going by the model in Config.h
+    unsigned int currentMa(unsigned long now) const;
+
+    // Stalled for too long, needs to cool down before it presses into the cube again
+    bool isOverheated() const
+    {
+        return hot;
+    }
+
+    // Percent of the time since power on spent travelling, and how hot it is (100 = isOverheated())
+    uint8_t dutyPercent(unsigned long now) const;
+    uint8_t heatPercent() const;
+
+    // True once the servo has reached its target and had its settle time
+    bool isArrived(unsigned long now) const
+    {
+        return !moving && (long)(now - arrivedAt) >= 0;
+    }
+
     ServoState getState() const
     {
         return state;
@@ -58,9 +113,16 @@ public:
 
     void adjustDeviation(int delta);
 
+    void adjustTiming(int speedDelta, int settleDelta, int accelDelta);
+
+    void setCalibration(ServoCal calibration);
+
     void attach();
 
     void detach();
+
+    // After a dry run, send the servo to where the model says it is
+    void resync();
 };
 
 #define NUM_SERVOS 8
@@ -70,3 +132,26 @@ extern MyServo servos[NUM_SERVOS];
 void attachAllServos();
 
 void detachAllServos();
+
+void updateAllServos(unsigned long now);
+
+bool allServosArrived(unsigned long now);
+
+// Dry run (DRYRUN in the API): everything runs like always, the motion profiles, the arrival times and the
+// power model included, only the pulses never go out, so the servos stay where they are. For timing the
+// sequence engine itself on the board. Switching it off sends every servo to where the model has it
+extern bool servoDryRun;
+void setServoDryRun(bool on);
+
+// Power model, see Config.h
+unsigned int totalCurrentMa(unsigned long now);
+bool anyServoTravelling(unsigned long now);
+
+struct PowerStats
+{
+    unsigned int peakMa;    // Highest total draw seen
+    unsigned int waits;     // Commands held back to stay in the budget
+    unsigned int relaxed;   // Sliders let go of the cube because they got too hot or drew too much
+};
+
+extern PowerStats powerStats;
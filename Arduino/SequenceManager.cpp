@@ -1,11 +1,21 @@
 #include "SequenceManager.h"
+#include "MoveCore.h"
 #include "MyServo.h"
+#include "StageTimer.h"
+#include "TxQueue.h"
 #include <ctype.h> 
 #include <stdlib.h>
 #include <Arduino.h>
 
 SequenceManager seqManager;
 
+// From the timer interrupt, see armStage()
+void stageTimerFired()
+{
+    SequenceManager& m = seqManager;
+    m.stageResult = m.timeline.fireStage(m.stageCount, m.stageServos, m.stageStates, micros()) ? 1 : 2;
+}
+
 // Convert character to ServoState
 static bool parseServoState(char c, ServoState& state)
 {
@@ -20,12 +30,30 @@ static bool parseServoState(char c, ServoState& state)
     }
 }
 
+// Delay in a sequence, "150" or "150.25" ms, in us
+static unsigned long parseDelayUs(const char* s, char** end)
+{
+    unsigned long us = strtoul(s, end, 10) * 1000;
+    if (**end == '.')
+    {
+        unsigned long scale = 100;
+        const char* p = *end + 1;
+        for (; isdigit(*p); p++)
+        {
+            us += (*p - '0') * scale;
+            scale /= 10;    // Digits past the third are ignored
+        }
+        *end = (char*)p;
+    }
+    return us;
+}
+
 // Start a new sequence
 // Returns:
 //  0  = OK
 // -1  = busy
 // -2  = format error
-int SequenceManager::startSequence(const char* moveString)
+int SequenceManager::startSequence(const char* moveString, bool stream)
 {
     if (!moveString || *moveString == '\0')
         return -2;
@@ -33,7 +61,14 @@ int SequenceManager::startSequence(const char* moveString)
     // Cancel command
     if (moveString[0] == 'C' && moveString[1] == '\0')
     {
+        disarmStage();
+        if (busy == 2)
+            saveCheckpoint();
         busy = 0;
+        timeline.reset();
+        holdForDrain = false;
+        waitingForArrival = false;
+        streamOpen = false;
         idleTimeMs = millis();
         activeSequence[0] = '\0';
         notifyState();
@@ -43,18 +78,30 @@ int SequenceManager::startSequence(const char* moveString)
     if (busy)
         return -1;
 
+    // Raw servo commands can turn faces, no telling what the cube looks like after this
+    if (!servoDryRun)
+        cube.known = false;
+    pendingMove = 0;
+    canResume = false;  // The servos won't be where the checkpoint left them
+
     strncpy(activeSequence, moveString, sizeof(activeSequence) - 1);
     activeSequence[sizeof(activeSequence) - 1] = '\0';  // TODO: use strcpy?
 
     sequenceIndex = 0;
-    nextMoveAt = millis() + 100;    // Give time for the servo library to attach servos
+    nextMoveAt = micros() + MOVE_START_MS * 1000UL;  // Give time for the servo library to attach servos
+    disarmStage();
+    timeline.reset();
+    holdForDrain = false;
+    waitingForArrival = false;
+    streamOpen = stream;
+    resetCpu();
     busy = 1;   // Busy with SEQ
     notifyState();
 
     return 0;
 }
 
-int SequenceManager::startMoves(const char* moveString, int delayMs)
+int SequenceManager::startMoves(const char* moveString, int delayMs, bool stream)
 {
     if (!moveString || *moveString == '\0')
         return -2;
@@ -63,37 +110,239 @@ int SequenceManager::startMoves(const char* moveString, int delayMs)
         return -1;
 
     movesDelayMs = delayMs;
+    moveDelayToken(delayToken, delayMs);
 
     strncpy(moveBuf, moveString, sizeof(moveBuf) - 1);
-    activeSequence[sizeof(moveBuf) - 1] = '\0'; // TODO: use strcpy?
+    moveBuf[sizeof(moveBuf) - 1] = '\0';
+    moveIndex = 0;
+    movesStarted = 0;
+    movesDone = 0;
+    pendingMove = 0;
+    canResume = false;
+    streamed = stream;
+    streamOpen = stream;
+
+    // activeSequence is free until the first move goes in
+    MovePrediction prediction;
+    etaMs = 0;
+    if (predictMoves(moveBuf, orientation, delayMs, [](int i) { return servos[i].getCalibration(); },
+                     activeSequence, sizeof(activeSequence), prediction))
+        etaMs = (unsigned long)(prediction.ms + 0.5);
+    activeSequence[0] = '\0';
+
+    sequenceIndex = 0;
+    nextMoveAt = micros() + MOVE_START_MS * 1000UL;  // Give time for the servo library to attach servos
+    disarmStage();
+    timeline.reset();
+    holdForDrain = false;
+    waitingForArrival = false;
+    resetCpu();
+    busy = 2;   // Busy with MOVE
+    notifyState();
+
+    return 0;
+}
+
+// Called when a MOVE stops early, moveBuf and the counts are left as they are
+void SequenceManager::saveCheckpoint()
+{
+    // How far the interrupted move got, per servo
+    for (uint8_t i = 0; i < NUM_SERVOS; i++)
+        skipLeft[i] = pendingMove ? (uint8_t)(timeline.firedCount(i) - moveFiredAt[i]) : 0;
+    canResume = true;
+}
+
+int SequenceManager::resumeMoves(bool stream)
+{
+    if (busy)
+        return -1;
+
+    if (!canResume)
+        return -3;
+    canResume = false;
+
+    activeSequence[0] = '\0';
+    disarmStage();
+    timeline.reset();
+    if (pendingMove)
+    {
+        // Build the same sequence again, parseSequence() skips what was done
+        orientation = moveOrientation;
+        populateMove(pendingMove);
+        for (uint8_t i = 0; i < NUM_SERVOS; i++)
+            moveFiredAt[i] -= skipLeft[i];  // Those count as fired if it stops again
+        resuming = true;
+        skipDelays = true;
+    }
+    if (stream)
+    {
+        streamed = true;
+        streamOpen = true;
+    }
 
     sequenceIndex = 0;
-    nextMoveAt = millis() + 100;    // Give time for the servo library to attach servos
+    nextMoveAt = micros();
+    holdForDrain = true;        // Start once every servo is where it was sent before it stopped
+    waitingForArrival = true;
     busy = 2;   // Busy with MOVE
     notifyState();
 
     return 0;
 }
 
+bool SequenceManager::getCheckpoint(int& done, CubeOrientation& startOrientation, char& interrupted, const char*& rest) const
+{
+    if (!canResume)
+        return false;
+    done = movesDone;
+    startOrientation = pendingMove ? moveOrientation : orientation;
+    interrupted = pendingMove;
+    rest = moveBuf + moveIndex;
+    return true;
+}
+
+// Add moves to a MOVE that was started as a stream
+// Returns:
+//  0  = OK
+// -1  = no open stream
+// -3  = doesn't fit in moveBuf
+int SequenceManager::appendMoves(const char* moveString, bool more)
+{
+    if (busy != 2 || !streamOpen)
+        return -1;
+
+    // Moves before moveIndex are done or already in activeSequence, make room by dropping them
+    size_t left = strlen(moveBuf + moveIndex);
+    if (left + strlen(moveString) > sizeof(moveBuf) - 1)
+        return -3;
+    memmove(moveBuf, moveBuf + moveIndex, left + 1);
+    moveIndex = 0;
+    strcat(moveBuf, moveString);
+
+    streamOpen = more;
+    return 0;
+}
+
+// Add to a SEQ that was started as a stream
+// Returns:
+//  0  = OK
+// -1  = no open stream
+// -3  = doesn't fit in activeSequence yet
+int SequenceManager::appendSequence(const char* sequence, bool more)
+{
+    if (busy != 1 || !streamOpen)
+        return -1;
+
+    // Everything before sequenceIndex is in the timeline already, make room by dropping it
+    size_t left = strlen(activeSequence + sequenceIndex);
+    if (left + strlen(sequence) > sizeof(activeSequence) - 1)
+        return -3;
+    memmove(activeSequence, activeSequence + sequenceIndex, left + 1);
+    stageEnd -= sequenceIndex;
+    sequenceIndex = 0;
+    strcat(activeSequence, sequence);
+
+    streamOpen = more;
+    return 0;
+}
+
 // Called repeatedly from loop()
 int SequenceManager::tick()
 {
     if (!isBusy())
-        return 0;
+        return step();
+
+    unsigned long start = micros();
+    int res = step();
+    unsigned long us = micros() - start;
+    cpuUs += us;
+    cpuTicks++;
+    if (us > cpuMaxUs)
+        cpuMaxUs = us;
+    return res;
+}
+
+void SequenceManager::resetCpu()
+{
+    cpuUs = 0;
+    cpuTicks = 0;
+    cpuMaxUs = 0;
+}
+
+int SequenceManager::setDryRun(bool on)
+{
+    if (busy)
+        return -1;
+    if (on && !servoDryRun)
+    {
+        dryOrientation = orientation;
+        dryPendingMove = pendingMove;
+    }
+    else if (!on && servoDryRun)
+    {
+        orientation = dryOrientation;
+        pendingMove = dryPendingMove;
+        canResume = false;  // Whatever it was, the dry run didn't leave the servos there
+    }
+    setServoDryRun(on);
+    return 0;
+}
 
+int SequenceManager::step()
+{
     unsigned long now = millis();
-    if (now < nextMoveAt)
+
+    // Servo ramps keep going after a sequence is done, so this comes before the busy check
+    if (now - lastMotionUpdate >= MOTION_TICK_MS)
+    {
+        lastMotionUpdate = now;
+        stageTimerBlock(true);      // The interrupt moves servos too
+        updateAllServos(now);
+        stageTimerBlock(false);
+        if (!isBusy())
+            relaxSliders(now);
+    }
+
+    if (!isBusy())
         return 0;
 
     return executeUntilDelay();
 }
 
+// While idle, let go of the cube with a slider that got too hot, or with the one that has been
+// pressing the longest if the sliders together draw more than the supply should give
+void SequenceManager::relaxSliders(unsigned long now)
+{
+    if (anyServoTravelling(now))
+        return;     // Wait until the draw settled, a slider that is still on its way to C counts as moving
+
+    bool overBudget = totalCurrentMa(now) > POWER_BUDGET_MA;
+    int relax = -1;
+    for (int i = 1; i < NUM_SERVOS; i += 2)     // Sliders
+    {
+        if (!servos[i].isStalling(now))
+            continue;
+        if (servos[i].isOverheated())
+        {
+            relax = i;
+            break;
+        }
+        if (overBudget && (relax < 0 || servos[i].heatPercent() > servos[relax].heatPercent()))
+            relax = i;
+    }
+    if (relax < 0)
+        return;
+
+    servos[relax].setState(STATE_C);    // Still touching the cube, but not stalling
+    powerStats.relaxed++;
+}
+
 void SequenceManager::notifyState()
 {
     if (isBusy())
-        Serial.println("BUSY");
+        txEvent.println(F("BUSY"));
     else
-        Serial.println("IDLE");
+        txEvent.println(F("IDLE"));
 }
 
 int SequenceManager::executeUntilDelay()
@@ -106,65 +355,210 @@ int SequenceManager::executeUntilDelay()
     return -10;  // Should not happen
 }
 
-int SequenceManager::handleSequence()
+// Moves commands from activeSequence into the timeline until the string ends, a servo's queue is full,
+// or a delay/W says the rest has to wait
+int SequenceManager::parseSequence(unsigned long now, unsigned long nowUs)
 {
-    // Execute until we hit a delay or end of sequence
-    while (activeSequence[sequenceIndex] != '\0' &&
-       !isdigit(activeSequence[sequenceIndex]))
+    unsigned long parsedAt = nowUs;
+    while (true)
     {
-        ServoType servoType;
-        if (!parseServoType(activeSequence[sequenceIndex], servoType))
+        // ---- Stage after a delay, fired by the timer ----
+        if (stageDecoded && stageCount > 0)
         {
-            busy = 0;
-            idleTimeMs = millis();
-            activeSequence[0] = '\0';
-            notifyState();
-            return -3;  // servo type error
+            if (stageResult == 0)
+                return 0;   // Not yet, it comes at nextMoveAt
+            if (stageResult == 1)
+            {
+                sequenceIndex = stageEnd;
+                skipDelays = false;
+                parsedAt = nextMoveAt;  // A delay right after the stage counts from when it went out, not from now
+            }
+            stageCount = 0;
         }
-        sequenceIndex++;
 
-        ServoState state;
-        if (!parseServoState(activeSequence[sequenceIndex], state))
+        // ---- Delay or W parsed earlier, everything before it has to go out first ----
+        if (holdForDrain)
+        {
+            if (!timeline.isEmpty())
+                return 0;
+
+            if (waitingForArrival)
+            {
+                if (!allServosArrived(now))
+                    return 0;
+                waitingForArrival = false;
+                nextMoveAt = nowUs;
+            }
+            else
+            {
+                // The delay counts from when the last command before it went out
+                unsigned long from = timeline.lastFireAt();
+                if ((long)(from - holdStart) < 0)
+                    from = holdStart;
+                nextMoveAt = from + holdDelay;
+            }
+            holdForDrain = false;
+            stageDecoded = false;
+        }
+
+        if ((long)(nowUs - nextMoveAt) < 0)
+        {
+            if (STAGE_TIMER && !stageDecoded)
+                armStage();
+            return 0;
+        }
+
+        char c = activeSequence[sequenceIndex];
+        if (c == '\0')
+            return 0;
+
+        // ---- Wait for arrival encountered ----
+        if (c == 'W')
         {
-            busy = 0;
-            idleTimeMs = millis();
-            activeSequence[0] = '\0';
-            notifyState();
+            sequenceIndex++;
+            if (skipDelays)
+                continue;
+            holdForDrain = true;
+            waitingForArrival = true;
+            continue;
+        }
+
+        // ---- Delay encountered ----
+        if (isdigit(c))
+        {
+            char* endPtr;
+            holdDelay = parseDelayUs(&activeSequence[sequenceIndex], &endPtr);
+            sequenceIndex = endPtr - activeSequence;
+            if (skipDelays)
+                continue;
+            holdStart = parsedAt;
+            holdForDrain = true;
+            continue;
+        }
+
+        // ---- Servo command, with optional dependencies ----
+        ServoType servoType;
+        if (!parseServoType(c, servoType))
+            return -3;  // servo type error
+
+        ServoState state;
+        if (!parseServoState(activeSequence[sequenceIndex + 1], state))
             return -4;  // state error
+
+        int next = sequenceIndex + 2;
+        uint8_t depCount = 0;
+        uint8_t depServos[TIMELINE_MAX_DEPS];
+        ServoState depStates[TIMELINE_MAX_DEPS];
+        while (activeSequence[next] == '@')
+        {
+            ServoType depServo;
+            if (depCount == TIMELINE_MAX_DEPS ||
+                !parseServoType(activeSequence[next + 1], depServo) ||
+                !parseServoState(activeSequence[next + 2], depStates[depCount]))
+                return -5;  // dependency error
+            depServos[depCount++] = depServo;
+            next += 3;
         }
-        sequenceIndex++;
 
-        // Execute move immediately
-        servos[servoType].setState(state);
+        if (resuming && skipLeft[servoType] > 0)
+        {
+            // Did this one before the MOVE stopped, the servo is there already
+            skipLeft[servoType]--;
+            timeline.skip(servoType, state);
+            sequenceIndex = next;
+            continue;
+        }
+
+        if (!timeline.canPush(servoType))
+            return 0;   // This servo has enough to do, try again next tick
+
+        if (!timeline.push(servoType, state, depCount, depServos, depStates))
+            return -5;  // Depends on a state that servo isn't going to
+
+        sequenceIndex = next;
+        skipDelays = false;
     }
+}
 
-    // ---- End of sequence ----
-    if (activeSequence[sequenceIndex] == '\0')
+// Decode the commands right after the delay being waited out, and have the timer fire them the moment it's over.
+// Only the ones that need nothing but the delay: up to the next delay or W, the first @ dependency, or a command
+// resumeMoves() skips. Whatever comes after them goes through the timeline like before
+void SequenceManager::armStage()
+{
+    stageDecoded = true;
+    stageCount = 0;
+    int i = sequenceIndex;
+    while (stageCount < STAGE_MAX_COMMANDS)
     {
-        if (busy == 2)
-            // SEQ is being used by MOVE, don't clear yet
-            return 2; // This is an indicator for the MOVE handler
+        ServoType servoType;
+        ServoState state;
+        if (!parseServoType(activeSequence[i], servoType) ||
+            !parseServoState(activeSequence[i + 1], state) ||
+            activeSequence[i + 2] == '@' ||
+            (resuming && skipLeft[servoType] > 0))
+            break;
+        stageServos[stageCount] = servoType;
+        stageStates[stageCount++] = state;
+        i += 2;
+    }
+    if (stageCount == 0)
+        return;
+    stageEnd = i;
+    stageResult = 0;
+    stageTimerArm(nextMoveAt);
+}
 
+void SequenceManager::disarmStage()
+{
+    stageTimerCancel();
+    stageDecoded = false;
+    stageCount = 0;
+}
+
+int SequenceManager::handleSequence()
+{
+    unsigned long now = millis();
+    unsigned long nowUs = micros();
+
+    int res = parseSequence(now, nowUs);
+    if (res >= 0)
+    {
+        timeline.dispatch(now);
+
+        // What just went out may be all a delay was waiting for, then the timer can take the stage after it
+        if (STAGE_TIMER && holdForDrain && timeline.isEmpty())
+            res = parseSequence(now, nowUs);
+    }
+    if (res < 0)
+    {
+        disarmStage();
         busy = 0;
-        idleTimeMs = millis();
+        idleTimeMs = now;
         activeSequence[0] = '\0';
+        timeline.reset();
         notifyState();
-        return 0;
+        return res;
     }
 
-    // ---- Delay encountered ----
-    if (isdigit(activeSequence[sequenceIndex]))
+    // ---- End of sequence ----
+    if (activeSequence[sequenceIndex] == '\0' && !holdForDrain &&
+        timeline.isEmpty() && (long)(nowUs - nextMoveAt) >= 0)
     {
-        char* endPtr;
-        unsigned long delay =
-            strtoul(&activeSequence[sequenceIndex], &endPtr, 10);
+        if (busy == 2)
+            // SEQ is being used by MOVE, don't clear yet
+            return 2; // This is an indicator for the MOVE handler
+
+        if (streamOpen)
+            return 1;   // Wait for APPEND, servos stay where they are
 
-        sequenceIndex = endPtr - activeSequence;
-        nextMoveAt = millis() + delay;
+        busy = 0;
+        idleTimeMs = now;
+        activeSequence[0] = '\0';
+        notifyState();
         return 0;
     }
 
-    return 1;   // Current move executed, more to schedule
+    return 1;   // Still running
 }
 
 // ==================================================================
@@ -177,10 +571,11 @@ int SequenceManager::handleMoves()
     int seqResult = handleSequence();
     if (seqResult < 0)
     {
+        saveCheckpoint();
         busy = 0;   // Error in sequence
+        streamOpen = false;
         idleTimeMs = millis();
         activeSequence[0] = '\0';
-        moveBuf[0] = '\0';
         notifyState();
         return seqResult;
     }
@@ -190,7 +585,24 @@ int SequenceManager::handleMoves()
     }
 
     // ---- Sequence finished, give it next move ----
+    if (movesDone != movesStarted)
+    {
+        movesDone = movesStarted;
+        if (!servoDryRun)
+            cube.turn(pendingMove);
+        pendingMove = 0;
+        if (streamed)
+        {
+            // Lets the host know when to send more
+            txTelemetry.print(F("MOVED "));
+            txTelemetry.println(movesDone);
+        }
+    }
+
     char moveChar = moveBuf[moveIndex];
+    if (moveChar == '\0' && streamOpen)
+        return 0;   // Wait for APPEND, servos stay where they are
+
     if (moveChar == '\0')
     {
         busy = 0;   // All moves done
@@ -204,247 +616,40 @@ int SequenceManager::handleMoves()
     }
 
     // Populate activeSequence with next move and start a new sequence
-    activeSequence[0] = '\0';
-    populateActiveSequenceMove(moveChar);
+    populateMove(moveChar);
     sequenceIndex = 0;
-    nextMoveAt = millis();
+    nextMoveAt = micros();
     moveIndex++;
+    movesStarted++;
+    pendingMove = moveChar;
     return 1;   // Next move scheduled
 }
 
-void SequenceManager::rotateCube(CubeOrientation newOrientation)
+// Next move into activeSequence, noting where it starts from for a checkpoint
+void SequenceManager::populateMove(char moveChar)
 {
-    if (orientation == newOrientation)
-        return;
-
-    char *p = activeSequence;
-
-    p += strlen(p);
-    sprintf(p, "RLLL");         // RIGHT and LEFT grab
+    moveOrientation = orientation;
+    for (uint8_t i = 0; i < NUM_SERVOS; i++)
+        moveFiredAt[i] = timeline.firedCount(i);
+    resuming = false;
+    skipDelays = false;
+    disarmStage();
 
-    p += strlen(p);
-    sprintf(p, "FRBR%d", movesDelayMs);         // FRONT and BACK release
-
-    p += strlen(p);
-    if (newOrientation == ORIENT_INVERT)
-        sprintf(p, "fRbL%d", movesDelayMs);     // front spin right, back spin left, twice for true left and right
+    activeSequence[0] = '\0';
+    if (movesDelayMs == 0)
+        populateActiveSequenceMoveDeps(moveChar);
     else
-        sprintf(p, "fLbR%d", movesDelayMs);     // front spin left, back spin right, twice for true left and right
-
-    p += strlen(p);
-    sprintf(p, "FLBL%d", movesDelayMs);         // FRONT and BACK grab
-
-    p += strlen(p);
-    sprintf(p, "RRLR%d", movesDelayMs);         // RIGHT and LEFT release
-   
-    p += strlen(p);
-    sprintf(p, "fCfCbCbC%d", movesDelayMs);    // front and back spin to true center
-
-    p += strlen(p);
-    sprintf(p, "RCLC%d", movesDelayMs);         // RIGHT and LEFT sliders go back
-
-    p += strlen(p);
-    sprintf(p, "FCBC");         // Relax RIGHT and LEFT sliders, they don't need to grab anymore
-    
-    orientation = newOrientation;
+        populateActiveSequenceMove(moveChar);
 }
 
-// This function could have been done in a better way, but oh well, again, fuck it
+// The templates are in MoveCore.h, shared with the host and the app
 void SequenceManager::populateActiveSequenceMove(char moveChar)
 {
-    char *p = activeSequence;
-
-    switch (moveChar)
-    {
-    case 'U':
-        rotateCube(ORIENT_INVERT);  // Up face must be on right or left to access it
-
-        p += strlen(p);
-        sprintf(p, "lR%d", movesDelayMs);  // Rotate left spinner to R
-
-        p += strlen(p);
-        sprintf(p, "LR%d", movesDelayMs);  // Move left slider to Release
-
-        p += strlen(p);
-        sprintf(p, "lClC%d", movesDelayMs);  // Center left spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "LC%d", movesDelayMs);  // Center left slider again
-        break;
-                                           // The rest follow the same pattern, just with different sides..
-    case 'u':
-        rotateCube(ORIENT_INVERT);
-
-        p += strlen(p);
-        sprintf(p, "lL%d", movesDelayMs); 
-
-        p += strlen(p);
-        sprintf(p, "LR%d", movesDelayMs); 
-
-        p += strlen(p);
-        sprintf(p, "lClC%d", movesDelayMs);
-
-        p += strlen(p);
-        sprintf(p, "LC%d", movesDelayMs); 
-        break;
-
-    case 'D':
-        rotateCube(ORIENT_INVERT);
-
-        p += strlen(p);
-        sprintf(p, "rR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "RR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "rCrC%d", movesDelayMs);
-
-        p += strlen(p);
-        sprintf(p, "RC%d", movesDelayMs);  
-        break;
-
-    case 'd':
-        rotateCube(ORIENT_INVERT);
-
-        p += strlen(p);
-        sprintf(p, "rL%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "RR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "rCrC%d", movesDelayMs);
-
-        p += strlen(p);
-        sprintf(p, "RC%d", movesDelayMs);  
-        break;
-
-    case 'L':
-        rotateCube(ORIENT_NORMAL);  // Put left and right faces back in their normal position
-
-        p += strlen(p);
-        sprintf(p, "lR%d", movesDelayMs);  // Rotate left spinner to R
-
-        p += strlen(p);
-        sprintf(p, "LR%d", movesDelayMs);  // Move left slider to Release
-
-        p += strlen(p);
-        sprintf(p, "lClC%d", movesDelayMs);  // Center left spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "LC%d", movesDelayMs);  // Center left slider again
-        break;
-
-    case 'l':
-        rotateCube(ORIENT_NORMAL);  // Put left and right faces back in their normal position
-
-        p += strlen(p);
-        sprintf(p, "lL%d", movesDelayMs);  // Rotate left spinner to R
-
-        p += strlen(p);
-        sprintf(p, "LR%d", movesDelayMs);  // Move left slider to Release
-
-        p += strlen(p);
-        sprintf(p, "lClC%d", movesDelayMs);  // Center left spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "LC%d", movesDelayMs);  // Center left slider again
-        break;
-
-    case 'R':
-        rotateCube(ORIENT_NORMAL);
-
-        p += strlen(p);
-        sprintf(p, "rR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "RR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "rCrC%d", movesDelayMs);
-
-        p += strlen(p);
-        sprintf(p, "RC%d", movesDelayMs);  
-        break;
-
-    case 'r':
-        rotateCube(ORIENT_NORMAL);
-
-        p += strlen(p);
-        sprintf(p, "rL%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "RR%d", movesDelayMs);  
-
-        p += strlen(p);
-        sprintf(p, "rCrC%d", movesDelayMs);
-
-        p += strlen(p);
-        sprintf(p, "RC%d", movesDelayMs);  
-        break;
-
-    case 'F':
-        // F and B are always accessible, no need to rotate cube
-        p += strlen(p);
-        sprintf(p, "fR%d", movesDelayMs);  // Rotate front spinner to R
-
-        p += strlen(p);
-        sprintf(p, "FR%d", movesDelayMs);  // Move front slider to Release
-
-        p += strlen(p);
-        sprintf(p, "fCfC%d", movesDelayMs);  // Center front spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "FC%d", movesDelayMs);  // Center front slider again
-        break;
-
-    case 'f':
-        // F and B are always accessible, no need to rotate cube
-        p += strlen(p);
-        sprintf(p, "fL%d", movesDelayMs);  // Rotate front spinner to R
-
-        p += strlen(p);
-        sprintf(p, "FR%d", movesDelayMs);  // Move front slider to Release
-
-        p += strlen(p);
-        sprintf(p, "fCfC%d", movesDelayMs);  // Center front spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "FC%d", movesDelayMs);  // Center front slider again
-        break;
-
-    case 'B':
-        // F and B are always accessible, no need to rotate cube
-        p += strlen(p);
-        sprintf(p, "bR%d", movesDelayMs);  // Rotate front spinner to R
-
-        p += strlen(p);
-        sprintf(p, "BR%d", movesDelayMs);  // Move front slider to Release
-
-        p += strlen(p);
-        sprintf(p, "bCbC%d", movesDelayMs);  // Center front spinner twice for true center (no gap compensation)
-
-        p += strlen(p);
-        sprintf(p, "BC%d", movesDelayMs);  // Center front slider again
-        break;
-
-    case 'b':
-        // F and B are always accessible, no need to rotate cube
-        p += strlen(p);
-        sprintf(p, "bL%d", movesDelayMs);  // Rotate front spinner to R
-
-        p += strlen(p);
-        sprintf(p, "BR%d", movesDelayMs);  // Move front slider to Release
-
-        p += strlen(p);
-        sprintf(p, "bCbC%d", movesDelayMs);  // Center front spinner twice for true center (no gap compensation)
+    appendMove(activeSequence, sizeof(activeSequence), orientation, moveChar, delayToken);
+}
 
-        p += strlen(p);
-        sprintf(p, "BC%d", movesDelayMs);  // Center front slider again
-        break;
-    
-    default:
-        break;
-    }
+// For MOVE with delay 0, each command only waits for the servos it actually needs (@ dependencies)
+void SequenceManager::populateActiveSequenceMoveDeps(char moveChar)
+{
+    appendMoveDeps(activeSequence, sizeof(activeSequence), orientation, moveChar);
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "Config.h"
 #include "Types.h"
+#include "Timeline.h"
+#include "CubeState.h"
 
 
 struct SequenceMove
@@ -24,7 +26,8 @@ public:
 
     // Move string should be "rRBL250fr"
     // meaning: right spinner to R, back slider to L, wait 250ms, front spinner to r
-    // Moves are a pair of two chars, first refers to the servo, second to the state. numbers refer to delays in milliseconds.
+    // Moves are a pair of two chars, first refers to the servo, second to the state. numbers refer to delays in milliseconds,
+    // with up to three decimals for finer tuning ("12.5" is 12500us).
     // The servo numbers are defined in the ServoType enum in Types.h and in this function, referenced like this:
     //     "F" "B" "L" "R" : Front, Back, Left, Right Sliders
     //     "f" "b" "l" "r" : Front, Back, Left, Right Spinners
@@ -38,7 +41,17 @@ public:
     // Sometimes we don't want that, so just call the move again, to make it go to the true state.
     // Example: "rC" will move right spinner to center, then go a little further to make the side itself centered.
     // But if we want the gripper itself to be centered, we call "rCrC".
-    int startSequence(const char* moveString);
+    // "W" instead of a delay waits until every servo has arrived at its target and settled (see MyServo::isArrived).
+    // A move can be followed by up to two dependencies "@<SERVO><STATE>": it waits until that servo has arrived
+    // at that state (its latest move so far in the string), without holding up any other servo.
+    // Example: "fR@FL" turns the front spinner once the front slider is at L.
+    // With stream set, the robot stays BUSY at the end of the string and waits for more from appendSequence(),
+    // for programs that don't fit in activeSequence (Host/Solver/ScheduleCompiler.h makes those).
+    int startSequence(const char* moveString, bool stream = false);
+
+    // Add to a sequence that was started as a stream, like appendMoves(). Only split it before a delay or
+    // between commands, the part that is there already runs like it would have anyway.
+    int appendSequence(const char* sequence, bool more);
 
     // Execute moves on the cube.
     // Each character in the string is a move.
@@ -47,7 +60,24 @@ public:
     // And so on for other faces: D, L, R, F, B (lowercase for counter-clockwise)
     // Don't input U' or U2 or anything similar, not even spaces, just parse your moves before calling this function.
     // The delay is how long to wait for servos to reach their position before executing the next move.
-    int startMoves(const char* moveString, int delayMs);
+    // A delay of 0 waits for the servos to report they arrived instead of a fixed time, and every servo
+    // goes on as soon as the servos it depends on are there (see the @ dependencies above).
+    // With stream set, the robot stays BUSY after the last move and waits for more from appendMoves(),
+    // so moves can be sent while they are still being worked out. Each finished move is reported as "MOVED <n>".
+    int startMoves(const char* moveString, int delayMs, bool stream = false);
+
+    // Add moves to a streaming MOVE. Without more, the stream is closed and it ends after these moves.
+    int appendMoves(const char* moveString, bool more);
+
+    // Carry on with a MOVE that was cancelled (SEQ C) or failed, see the checkpoint below.
+    // The move it was on is done from where it stopped: every servo skips the commands it already did,
+    // after waiting for the servos to be where they were sent. With stream set, the stream is open again.
+    // Returns 0 = OK, -1 = busy, -3 = nothing to resume
+    int resumeMoves(bool stream);
+
+    // What resumeMoves() would do: moves finished so far, orientation to start with and the moves left
+    // (the interrupted one first). False if there is nothing to resume
+    bool getCheckpoint(int& done, CubeOrientation& startOrientation, char& interrupted, const char*& rest) const;
 
     // Call this in the main loop
     int tick();
@@ -55,27 +85,95 @@ public:
     // Query if sequence is still running
     bool isBusy() const { return busy != 0; }
 
+    // Moves of the current MOVE that are done, so the host build can time them without a stream
+    int movesFinished() const { return movesDone; }
+
+    // How long the MOVE that was just started takes until IDLE in ms, worked out from the templates and the
+    // calibrations (predictMoves() in MoveCore.h). 0 if it has a character that isn't a move.
+    // For a stream, the moves it got with MOVE
+    unsigned long etaMs = 0;
+
+    // Dry run (DRYRUN, see setServoDryRun() in MyServo.h): everything runs, but the servos don't move.
+    // So the cube doesn't either, it isn't turned here and switching off puts the orientation and the pending
+    // move back to what they were before. Returns -1 if busy
+    int setDryRun(bool on);
+
+    // CPU time tick() took while busy with the current or last SEQ or MOVE, for the CPU command
+    unsigned long cpuUs = 0;
+    unsigned long cpuTicks = 0;
+    unsigned int cpuMaxUs = 0;      // The longest single tick()
+
     unsigned long idleTimeMs;  // Time since last sequence completed
 
     CubeOrientation orientation = ORIENT_NORMAL;    // To keep track of which side is up
 
+    // The cube as of the last finished move, see CubeState.h. MOVE turns it, SEQ makes it unknown
+    CubeState cube;
+
+    // The MOVE character being worked on, 0 if none. If a MOVE is cancelled or fails it stays set:
+    // the servos may have turned that face (and flipped the cube for it) or not, only the host can tell.
+    // The next MOVE, or the host setting the state, clears it.
+    char pendingMove = 0;
+
 private:
+    friend class SequenceBench;     // Host/Tools/Bench.cpp times the internals on a PC
+
     int busy = 0;   // 0 = idle, 1 = busy with SEQ, 2 = busy with MOVE
+    int step();     // tick() without the timing
     void notifyState();
+    void resetCpu();
+    void relaxSliders(unsigned long now);
 
     // Sequence handling stuff
+    // Commands are parsed into the timeline (one queue per servo) and fire from there as their dependencies allow.
+    // Delays and W only hold up parsing of what comes after them, the servos run on their own.
+    Timeline timeline;
     int sequenceIndex = 0;
-    unsigned long nextMoveAt = 0;
+    unsigned long nextMoveAt = 0;       // Don't parse further before this, micros()
+    bool holdForDrain = false;          // Hit a delay or W, wait for everything before it to fire
+    bool waitingForArrival = false;     // Hit a W, also wait until all servos arrived
+    unsigned long holdStart = 0;        // When the delay was parsed, micros()
+    unsigned long holdDelay = 0;        // us
+    unsigned long lastMotionUpdate = 0;
     int executeUntilDelay();
+    int parseSequence(unsigned long now, unsigned long nowUs);
     int handleSequence();
+
+    // Stage timer (STAGE_TIMER in Config.h). While parsing waits out a delay, the commands right after it
+    // are decoded ahead, and the interrupt fires them at nextMoveAt, however busy loop() is then
+    friend void stageTimerFired();
+    bool stageDecoded = false;          // Looked ahead for this delay already
+    volatile uint8_t stageResult = 0;   // 0 = interrupt still to come, 1 = it fired them, 2 = power said no, loop() does it
+    uint8_t stageCount = 0;
+    uint8_t stageServos[STAGE_MAX_COMMANDS];
+    uint8_t stageStates[STAGE_MAX_COMMANDS];
+    int stageEnd = 0;                   // sequenceIndex after the stage
+    void armStage();
+    void disarmStage();
     
     // MOVE handling stuff
     int movesDelayMs;   // This is for MOVE command only
-    char seqBuf[128]; // Used by MOVE command only to build individual moves
+    char delayToken[MOVE_DELAY_TOKEN_SIZE]; // movesDelayMs as it goes into the sequence, "W" for 0
     int moveIndex = 0;
+    int movesStarted = 0;   // Moves handed to the sequence handler so far
+    int movesDone = 0;
+    bool streamed = false;  // Started as a stream, report progress
+    bool streamOpen = false;    // More moves (or more of a SEQ) may still come
     int handleMoves();
+
+    // Checkpoint of a MOVE that stopped early. moveBuf, moveIndex, movesDone and pendingMove stay as they were
+    bool canResume = false;
+    bool resuming = false;          // The current move is an interrupted one, done again
+    bool skipDelays = false;        // Resumed, and nothing needed doing yet, so delays and W have nothing to wait for
+    CubeOrientation moveOrientation = ORIENT_NORMAL;    // Before the current move flipped the cube
+    uint8_t moveFiredAt[NUM_SERVOS];    // Timeline fired counts when the current move started
+    uint8_t skipLeft[NUM_SERVOS];       // Commands of the current move each servo still skips while resuming
+    void saveCheckpoint();
+    CubeOrientation dryOrientation = ORIENT_NORMAL;     // Where the cube really was when the dry run started
+    char dryPendingMove = 0;
+    void populateMove(char moveChar);
     void populateActiveSequenceMove(char moveChar);
-    void rotateCube(CubeOrientation newOrientation);
+    void populateActiveSequenceMoveDeps(char moveChar);
 };
 
 extern SequenceManager seqManager;
@@ -0,0 +1,62 @@
+#include "StageTimer.h"
+
+#ifdef __AVR__
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+static volatile unsigned long targetUs;
+static volatile bool armed = false;
+
+void stageTimerBegin()
+{
+    TCCR2A = 0;             // Normal mode, pins not touched
+    TCCR2B = _BV(CS22);     // clk/64, 4us per count at 16MHz, the counter goes around every 1.024ms
+    TIMSK2 = 0;
+}
+
+// Compare match at the target if it comes before the counter goes around, or as far as it goes
+static void schedule()
+{
+    long left = (long)(targetUs - micros());
+    uint8_t counts = left <= 8 ? 2 : left >= 1000 ? 250 : left / 4;
+    OCR2A = TCNT2 + counts;
+    TIFR2 = _BV(OCF2A);     // Forget a match from before
+}
+
+void stageTimerArm(unsigned long atUs)
+{
+    uint8_t sreg = SREG;
+    cli();
+    targetUs = atUs;
+    armed = true;
+    schedule();
+    TIMSK2 |= _BV(OCIE2A);
+    SREG = sreg;
+}
+
+void stageTimerCancel()
+{
+    TIMSK2 &= ~_BV(OCIE2A);
+    armed = false;
+}
+
+void stageTimerBlock(bool block)
+{
+    if (block)
+        TIMSK2 &= ~_BV(OCIE2A);
+    else if (armed)
+        TIMSK2 |= _BV(OCIE2A);  // A match that came meanwhile is still flagged and fires now
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+    if ((long)(micros() - targetUs) < 0)
+    {
+        schedule();     // Not yet, another lap
+        return;
+    }
+    TIMSK2 &= ~_BV(OCIE2A);
+    armed = false;
+    stageTimerFired();
+}
+#endif
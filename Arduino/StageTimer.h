@@ -0,0 +1,18 @@
+#pragma once
+
+// One-shot timer with micros() resolution, for SequenceManager to fire the next stage of a sequence
+// exactly on time, however long loop() is busy with serial or attaching servos (see STAGE_TIMER in Config.h).
+// On the nano it is Timer2, the Servo library already has Timer1. In the host build the simulated clock
+// fires it (Host/Sim/Firmware.cpp).
+
+void stageTimerBegin();
+
+// Call stageTimerFired() from the interrupt once micros() reaches atUs (right away if that's already past)
+void stageTimerArm(unsigned long atUs);
+void stageTimerCancel();
+
+// Keep the interrupt from coming while loop() changes something it uses, it comes right after if it's due
+void stageTimerBlock(bool block);
+
+// Defined by whoever uses the timer (SequenceManager.cpp), runs in interrupt context
+void stageTimerFired();
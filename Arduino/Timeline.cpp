@@ -0,0 +1,136 @@
+#include "Timeline.h"
+#include "MyServo.h"
+
+void Timeline::reset()
+{
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        head[i] = 0;
+        size[i] = 0;
+        scheduled[i] = fired[i];    // Dropped events never happened
+        lastState[i] = servos[i].getState();
+    }
+    heldBack = 0;
+}
+
+bool Timeline::push(ServoType servo, ServoState state, uint8_t depCount, const uint8_t* depServos, const ServoState* depStates)
+{
+    if (!canPush(servo))
+        return false;
+
+    TimelineEvent& event = queue[servo][(head[servo] + size[servo]) % TIMELINE_QUEUE_DEPTH];
+    event.state = state;
+    event.depCount = depCount;
+    for (uint8_t i = 0; i < depCount; i++)
+    {
+        uint8_t dep = depServos[i];
+        if (lastState[dep] != depStates[i])
+            return false;
+        event.depServo[i] = dep;
+        event.depFired[i] = scheduled[dep];
+    }
+
+    size[servo]++;
+    scheduled[servo]++;
+    lastState[servo] = state;
+    return true;
+}
+
+// A dependency is met once the servo fired the event it points at and got there.
+// If the servo already fired something later, it got past that event, so that counts too.
+bool Timeline::depMet(uint8_t servo, uint8_t needFired, unsigned long now) const
+{
+    int8_t ahead = (int8_t)(fired[servo] - needFired);
+    if (ahead < 0)
+        return false;
+    if (ahead > 0)
+        return true;
+    return servos[servo].isArrived(now);
+}
+
+// Whether the servo can go now without the supply running out (see Config.h).
+// If nothing is travelling, waiting won't make it draw any less, so it goes anyway.
+bool Timeline::powerAllows(uint8_t servo, uint8_t state, unsigned int drawMa, unsigned long now) const
+{
+    const MyServo& s = servos[servo];
+    bool toStall = state == STATE_L && s.getType() % 2 == 1;
+    if (toStall && s.getState() != STATE_L && s.isOverheated())
+        return false;   // Let the slider cool down before it presses into the cube again
+
+    // A slider going to L keeps drawing once it's there
+    unsigned int after = drawMa - s.currentMa(now) + (toStall ? SERVO_STALL_MA : SERVO_MOVING_MA);
+    return after <= POWER_BUDGET_MA || !anyServoTravelling(now);
+}
+
+void Timeline::dispatch(unsigned long now)
+{
+    unsigned int drawMa = totalCurrentMa(now);
+    bool any = false;
+    for (int s = 0; s < NUM_SERVOS; s++)
+    {
+        // Consecutive events of a servo with nothing to wait for go out together, like "rCrC"
+        while (size[s] > 0)
+        {
+            const TimelineEvent& event = queue[s][head[s]];
+
+            bool ready = true;
+            for (uint8_t i = 0; i < event.depCount && ready; i++)
+                ready = depMet(event.depServo[i], event.depFired[i], now);
+            if (!ready)
+                break;
+
+            if (!powerAllows(s, event.state, drawMa, now))
+            {
+                if (!(heldBack & (1 << s)))
+                    powerStats.waits++;
+                heldBack |= 1 << s;
+                break;
+            }
+            heldBack &= ~(1 << s);
+
+            drawMa -= servos[s].currentMa(now);
+            servos[s].setState((ServoState)event.state);
+            drawMa += servos[s].currentMa(now);
+            fired[s]++;
+            head[s] = (head[s] + 1) % TIMELINE_QUEUE_DEPTH;
+            size[s]--;
+            any = true;
+        }
+    }
+    if (any)
+        lastFire = micros();
+}
+
+bool Timeline::fireStage(uint8_t count, const uint8_t* stageServos, const uint8_t* stageStates, unsigned long nowUs)
+{
+    unsigned long now = millis();
+    unsigned int drawMa = totalCurrentMa(now);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t s = stageServos[i];
+        if (!powerAllows(s, stageStates[i], drawMa, now))
+            return false;   // loop() takes it from here, dispatch() knows how to wait
+        drawMa = drawMa - servos[s].currentMa(now) + SERVO_MOVING_MA;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t s = stageServos[i];
+        servos[s].setState((ServoState)stageStates[i]);
+        scheduled[s]++;
+        fired[s]++;
+        lastState[s] = stageStates[i];
+    }
+    lastFire = nowUs;
+    return true;
+}
+
+bool Timeline::isEmpty() const
+{
+    for (int i = 0; i < NUM_SERVOS; i++)
+    {
+        if (size[i] > 0)
+            return false;
+    }
+    return true;
+}
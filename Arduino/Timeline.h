@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include "Config.h"
+#include "Types.h"
+#include "MyServo.h"
+
+#define TIMELINE_MAX_DEPS 2
+
+// One queued servo command, waiting for its dependencies
+struct TimelineEvent
+{
+    uint8_t state;                          // ServoState to go to
+    uint8_t depCount;                       // Number of dependencies used
+    uint8_t depServo[TIMELINE_MAX_DEPS];    // ServoType the event waits for
+    uint8_t depFired[TIMELINE_MAX_DEPS];    // How many events that servo must have fired (see depMet())
+};
+
+// Per-servo event queues.
+// Each servo runs through its own queue and fires the next event as soon as that event's
+// dependencies are met, independent of what the other servos are doing.
+// A dependency is "servo X has fired a given event and arrived there" (MyServo::isArrived).
+class Timeline
+{
+public:
+    // Forget everything queued and take the servos' current states as the starting point
+    void reset();
+
+    bool canPush(ServoType servo) const { return size[servo] < TIMELINE_QUEUE_DEPTH; }
+
+    // Queue an event. Each dependency is on the latest event queued for that servo so far.
+    // Returns false if the latest event of a dependency doesn't go to the expected state (it would never be met).
+    bool push(ServoType servo, ServoState state, uint8_t depCount, const uint8_t* depServos, const ServoState* depStates);
+
+    // An event that already happened earlier (see SequenceManager::resumeMoves()): nothing is queued,
+    // but dependencies after it go by its state like it was, and wait for the servo to be there
+    void skip(ServoType servo, ServoState state) { lastState[servo] = state; }
+
+    // Events fired so far, wraps around like the counts below
+    uint8_t firedCount(uint8_t servo) const { return fired[servo]; }
+
+    // Fire every event whose dependencies are met
+    void dispatch(unsigned long now);
+
+    // Fire a whole stage right away instead of queueing it, from the stage timer interrupt (see
+    // SequenceManager::armStage()). Only while nothing is queued. All or nothing: if the power budget doesn't
+    // allow every one of them, nothing fires and it returns false
+    bool fireStage(uint8_t count, const uint8_t* stageServos, const uint8_t* stageStates, unsigned long nowUs);
+
+    bool isEmpty() const;
+
+    unsigned long lastFireAt() const { return lastFire; }   // micros()
+
+private:
+    TimelineEvent queue[NUM_SERVOS][TIMELINE_QUEUE_DEPTH];
+    uint8_t head[NUM_SERVOS];
+    uint8_t size[NUM_SERVOS];
+
+    // Running counts of events queued and fired per servo, they wrap around and only their difference matters
+    uint8_t scheduled[NUM_SERVOS];
+    uint8_t fired[NUM_SERVOS];
+    uint8_t lastState[NUM_SERVOS];  // State of the latest queued event, or the current state if nothing is queued
+
+    unsigned long lastFire = 0;
+    uint8_t heldBack = 0;           // Bit per servo, its next event is waiting for power (see powerAllows())
+
+    bool depMet(uint8_t servo, uint8_t needFired, unsigned long now) const;
+    bool powerAllows(uint8_t servo, uint8_t state, unsigned int drawMa, unsigned long now) const;
+};
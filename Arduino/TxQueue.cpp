@@ -0,0 +1,189 @@
+#include "TxQueue.h"
+#include "Config.h"
+#include "SequenceManager.h"
+
+#define TX_SERIAL_ROOM 63   // availableForWrite() of an empty hardware buffer, SERIAL_TX_BUFFER_SIZE - 1
+
+static char eventBuf[TX_EVENT_SIZE];
+static char telemetryBuf[TX_TELEMETRY_SIZE];
+static char verboseBuf[TX_VERBOSE_SIZE];
+
+TxQueue txEvent(eventBuf, TX_EVENT_SIZE, TX_WAIT);
+TxQueue txTelemetry(telemetryBuf, TX_TELEMETRY_SIZE, TX_DROP_OLDEST);
+TxQueue txVerbose(verboseBuf, TX_VERBOSE_SIZE, TX_DROP_NEW);
+
+static TxQueue* sending = nullptr;  // Partly in the hardware buffer, the rest of its line goes before anything else
+static bool telemetryFirst = false; // An event came after a MOVED that is still waiting
+
+void txWaitFor(TxQueue* queue);
+
+size_t TxQueue::write(uint8_t c)
+{
+    if (dropping)
+    {
+        dropping = c != '\n';
+        return 0;
+    }
+    if (count == size && !makeRoom())
+    {
+        // Forget what there is of this line, and the rest of it
+        head = (head + size - lineLength) % size;
+        count -= lineLength;
+        lineLength = 0;
+        dropping = c != '\n';
+        return 0;
+    }
+
+    buf[head] = c;
+    head = (head + 1) % size;
+    count++;
+    lineLength++;
+    if (c == '\n')
+    {
+        lineLength = 0;
+        lines++;
+        if (this == &txEvent && txTelemetry.lines)
+            telemetryFirst = true;
+    }
+    return 1;
+}
+
+size_t TxQueue::print(const char* s)
+{
+    size_t n = 0;
+    while (*s)
+        n += write((uint8_t)*s++);
+    return n;
+}
+
+size_t TxQueue::print(const __FlashStringHelper* s)
+{
+    const char* p = (const char*)s;
+    size_t n = 0;
+    for (uint8_t c; (c = pgm_read_byte(p)) != 0; p++)
+        n += write(c);
+    return n;
+}
+
+size_t TxQueue::print(unsigned long v)
+{
+    char digits[10];
+    uint8_t n = 0;
+    do
+    {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    size_t written = 0;
+    while (n)
+        written += write(digits[--n]);
+    return written;
+}
+
+size_t TxQueue::print(long v)
+{
+    if (v >= 0)
+        return print((unsigned long)v);
+    return write('-') + print(0UL - (unsigned long)v);
+}
+
+// Returns false if the line being written has to go instead
+bool TxQueue::makeRoom()
+{
+    // Whatever fits in the hardware buffer right now makes room for free
+    txDrain();
+    if (count < size)
+        return true;
+
+    if (policy == TX_DROP_OLDEST && lines > 0 && sending != this)
+    {
+        uint8_t n = firstLineLength();
+        tail = (tail + n) % size;
+        count -= n;
+        lines--;
+        return true;
+    }
+    // Once some of the line went out, the rest has to follow
+    if (policy == TX_DROP_NEW && seqManager.isBusy() && sending != this)
+        return false;
+
+    txWaitFor(this);
+    return true;
+}
+
+uint8_t TxQueue::firstLineLength() const
+{
+    uint8_t n = 0;
+    while (n < count && buf[(tail + n) % size] != '\n')
+        n++;
+    return n < count ? n + 1 : n;
+}
+
+uint8_t TxQueue::pop()
+{
+    uint8_t c = buf[tail];
+    tail = (tail + 1) % size;
+    if (count == lineLength)
+        lineLength--;   // Already sending the line that is being written
+    count--;
+    if (c == '\n')
+        lines--;
+    return c;
+}
+
+void txDrain()
+{
+    int room = Serial.availableForWrite();
+    for (;;)
+    {
+        if (!sending)
+        {
+            if (!telemetryFirst || !txTelemetry.lines)
+            {
+                telemetryFirst = false;
+                sending = txEvent.lines ? &txEvent : txTelemetry.lines ? &txTelemetry : txVerbose.lines ? &txVerbose : nullptr;
+            }
+            else
+                sending = &txTelemetry;
+            if (!sending)
+                return;
+
+            // A line longer than the whole hardware buffer starts once that's empty, the rest follows as it makes room
+            uint8_t n = sending->firstLineLength();
+            if (n > room && room < TX_SERIAL_ROOM)
+            {
+                sending = nullptr;
+                return;
+            }
+        }
+
+        while (room > 0 && sending->count > 0)
+        {
+            uint8_t c = sending->pop();
+            Serial.write(c);
+            room--;
+            if (c == '\n')
+            {
+                sending = nullptr;
+                break;
+            }
+        }
+        if (sending)
+            return;     // Out of room, or the rest of the line isn't written yet
+    }
+}
+
+// Only when there's nothing else for it (see TxPolicy), like Serial.write() with a full buffer
+void txWaitFor(TxQueue* queue)
+{
+    while (queue->count == queue->size)
+    {
+        // All that's left in it is the line being written, that has to go out the way it is
+        if (!sending && queue->lines == 0)
+            sending = queue;
+        txDrain();
+        if (queue->count == queue->size)
+            Serial.flush();     // Nothing went, wait for the hardware buffer to empty
+    }
+}
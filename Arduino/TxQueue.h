@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+
+// Serial output that never makes loop() wait. Serial.println() blocks once the 64 byte hardware buffer is
+// full, which at 9600 baud is a millisecond per character, so a HELP or POWER in the middle of a sequence
+// would hold up the next servo by a tenth of a second. Instead lines go into one of three small queues, and
+// txDrain() moves whole lines into the hardware buffer between ticks, as much as fits right then.
+//
+//   txEvent       BUSY/IDLE, SEQ ERR and the replies to commands, the host waits for these. Go out first
+//   txTelemetry   MOVED, the newest one says it all, so when it's full the oldest line is dropped
+//   txVerbose     HELP, POWER and other text for people. Go out last, while the robot is busy a line that
+//                 doesn't fit is dropped
+//
+// Only a line that doesn't fit while nothing is moving waits (or an event that doesn't fit at all, that takes
+// a host that sends commands without reading the replies). Lines of one queue stay in order, and an event
+// never overtakes a MOVED that was there before it, so the last MOVED still comes before IDLE.
+// The sizes are in Config.h (TX_*_SIZE), a queue must fit the longest line it gets or that line waits.
+
+enum TxPolicy
+{
+    TX_WAIT,            // Wait for room
+    TX_DROP_OLDEST,     // Drop whole lines from the front
+    TX_DROP_NEW         // Drop the line that doesn't fit, unless nothing is moving
+};
+
+class TxQueue
+{
+public:
+    TxQueue(char* buffer, uint8_t size, TxPolicy policy) : buf(buffer), size(size), policy(policy) {}
+
+    size_t write(uint8_t c);
+    size_t print(const char* s);
+    size_t print(const __FlashStringHelper* s);     // F("..."), read from flash
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned int v) { return print((unsigned long)v); }
+    size_t print(long v);
+    size_t print(unsigned long v);
+    template <typename T>
+    size_t println(T v)
+    {
+        return print(v) + println();
+    }
+    size_t println() { return print("\r\n"); }   // The line can go out from here on
+
+    uint8_t lines = 0;      // Whole lines waiting
+
+private:
+    char* buf;
+    uint8_t size;
+    TxPolicy policy;
+    uint8_t head = 0, tail = 0, count = 0;
+    uint8_t lineLength = 0;     // Of the line being written, it is at the end
+    bool dropping = false;      // Skipping the rest of a dropped line
+
+    bool makeRoom();
+    uint8_t firstLineLength() const;
+    uint8_t pop();
+
+    friend void txDrain();
+    friend void txWaitFor(TxQueue* queue);
+};
+
+extern TxQueue txEvent, txTelemetry, txVerbose;
+
+// From loop(), moves whole lines into Serial's buffer while they fit, never waits
+void txDrain();
@@ -26,6 +26,9 @@ struct ServoCal {
     unsigned int R_us;
     unsigned int C_us;
     unsigned int CD_us; // Deviation for center position for spinners
+    unsigned int speed;     // Travel speed in pulse microseconds per millisecond
+    unsigned int settleMs;  // Time for the horn to stop wobbling after reaching its target
+    unsigned int accel;     // Ramp acceleration in (us per ms) per second, 0 = jump straight to the target
 };
 
 enum CubeOrientation
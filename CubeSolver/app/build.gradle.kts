@@ -39,6 +39,11 @@ android {
     buildFeatures {
         compose = true
     }
+    externalNativeBuild {
+        ndkBuild {
+            path = file("src/main/jni/Android.mk")
+        }
+    }
 }
 
 dependencies {
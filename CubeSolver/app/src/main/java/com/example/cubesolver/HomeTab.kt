@@ -280,6 +280,11 @@ fun HomeTab(
 }
 
 fun parseCubeNotation(solution: String): String {
+    // Same parser as the rest of the project (Arduino/MoveCore.h), the Kotlin one below if it's not in the APK
+    if (NativeMoves.available) {
+        NativeMoves.parseNotation(solution)?.let { return it }
+    }
+
     val moves = StringBuilder()
     val rawMoves = solution.split(" ")
 
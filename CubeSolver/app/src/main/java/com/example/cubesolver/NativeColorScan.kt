@@ -0,0 +1,21 @@
+package com.example.cubesolver.tabs
+
+/* ===================== NATIVE COLOR SCAN ===================== */
+
+// Sticker sampling and color classification in C++ (Host/Scan/ColorScan.cpp, built from app/src/main/jni).
+// If the library isn't in the APK, ScanTab falls back to the Kotlin code.
+object NativeColorScan {
+    val available: Boolean = try {
+        System.loadLibrary("colorscan")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+
+    // Average r, g, b (0..255) of the 9 stickers of a face photo, like sampleFaceColorsRaw()
+    external fun sampleFace(pixels: IntArray, width: Int, height: Int, sampleScale: Float): FloatArray?
+
+    // r, g, b of all 54 stickers (the center of face f at 9 * f + 4) -> the face whose center each one matches,
+    // exactly 9 per face
+    external fun classifyStickers(colors: FloatArray): IntArray?
+}
@@ -0,0 +1,34 @@
+package com.example.cubesolver.tabs
+
+/* ===================== NATIVE MOVES ===================== */
+
+// The firmware's own move templates (Arduino/MoveCore.h) and the schedule compiler (Host/Solver/ScheduleCompiler.h),
+// built from app/src/main/jni. The app expands and plans moves exactly like the robot does, instead of keeping a
+// copy of the templates in sync by hand. If the library isn't in the APK, the Kotlin code is used instead.
+object NativeMoves {
+    val available: Boolean = try {
+        System.loadLibrary("movecore")
+        true
+    } catch (e: UnsatisfiedLinkError) {
+        false
+    }
+
+    // "U R2 F'" -> "URRf", what MOVE takes. null if it isn't notation
+    external fun parseNotation(solution: String): String?
+
+    // The servo sequence MOVE <delayMs> <orientation> <moves> runs on the robot (orientation 0 normal, 1 inverted,
+    // delay 0 waits for the servos), null on a character that isn't a move
+    external fun expand(moves: String, orientation: Int, delayMs: Int): String?
+
+    // The orientation the cube is in after the moves, -1 on a character that isn't a move
+    external fun endOrientation(moves: String, orientation: Int): Int
+
+    // The SEQ commands that flip the cube from one orientation to the other, with delayMs after every stage.
+    // Empty if it is there already
+    external fun rotateCube(orientation: Int, newOrientation: Int, delayMs: Int): String?
+
+    // The moves as one timed servo program like cubesched makes: send the first with "SEQ <part> +", the rest
+    // with "APPEND <part> +" (the last without +). calibrations are L, R, C, CD, speed, settle, accel for each of
+    // the 8 servos (ServoType order, like the p table of calibration mode), null for the firmware defaults
+    external fun schedule(moves: String, orientation: Int, calibrations: IntArray?): Array<String>?
+}
@@ -252,7 +252,7 @@ fun ScanTab(
 
 fun processCubeImages(images: List<Bitmap>): List<List<CubeColor>> {
     val rawFaces: List<List<Color>> = images.map { faceBitmap ->
-        val sampled = sampleFaceColorsRaw(faceBitmap)
+        val sampled = sampleFaceColorsNative(faceBitmap) ?: sampleFaceColorsRaw(faceBitmap)
 
         // Rotate the sampled tiles 45° clockwise to correct the orientation
         val rotateMap = listOf(6, 3, 0, 7, 4, 1, 8, 5, 2)
@@ -269,6 +269,11 @@ fun processCubeImages(images: List<Bitmap>): List<List<CubeColor>> {
         availableColors.remove(closest)
     }
 
+    // Native: all 54 stickers split into 6 groups of 9 around the centers at once
+    classifyStickersNative(rawFaces)?.let { groups ->
+        return rawFaces.indices.map { f -> (0..8).map { t -> centerCubeColors[groups[9 * f + t]] } }
+    }
+
     // Step 2: prepare tile list (excluding centers)
     data class Tile(val faceIndex: Int, val tileIndex: Int, val color: Color)
     val tiles = mutableListOf<Tile>()
@@ -353,6 +358,29 @@ fun sampleFaceColorsRaw(bitmap: Bitmap): List<Color> {
     return colors
 }
 
+// Same as sampleFaceColorsRaw(), in C++ with SIMD. Null if the native library isn't there
+fun sampleFaceColorsNative(bitmap: Bitmap): List<Color>? {
+    if (!NativeColorScan.available) return null
+    val pixels = IntArray(bitmap.width * bitmap.height)
+    bitmap.getPixels(pixels, 0, bitmap.width, 0, 0, bitmap.width, bitmap.height)
+    val rgb = NativeColorScan.sampleFace(pixels, bitmap.width, bitmap.height, 0.4f) ?: return null
+    return (0..8).map { Color(rgb[3 * it] / 255f, rgb[3 * it + 1] / 255f, rgb[3 * it + 2] / 255f) }
+}
+
+fun classifyStickersNative(faces: List<List<Color>>): IntArray? {
+    if (!NativeColorScan.available || faces.size != 6) return null
+    val rgb = FloatArray(54 * 3)
+    for ((f, face) in faces.withIndex()) {
+        for ((t, c) in face.withIndex()) {
+            val i = 3 * (9 * f + t)
+            rgb[i] = c.red * 255f
+            rgb[i + 1] = c.green * 255f
+            rgb[i + 2] = c.blue * 255f
+        }
+    }
+    return NativeColorScan.classifyStickers(rgb)
+}
+
 fun averageColor(bmp: Bitmap, x: Int, y: Int, w: Int, h: Int): Color {
     var r = 0L
     var g = 0L
@@ -476,6 +504,12 @@ fun CubeGridOverlay() {
 /* ===================== ROBOT ===================== */
 
 private fun rotateCube(newOrientation: String, movesDelayMs: Int): String {
+    // The firmware's own template (Arduino/MoveCore.h). Here the cube is always in the other orientation
+    if (NativeMoves.available) {
+        val to = if (newOrientation == "INVERT") 1 else 0
+        NativeMoves.rotateCube(1 - to, to, movesDelayMs)?.let { return it }
+    }
+
     val sb = StringBuilder()
 
     // RIGHT and LEFT grab
@@ -0,0 +1,15 @@
+# Native color scanning (see Host/Scan/ColorScan.h), built by gradle through ndk-build
+LOCAL_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := colorscan
+LOCAL_SRC_FILES := ColorScanJni.cpp ../../../../../Host/Scan/ColorScan.cpp
+LOCAL_CPPFLAGS := -std=c++17 -O2
+include $(BUILD_SHARED_LIBRARY)
+
+# Move templates of the firmware (Arduino/MoveCore.h) and the schedule compiler, for NativeMoves.kt
+include $(CLEAR_VARS)
+LOCAL_MODULE := movecore
+LOCAL_SRC_FILES := MoveCoreJni.cpp ../../../../../Host/Solver/ScheduleCompiler.cpp
+LOCAL_CPPFLAGS := -std=c++17 -O2
+include $(BUILD_SHARED_LIBRARY)
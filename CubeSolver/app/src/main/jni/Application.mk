@@ -0,0 +1,4 @@
+# NEON is always there on arm64-v8a, on armeabi-v7a the NDK turns it on by default
+APP_ABI := armeabi-v7a arm64-v8a x86 x86_64
+APP_STL := c++_static
+APP_PLATFORM := android-24
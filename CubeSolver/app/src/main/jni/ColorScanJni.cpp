@@ -0,0 +1,40 @@
+// JNI side of NativeColorScan.kt, the work is done by Host/Scan/ColorScan.cpp
+
+#include <jni.h>
+#include "../../../../../Host/Scan/ColorScan.h"
+
+extern "C" JNIEXPORT jfloatArray JNICALL
+Java_com_example_cubesolver_tabs_NativeColorScan_sampleFace(JNIEnv* env, jobject, jintArray pixels, jint width,
+                                                             jint height, jfloat sampleScale)
+{
+    if (env->GetArrayLength(pixels) < width * height)
+        return nullptr;
+    ScanColor colors[9];
+    // Critical, so the bitmap isn't copied. Nothing in here calls back into java
+    void* data = env->GetPrimitiveArrayCritical(pixels, nullptr);
+    if (!data)
+        return nullptr;
+    sampleFace(static_cast<const uint32_t*>(data), width, height, width, sampleScale, colors);
+    env->ReleasePrimitiveArrayCritical(pixels, data, JNI_ABORT);
+
+    jfloatArray result = env->NewFloatArray(27);
+    if (result)
+        env->SetFloatArrayRegion(result, 0, 27, reinterpret_cast<const jfloat*>(colors));
+    return result;
+}
+
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_example_cubesolver_tabs_NativeColorScan_classifyStickers(JNIEnv* env, jobject, jfloatArray colors)
+{
+    if (env->GetArrayLength(colors) != 54 * 3)
+        return nullptr;
+    ScanColor stickers[54];
+    env->GetFloatArrayRegion(colors, 0, 54 * 3, reinterpret_cast<jfloat*>(stickers));
+    int faces[54];
+    classifyStickers(stickers, faces);
+
+    jintArray result = env->NewIntArray(54);
+    if (result)
+        env->SetIntArrayRegion(result, 0, 54, reinterpret_cast<const jint*>(faces));
+    return result;
+}
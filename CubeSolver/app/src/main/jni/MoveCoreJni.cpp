@@ -0,0 +1,124 @@
+// JNI side of NativeMoves.kt: the firmware's move templates (Arduino/MoveCore.h) and the schedule compiler
+// (Host/Solver/ScheduleCompiler.cpp), so the app plans with exactly what the robot will do
+
+#include <jni.h>
+#include <string>
+#include <vector>
+#include "../../../../../Arduino/MoveCore.h"
+#include "../../../../../Arduino/CalStore.h"
+#include "../../../../../Host/Solver/ScheduleCompiler.h"
+
+#define CAL_FIELDS 7    // L, R, C, CD, speed, settle, accel per servo, like CalRecord
+
+static std::string fromJava(JNIEnv* env, jstring s)
+{
+    const char* chars = env->GetStringUTFChars(s, nullptr);
+    if (!chars)
+        return "";
+    std::string out = chars;
+    env->ReleaseStringUTFChars(s, chars);
+    return out;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_cubesolver_tabs_NativeMoves_parseNotation(JNIEnv* env, jobject, jstring solution)
+{
+    std::string text = fromJava(env, solution);
+    std::vector<char> moves(text.size() + 1);   // Never longer, "U2" is "UU"
+    if (!parseNotation(text.c_str(), moves.data(), moves.size()))
+        return nullptr;
+    return env->NewStringUTF(moves.data());
+}
+
+// What MOVE <delayMs> <orientation> <moves> puts into activeSequence, one move after the other
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_cubesolver_tabs_NativeMoves_expand(JNIEnv* env, jobject, jstring moves, jint orientation, jint delayMs)
+{
+    std::string text = fromJava(env, moves);
+    CubeOrientation current = orientation ? ORIENT_INVERT : ORIENT_NORMAL;
+    char delayToken[MOVE_DELAY_TOKEN_SIZE];
+    moveDelayToken(delayToken, delayMs);
+    std::string out;
+    for (char c : text)
+    {
+        char buf[SEQUENCE_BUFFER_SIZE] = "";
+        bool ok = delayMs > 0 ? appendMove(buf, sizeof(buf), current, c, delayToken)
+                              : appendMoveDeps(buf, sizeof(buf), current, c);
+        if (!ok)
+            return nullptr;
+        out += buf;
+    }
+    return env->NewStringUTF(out.c_str());
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_example_cubesolver_tabs_NativeMoves_endOrientation(JNIEnv* env, jobject, jstring moves, jint orientation)
+{
+    int current = orientation;
+    for (char c : fromJava(env, moves))
+    {
+        if (!moveSpinner(c))
+            return -1;
+        int needed = moveNeedsOrientation(c);
+        if (needed >= 0)
+            current = needed;
+    }
+    return current;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_cubesolver_tabs_NativeMoves_rotateCube(JNIEnv* env, jobject, jint orientation, jint newOrientation,
+                                                         jint delayMs)
+{
+    CubeOrientation current = orientation ? ORIENT_INVERT : ORIENT_NORMAL;
+    char delayToken[MOVE_DELAY_TOKEN_SIZE];
+    moveDelayToken(delayToken, delayMs);
+    char buf[SEQUENCE_BUFFER_SIZE] = "";
+    if (!appendRotateCube(buf, sizeof(buf), current, newOrientation ? ORIENT_INVERT : ORIENT_NORMAL, delayToken))
+        return nullptr;
+    return env->NewStringUTF(buf);
+}
+
+// The whole solution as one timed program, split into "SEQ <first> +" and APPEND parts (see cubesched).
+// calibrations has CAL_FIELDS per servo in ServoType order, null for the firmware's defaults
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_cubesolver_tabs_NativeMoves_schedule(JNIEnv* env, jobject, jstring moves, jint orientation,
+                                                       jintArray calibrations)
+{
+    ServoCal cal[SCHEDULE_SERVOS];
+    for (int i = 0; i < SCHEDULE_SERVOS; i++)
+    {
+        cal[i] = {CALSTORE_DEFAULT_L_US, CALSTORE_DEFAULT_R_US, CALSTORE_DEFAULT_C_US, 0,
+                  CALSTORE_DEFAULT_SPEED, CALSTORE_DEFAULT_SETTLE_MS, CALSTORE_DEFAULT_ACCEL};
+    }
+    if (calibrations)
+    {
+        if (env->GetArrayLength(calibrations) != SCHEDULE_SERVOS * CAL_FIELDS)
+            return nullptr;
+        jint values[SCHEDULE_SERVOS * CAL_FIELDS];
+        env->GetIntArrayRegion(calibrations, 0, SCHEDULE_SERVOS * CAL_FIELDS, values);
+        for (int i = 0; i < SCHEDULE_SERVOS; i++)
+        {
+            const jint* v = values + i * CAL_FIELDS;
+            cal[i] = {(unsigned)v[0], (unsigned)v[1], (unsigned)v[2], (unsigned)v[3],
+                      (unsigned)v[4], (unsigned)v[5], (unsigned)v[6]};
+        }
+    }
+
+    Schedule schedule;
+    std::string error;
+    if (!compileSchedule(fromJava(env, moves), orientation, cal, schedule, error))
+        return nullptr;
+    std::vector<std::string> parts = scheduleSequences(schedule, SEQUENCE_BUFFER_SIZE / 2);
+
+    jobjectArray result = env->NewObjectArray((jsize)parts.size(), env->FindClass("java/lang/String"), nullptr);
+    if (!result)
+        return nullptr;
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        jstring part = env->NewStringUTF(parts[i].c_str());
+        env->SetObjectArrayElement(result, (jsize)i, part);
+        env->DeleteLocalRef(part);
+    }
+    return result;
+}
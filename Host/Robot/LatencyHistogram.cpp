@@ -0,0 +1,134 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define EXACT_US 256        // Below this every microsecond has its own bucket
+#define SUB_BUCKETS 128     // Buckets per power of two above that, so a bucket is at most 1/128 of its values
+#define SUB_BITS 7
+
+static size_t bucketOf(uint64_t us)
+{
+    if (us < EXACT_US)
+        return (size_t)us;
+    int top = 63;
+    while (!(us >> top))
+        top--;
+    return EXACT_US + (size_t)(top - 8) * SUB_BUCKETS + (size_t)((us >> (top - SUB_BITS)) - SUB_BUCKETS);
+}
+
+// The highest value that goes in the bucket, in us
+static uint64_t bucketTop(size_t bucket)
+{
+    if (bucket < EXACT_US)
+        return bucket;
+    size_t i = bucket - EXACT_US;
+    int shift = (int)(i / SUB_BUCKETS) + 8 - SUB_BITS;
+    uint64_t lowest = (uint64_t)(i % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(double ms, uint64_t times)
+{
+    if (times == 0)
+        return;
+    uint64_t us = ms > 0 ? (uint64_t)std::llround(ms * 1000) : 0;
+    size_t bucket = bucketOf(us);
+    if (bucket >= counts.size())
+        counts.resize(bucket + 1, 0);
+    counts[bucket] += times;
+    total += times;
+    sum += ms * times;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+    if (other.counts.size() > counts.size())
+        counts.resize(other.counts.size(), 0);
+    for (size_t i = 0; i < other.counts.size(); i++)
+        counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if (total == 0)
+        return 0;
+    uint64_t rank = (uint64_t)std::ceil(p / 100 * total);
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return bucketTop(i) / 1000.0;
+    }
+    return bucketTop(counts.size() - 1) / 1000.0;
+}
+
+void LatencyHistogram::write(std::string& out, const std::string& name, const std::string& labels) const
+{
+    std::string sep = labels.empty() ? "" : ",";
+    char line[512];
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++)
+    {
+        if (!counts[i])
+            continue;
+        seen += counts[i];
+        std::snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%.3f\"} %llu\n", name.c_str(), labels.c_str(), sep.c_str(),
+                      bucketTop(i) / 1000.0, (unsigned long long)seen);
+        out += line;
+    }
+    std::snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %llu\n%s_sum{%s} %.3f\n%s_count{%s} %llu\n",
+                  name.c_str(), labels.c_str(), sep.c_str(), (unsigned long long)total,
+                  name.c_str(), labels.c_str(), sum, name.c_str(), labels.c_str(), (unsigned long long)total);
+    out += line;
+}
+
+bool readHistograms(std::istream& in, const std::string& name, std::map<std::string, LatencyHistogram>& out)
+{
+    std::map<std::string, LatencyHistogram> read;
+    std::map<std::string, uint64_t> cumulative;     // Bucket lines count everything up to them
+    std::map<std::string, double> sums;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.compare(0, name.size(), name) != 0)
+            continue;
+        size_t open = line.find('{'), close = line.find('}');
+        if (open == std::string::npos || close == std::string::npos || close < open)
+            continue;
+        std::string suffix = line.substr(name.size(), open - name.size());
+        std::string labels = line.substr(open + 1, close - open - 1);
+        double value = std::atof(line.c_str() + close + 1);
+
+        if (suffix == "_bucket")
+        {
+            size_t le = labels.find("le=\"");
+            if (le == std::string::npos)
+                continue;
+            std::string bound = labels.substr(le + 4, labels.find('"', le + 4) - le - 4);
+            labels.erase(le > 0 && labels[le - 1] == ',' ? le - 1 : le);    // le is the last label
+            uint64_t count = (uint64_t)std::llround(value);
+            uint64_t before = cumulative[labels];
+            cumulative[labels] = bound == "+Inf" ? 0 : count;   // After +Inf the same labels can come again, from another scrape
+            LatencyHistogram& h = read[labels];
+            if (bound != "+Inf" && count > before)
+                h.record(std::atof(bound.c_str()), count - before);
+        }
+        else if (suffix == "_sum")
+        {
+            sums[labels] += value;
+        }
+    }
+    for (auto& entry : read)
+    {
+        if (sums.count(entry.first))
+            entry.second.sum = sums[entry.first];   // Exact, not the bucket tops record() added up
+        out[entry.first].add(entry.second);
+    }
+    return !read.empty();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Latencies the way HdrHistogram keeps them: a count per bucket, with buckets that get wider as the values get
+// bigger, so every value is kept to within 1% whether it's a 2ms serial round trip or a 40s solve, in a fixed
+// amount of memory and without keeping the values themselves. Values are microseconds inside, below 256us every
+// one has its own bucket, above that every power of two is split into 128 buckets.
+//
+// Two histograms add up exactly (same buckets), so runs on different robots or different days can be merged
+// afterwards, which percentiles of their own can't.
+class LatencyHistogram
+{
+public:
+    void record(double ms, uint64_t times = 1);
+    void add(const LatencyHistogram& other);
+
+    uint64_t count() const { return total; }
+    double sumMs() const { return sum; }
+    double meanMs() const { return total ? sum / total : 0; }
+    double percentile(double p) const;      // 0..100, in ms. The top of the bucket it falls in, like HdrHistogram
+    double maxMs() const { return percentile(100); }
+
+    // The text format Prometheus scrapes (and a node_exporter textfile): name_bucket{labels,le="<ms>"} with the
+    // count up to there, for every bucket that has any, then +Inf, name_sum and name_count. labels like
+    // robot="0",phase="solve", the # TYPE line is up to the caller
+    void write(std::string& out, const std::string& name, const std::string& labels) const;
+
+private:
+    std::vector<uint64_t> counts;   // Grows to the highest bucket used
+    uint64_t total = 0;
+    double sum = 0;
+
+    friend bool readHistograms(std::istream& in, const std::string& name, std::map<std::string, LatencyHistogram>& out);
+};
+
+// Reads what write() wrote, for every set of labels (without le) found under name. Histograms that are already
+// in out are added to, so several files (or scrapes) merge. False if nothing of name was in it
+bool readHistograms(std::istream& in, const std::string& name, std::map<std::string, LatencyHistogram>& out);
@@ -0,0 +1,707 @@
+#include "RobotDaemon.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "../Solver/Moves.h"
+#include "../Solver/RobotCost.h"
+
+#define KEEP_FINISHED_JOBS 10000
+#define MAX_SCRAMBLE 30     // 60 characters at most, the arduino's MOVE buffer is 64
+#define TIMING_DECAY 0.95   // Every run counts this much less than the one after it
+#define SOLVE_STAGES 100    // A typical solution, until there are some to go by
+
+using Clock = Job::Clock;
+
+static double msBetween(Clock::time_point a, Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+const char* jobStateName(Job::State state)
+{
+    static const char* names[] = {"QUEUED", "SOLVING", "READY", "RUNNING", "DONE", "FAILED", "CANCELLED"};
+    return names[state];
+}
+
+const char* jobKindName(Job::Kind kind)
+{
+    static const char* names[] = {"solve", "moves", "seq"};
+    return names[kind];
+}
+
+const char* jobPhaseName(JobPhase phase)
+{
+    static const char* names[] = {"capture", "classify", "queue", "solve", "send", "execute", "total"};
+    return names[phase];
+}
+
+void StageTiming::add(int stages, double ms)
+{
+    n = n * TIMING_DECAY + 1;
+    x = x * TIMING_DECAY + stages;
+    y = y * TIMING_DECAY + ms;
+    xx = xx * TIMING_DECAY + (double)stages * stages;
+    xy = xy * TIMING_DECAY + stages * ms;
+    count++;
+}
+
+double StageTiming::stageMs() const
+{
+    if (count == 0)
+        return ROBOT_WAIT_STAGE_MS;
+    // With runs of different lengths the start up time falls out of the fit, otherwise assume the usual one
+    double det = n * xx - x * x;
+    if (count >= 2 && det > 1e-3 * n * n)
+    {
+        double slope = (n * xy - x * y) / det;
+        if (slope > 0)
+            return slope;
+    }
+    return x > 0 ? std::max(1.0, (y - ROBOT_START_MS * n) / x) : ROBOT_WAIT_STAGE_MS;
+}
+
+double StageTiming::predict(double stages) const
+{
+    if (stages <= 0)
+        return 0;
+    if (count == 0)
+        return ROBOT_START_MS + ROBOT_WAIT_STAGE_MS * stages;
+    double slope = stageMs();
+    double start = (y - slope * x) / n;
+    return std::max(0.0, start + slope * stages);
+}
+
+RobotDaemon::RobotDaemon(RobotLink& robot, const DaemonOptions& options)
+    : robot(robot), opt(options), nextId(options.firstId), orientation(options.orientation), startTime(Clock::now())
+{
+    solver = std::thread(&RobotDaemon::solverLoop, this);
+    runner = std::thread(&RobotDaemon::runnerLoop, this);
+}
+
+RobotDaemon::~RobotDaemon()
+{
+    stop();
+}
+
+void RobotDaemon::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    changed.notify_all();
+    if (solver.joinable())
+        solver.join();
+    if (runner.joinable())
+        runner.join();
+}
+
+// With the lock held
+int RobotDaemon::add(Job job)
+{
+    job.id = nextId;
+    nextId += opt.idStep;
+    job.queued = Clock::now();
+    if (job.delayMs < 0)
+        job.delayMs = opt.delayMs;
+    order.push_back(job.id);
+    jobs[job.id] = job;
+    trim();
+    changed.notify_all();
+    return job.id;
+}
+
+int RobotDaemon::solve(const std::string& facelets, int delayMs, std::string& error, double captureMs, double classifyMs)
+{
+    Job job;
+    job.kind = Job::SOLVE;
+    job.delayMs = delayMs;
+    job.captureMs = captureMs;
+    job.classifyMs = classifyMs;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (facelets.empty())
+    {
+        if (!tailKnown)
+        {
+            error = "cube unknown";
+            return 0;
+        }
+        job.cube = tail;
+    }
+    else
+    {
+        int code = job.cube.fromFacelets(facelets);
+        if (code)
+        {
+            error = std::to_string(code) + " " + CubieCube::errorText(code);
+            return 0;
+        }
+    }
+    tail = CubieCube();
+    tailKnown = true;
+    return add(job);
+}
+
+int RobotDaemon::moves(const std::string& robotMoves, int delayMs, std::string& error)
+{
+    std::vector<int> parsed;
+    if (!parseRobotMoves(robotMoves, parsed))
+    {
+        error = "moves";
+        return 0;
+    }
+    Job job;
+    job.kind = Job::MOVES;
+    job.state = Job::READY;
+    job.moves = robotMoves;
+    job.delayMs = delayMs;
+    std::lock_guard<std::mutex> lock(mutex);
+    tail.applyMoves(parsed);
+    return add(job);
+}
+
+int RobotDaemon::sequence(const std::string& seq, std::string& error)
+{
+    if (seq.empty())
+    {
+        error = "sequence";
+        return 0;
+    }
+    Job job;
+    job.kind = Job::SEQUENCE;
+    job.state = Job::READY;
+    job.moves = seq;
+    std::lock_guard<std::mutex> lock(mutex);
+    tailKnown = false;  // Could be anything
+    return add(job);
+}
+
+int RobotDaemon::scramble(int length, int delayMs, std::string& error)
+{
+    if (length < 1 || length > MAX_SCRAMBLE)
+    {
+        error = "length";
+        return 0;
+    }
+    std::vector<int> scramble;
+    std::lock_guard<std::mutex> lock(mutex);
+    while ((int)scramble.size() < length)
+    {
+        int m = (int)(rng() % N_MOVES);
+        if (!scramble.empty() && m / 3 == scramble.back() / 3)
+            continue;
+        scramble.push_back(m);
+    }
+    Job job;
+    job.kind = Job::MOVES;
+    job.state = Job::READY;
+    job.moves = movesToRobot(scramble);
+    job.delayMs = delayMs;
+    tail.applyMoves(scramble);
+    return add(job);
+}
+
+bool RobotDaemon::cancel(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = jobs.find(id);
+    if (it == jobs.end() || it->second.isFinished())
+        return false;
+    Job& job = it->second;
+    if (job.state == Job::RUNNING)
+    {
+        job.cancelRequested = true;     // The runner stops the robot
+    }
+    else
+    {
+        job.state = Job::CANCELLED;
+        job.finished = Clock::now();
+        cancelledCount++;
+        order.erase(std::find(order.begin(), order.end(), id));
+        tailKnown = false;      // Whatever it would have done is missing now
+    }
+    changed.notify_all();
+    return true;
+}
+
+bool RobotDaemon::wait(int id, Job& job, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    bool done = changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]()
+    {
+        auto it = jobs.find(id);
+        return it == jobs.end() || it->second.isFinished();
+    });
+    auto it = jobs.find(id);
+    if (!done || it == jobs.end())
+        return false;
+    job = it->second;
+    return true;
+}
+
+std::string RobotDaemon::status()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int queued = 0;
+    std::string solving = "-", running = "-";
+    for (int id : order)
+    {
+        const Job& job = jobs[id];
+        if (job.state == Job::SOLVING)
+            solving = std::to_string(id);
+        else if (job.state == Job::RUNNING)
+            running = std::to_string(id);
+        else
+            queued++;
+    }
+    char line[256];
+    std::snprintf(line, sizeof(line), "queued=%d solving=%s running=%s done=%d failed=%d cancelled=%d link=%s orientation=%s",
+                  queued, solving.c_str(), running.c_str(), doneCount, failedCount, cancelledCount,
+                  linkUp ? "up" : "down", orientation < 0 ? "?" : std::to_string(orientation).c_str());
+    return line;
+}
+
+DaemonStats RobotDaemon::counters()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    DaemonStats st;
+    st.jobs = doneCount;
+    st.solves = solveCount;
+    st.uptimeMs = msBetween(startTime, Clock::now());
+    st.runMs = runMs;
+    st.solveMs = solveMs;
+    st.waitMs = waitMs;
+    st.stageMs = timing.stageMs();
+    st.predictErrorMs = predictCount ? predictErrorMs / predictCount : 0.0;
+    return st;
+}
+
+std::string RobotDaemon::stats()
+{
+    DaemonStats st = counters();
+    char line[256];
+    std::snprintf(line, sizeof(line), "jobs=%d per_min=%.1f robot_busy=%.0f%% run_ms_avg=%.0f solve_ms_avg=%.0f waited_for_solver_ms=%.0f "
+                  "stage_ms=%.0f predict_err_ms_avg=%.0f",
+                  st.jobs, st.uptimeMs > 0 ? st.jobs * 60000.0 / st.uptimeMs : 0.0, st.uptimeMs > 0 ? 100 * st.runMs / st.uptimeMs : 0.0,
+                  st.jobs ? st.runMs / st.jobs : 0.0, st.solves ? st.solveMs / st.solves : 0.0, st.waitMs,
+                  st.stageMs, st.predictErrorMs);
+    return line;
+}
+
+void RobotDaemon::histograms(LatencyHistogram out[Job::N_KINDS][N_PHASES])
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int k = 0; k < Job::N_KINDS; k++)
+    {
+        for (int p = 0; p < N_PHASES; p++)
+            out[k][p] = phases[k][p];
+    }
+}
+
+// With the lock held, once the job is DONE
+void RobotDaemon::recordPhases(const Job& job)
+{
+    LatencyHistogram* h = phases[job.kind];
+    double scanMs = 0;      // Before the daemon got it
+    if (job.captureMs >= 0)
+    {
+        h[PHASE_CAPTURE].record(job.captureMs);
+        scanMs += job.captureMs;
+    }
+    if (job.classifyMs >= 0)
+    {
+        h[PHASE_CLASSIFY].record(job.classifyMs);
+        scanMs += job.classifyMs;
+    }
+    if (job.kind == Job::SOLVE)
+    {
+        h[PHASE_QUEUE].record(msBetween(job.queued, job.solving) + msBetween(job.solved, job.started));
+        h[PHASE_SOLVE].record(msBetween(job.solving, job.solved));
+    }
+    else
+    {
+        h[PHASE_QUEUE].record(msBetween(job.queued, job.started));
+    }
+    // Nothing went to the robot for a cube that was solved already
+    if (job.busy >= job.started && job.idle >= job.busy)
+    {
+        h[PHASE_SEND].record(msBetween(job.started, job.busy));
+        h[PHASE_EXECUTE].record(msBetween(job.busy, job.idle));
+    }
+    h[PHASE_TOTAL].record(scanMs + msBetween(job.queued, job.finished));
+}
+
+bool RobotDaemon::isLinkUp()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return linkUp;
+}
+
+bool RobotDaemon::wantsSample()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return timing.runs() == 0 && order.empty();
+}
+
+// With the lock held
+double RobotDaemon::averageSolveMs() const
+{
+    return solveCount ? solveMs / solveCount : (double)opt.searchMs;
+}
+
+// With the lock held. How long the robot will take for the job, orientation goes along like in robotStages()
+double RobotDaemon::predictRun(const Job& job, int& orientation)
+{
+    double stages;
+    if (job.kind == Job::SEQUENCE)
+    {
+        stages = (double)job.moves.size();  // Roughly a stage per step
+    }
+    else if (job.kind == Job::MOVES || job.state >= Job::READY)
+    {
+        std::vector<int> parsed;
+        parseRobotMoves(job.moves, parsed);
+        stages = robotStages(parsed, orientation);
+    }
+    else
+    {
+        stages = solvedCount ? (double)solvedStages / solvedCount : SOLVE_STAGES;
+    }
+    if (job.delayMs > 0 && stages > 0)
+        return ROBOT_START_MS + job.delayMs * stages;
+    return timing.predict(stages);
+}
+
+double RobotDaemon::predictSolveDone()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto now = Clock::now();
+    double solveMs = averageSolveMs();
+    double robotFree = 0, solverFree = 0;   // ms from now
+    int o = orientation;
+    for (int id : order)
+    {
+        const Job& job = jobs[id];
+        double run = predictRun(job, o);
+        if (job.state == Job::RUNNING)
+        {
+            if (job.etaMs >= 0)
+                run = job.etaMs;
+            robotFree = std::max(0.0, run - msBetween(job.started, now));
+            continue;
+        }
+        // Solves go one after the other, and the robot can't start on a cube before it is solved
+        if (job.state == Job::SOLVING)
+            solverFree = std::max(0.0, solveMs - msBetween(job.solving, now));
+        else if (job.state == Job::QUEUED)
+            solverFree += solveMs;
+        robotFree = std::max(robotFree, solverFree) + run;
+    }
+    Job next;
+    next.delayMs = opt.delayMs;
+    return std::max(robotFree, solverFree + solveMs) + predictRun(next, o);
+}
+
+// With the lock held
+void RobotDaemon::failQueue(const std::string& reason)
+{
+    for (int id : order)
+    {
+        Job& job = jobs[id];
+        if (job.state == Job::RUNNING)
+            continue;
+        job.state = Job::CANCELLED;
+        job.error = reason;
+        job.finished = Clock::now();
+        cancelledCount++;
+    }
+    order.erase(std::remove_if(order.begin(), order.end(), [&](int id) { return jobs[id].isFinished(); }), order.end());
+    tailKnown = false;
+}
+
+// With the lock held. Forgets the oldest finished jobs
+void RobotDaemon::trim()
+{
+    for (auto it = jobs.begin(); jobs.size() > KEEP_FINISHED_JOBS && it != jobs.end();)
+    {
+        if (it->second.isFinished())
+            it = jobs.erase(it);
+        else
+            ++it;
+    }
+}
+
+void RobotDaemon::solverLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        // The first SOLVE in line that hasn't been started
+        int id = 0;
+        changed.wait(lock, [&]()
+        {
+            for (int i : order)
+            {
+                if (jobs[i].state == Job::QUEUED)
+                {
+                    id = i;
+                    return true;
+                }
+            }
+            return quit;
+        });
+        if (quit)
+            return;
+
+        Job& job = jobs[id];
+        job.state = Job::SOLVING;
+        job.solving = Clock::now();
+        CubieCube cube = job.cube;
+        lock.unlock();
+
+        MultiSearch search;
+        search.variants = opt.variants;
+        SearchOptions options;
+        options.maxLength = opt.maxLength;
+        options.timeoutMs = opt.searchMs;
+        std::vector<int> solution;
+        bool ok = search.solve(cube, options, solution);
+
+        lock.lock();
+        auto it = jobs.find(id);
+        if (it == jobs.end() || it->second.state != Job::SOLVING)
+            continue;   // Cancelled meanwhile
+        Job& done = it->second;
+        done.solved = Clock::now();
+        solveCount++;
+        solveMs += msBetween(done.solving, done.solved);
+        if (ok)
+        {
+            done.moves = movesToRobot(solution);
+            done.state = Job::READY;
+            int o = 0;
+            solvedStages += robotStages(solution, o);
+            solvedCount++;
+        }
+        else
+        {
+            done.state = Job::FAILED;
+            done.error = "no solution found";
+            done.finished = done.solved;
+            failedCount++;
+            order.erase(std::find(order.begin(), order.end(), id));
+            failQueue("an earlier job failed");
+        }
+        changed.notify_all();
+    }
+}
+
+// Without the lock. orientation is the one the cube is in, and where it ends up, -1 if a MOVE stopped somewhere
+// along the way. up goes false if the robot stopped answering. The runner writes both back once it has the lock
+// again
+bool RobotDaemon::execute(Job& job, int& orientation, bool& up, std::string& error)
+{
+    std::string cmd;
+    std::vector<int> parsed;
+    if (job.kind == Job::SEQUENCE)
+    {
+        cmd = "SEQ " + job.moves;
+    }
+    else
+    {
+        // After a MOVE that stopped somewhere only the robot knows which way the cube is, don't guess
+        std::string facelets;
+        char pending;
+        if (orientation < 0 && !robot.queryState(facelets, orientation, pending))
+        {
+            error = "cube orientation unknown, the robot doesn't answer STATE (restart with -o)";
+            return false;
+        }
+
+        // Older firmware doesn't know STATE, that's fine
+        if (job.kind == Job::SOLVE)
+            robot.command("STATE " + job.cube.toFacelets());
+        if (job.moves.empty())
+            return true;    // Already solved
+        parseRobotMoves(job.moves, parsed);
+        cmd = "MOVE " + std::to_string(job.delayMs) + " " + std::to_string(orientation) + " " + job.moves;
+    }
+
+    robot.takeError();
+    std::string reply = robot.command(cmd);
+    if (!RobotLink::isOk(reply))
+    {
+        error = reply.empty() ? "no reply" : reply;
+        if (reply.empty())
+        {
+            up = false;
+            if (job.kind != Job::SEQUENCE)
+                orientation = -1;   // It may have started
+        }
+        return false;
+    }
+    int from = orientation;
+    if (job.kind != Job::SEQUENCE)
+        orientation = -1;           // Somewhere along the moves until the robot is done
+    job.etaMs = RobotLink::etaMs(reply);
+    if (job.etaMs >= 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs[job.id].etaMs = job.etaMs;    // The robot knows its calibrations, so it beats predictRun()
+    }
+
+    // Anything that takes the robot longer than this is stuck. A quarter turn takes well under a second
+    long quarterTurns = job.kind == Job::SEQUENCE ? (long)job.moves.size() : robotQuarterTurns(parsed);
+    auto deadline = Clock::now() + std::chrono::milliseconds(10000 + 5000 * quarterTurns);
+    bool cancelled = false;
+    robot.poll(50);     // BUSY comes right after OK
+    while (robot.isBusy() && Clock::now() < deadline)
+    {
+        robot.poll(100);
+        bool cancel;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancel = jobs[job.id].cancelRequested;
+        }
+        if (cancel && !cancelled)
+        {
+            robot.command("SEQ C");
+            cancelled = true;
+        }
+    }
+    if (cancelled)
+    {
+        error = "cancelled";
+        return false;
+    }
+    if (robot.isBusy())
+    {
+        robot.command("SEQ C");
+        error = "timeout";
+        return false;
+    }
+    error = robot.takeError();
+    if (!error.empty())
+        return false;
+    if (job.kind != Job::SEQUENCE)
+    {
+        job.stages = robotStages(parsed, from);
+        orientation = from;
+    }
+    job.busy = robot.busySince();
+    job.idle = robot.idleSince();
+    return true;
+}
+
+// Without the lock. Asks the robot what the cube looks like after a MOVE stopped before the end. orientation is
+// where it stopped if the robot answers, even if the cube can't be trusted
+bool RobotDaemon::recoverCube(CubieCube& cube, int& orientation, std::string& error)
+{
+    std::string facelets;
+    char pending;
+    if (!robot.queryState(facelets, orientation, pending) || facelets.empty())
+        return false;
+    if (pending)
+    {
+        error += std::string(", ") + pending + " may be half done";     // Only someone looking at it can tell
+        return false;
+    }
+    return cube.fromFacelets(facelets) == 0;
+}
+
+void RobotDaemon::runnerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    auto lastContact = Clock::now();
+    while (!quit)
+    {
+        if (!linkUp)
+        {
+            lock.unlock();
+            bool up = robot.connect(1000);
+            lock.lock();
+            linkUp = up;
+            lastContact = Clock::now();
+            if (!up)
+            {
+                changed.wait_for(lock, std::chrono::milliseconds(opt.keepAliveMs), [&]() { return quit; });
+                continue;
+            }
+        }
+
+        // Wait for the next job to be ready, or PING when it has been quiet for too long
+        if (order.empty() || jobs[order.front()].state != Job::READY)
+        {
+            bool waitingForSolver = !order.empty() && jobs[order.front()].kind == Job::SOLVE;
+            auto waitStart = Clock::now();
+            auto keepAlive = lastContact + std::chrono::milliseconds(opt.keepAliveMs);
+            bool timedOut = changed.wait_until(lock, keepAlive) == std::cv_status::timeout;
+            if (waitingForSolver)
+                waitMs += msBetween(waitStart, Clock::now());
+            if (timedOut && Clock::now() >= keepAlive)
+            {
+                lock.unlock();
+                bool up = robot.command("PING") == "PONG";
+                lock.lock();
+                linkUp = up;
+                lastContact = Clock::now();
+            }
+            continue;
+        }
+
+        int id = order.front();
+        Job& job = jobs[id];
+        job.state = Job::RUNNING;
+        job.started = Clock::now();
+        int o = orientation;
+        job.predictedMs = predictRun(job, o);
+        Job copy = job;
+        int robotOrientation = orientation;
+        bool up = linkUp;
+        lock.unlock();
+
+        std::string error;
+        bool ok = execute(copy, robotOrientation, up, error);
+        CubieCube robotCube;
+        bool recovered = !ok && copy.kind != Job::SEQUENCE && up && recoverCube(robotCube, robotOrientation, error);
+
+        lock.lock();
+        linkUp = up;
+        orientation = robotOrientation;
+        lastContact = Clock::now();
+        order.pop_front();
+        Job& done = jobs[id];
+        done.finished = Clock::now();
+        runMs += msBetween(done.started, done.finished);
+        if (ok)
+        {
+            done.state = Job::DONE;
+            done.stages = copy.stages;
+            done.busy = copy.busy;
+            done.idle = copy.idle;
+            doneCount++;
+            recordPhases(done);
+            if (done.stages > 0)
+            {
+                double ms = msBetween(done.started, done.finished);
+                predictErrorMs += std::abs(ms - done.predictedMs);
+                predictCount++;
+                if (done.delayMs <= 0)
+                    timing.add(done.stages, ms);
+            }
+        }
+        else
+        {
+            done.state = done.cancelRequested ? Job::CANCELLED : Job::FAILED;
+            done.error = error;
+            (done.state == Job::CANCELLED ? cancelledCount : failedCount)++;
+            failQueue("an earlier job failed");
+            if (recovered)
+            {
+                tail = robotCube;   // Nothing queued anymore, so that's where the next job starts
+                tailKnown = true;
+            }
+        }
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include "../Solver/CubieCube.h"
+#include "../Solver/MultiSearch.h"
+#include "LatencyHistogram.h"
+#include "RobotLink.h"
+
+struct DaemonOptions
+{
+    long searchMs = 1000;       // Search time per solve
+    int maxLength = 21;
+    int variants = N_VARIANTS;  // See MultiSearch
+    int delayMs = 0;            // MOVE delay for jobs that don't say
+    int orientation = 0;        // MOVE orientation the cube is in when the daemon starts
+    int keepAliveMs = 2000;     // PING the robot after being idle this long
+    int firstId = 1, idStep = 1;    // Job ids this daemon hands out, RobotFleet interleaves them
+};
+
+struct Job
+{
+    using Clock = std::chrono::steady_clock;
+    enum Kind { SOLVE, MOVES, SEQUENCE, N_KINDS };
+    enum State { QUEUED, SOLVING, READY, RUNNING, DONE, FAILED, CANCELLED };
+
+    int id = 0;
+    Kind kind = SOLVE;
+    State state = QUEUED;
+    CubieCube cube;             // SOLVE: the cube to solve
+    std::string moves;          // MOVE string (given, or once solved), or the SEQ string
+    int delayMs = 0;
+    bool cancelRequested = false;
+    std::string error;          // Why it FAILED
+    int stages = 0;             // MOVE stages it took on the robot
+    double predictedMs = 0;     // How long it was expected to run when it started
+    int etaMs = -1;             // How long the robot said it would take (MOVE's "OK eta="), -1 if it didn't
+    double captureMs = -1, classifyMs = -1;     // SOLVE: how long scanning took, if the client said
+    Clock::time_point queued, solving, solved, started, finished;
+    Clock::time_point busy, idle;   // When the robot said BUSY and IDLE for it
+
+    bool isFinished() const { return state == DONE || state == FAILED || state == CANCELLED; }
+};
+
+const char* jobStateName(Job::State state);
+const char* jobKindName(Job::Kind kind);
+
+// Where the time of a job went. Each kind of job has a histogram of every phase, over the jobs that were DONE
+enum JobPhase
+{
+    PHASE_CAPTURE,      // Taking the photos of the cube, as the client that scanned it says (SOLVE only)
+    PHASE_CLASSIFY,     // Telling the sticker colors apart, same
+    PHASE_QUEUE,        // Waiting for the solver and for the robot
+    PHASE_SOLVE,        // Searching
+    PHASE_SEND,         // From sending the commands until the robot says BUSY, the serial or Bluetooth round trip
+    PHASE_EXECUTE,      // BUSY to IDLE, the servos
+    PHASE_TOTAL,        // All of it, from the first photo if the client said
+    N_PHASES
+};
+
+const char* jobPhaseName(JobPhase phase);
+
+// How long one robot takes for a MOVE, learned from the ones it ran: a straight line through the run time over
+// the stage count (see RobotCost.h), with older runs counting less and less. Every robot has its own servos and
+// calibrations, so the same moves can take quite a bit longer on one than on another.
+// Until it has seen enough runs, it goes by ROBOT_START_MS and ROBOT_WAIT_STAGE_MS.
+class StageTiming
+{
+public:
+    void add(int stages, double ms);
+    double predict(double stages) const;
+    double stageMs() const;
+    int runs() const { return count; }
+
+private:
+    int count = 0;
+    double n = 0, x = 0, y = 0, xx = 0, xy = 0;     // Decayed sums for the fit
+};
+
+struct DaemonStats
+{
+    int jobs = 0, solves = 0;
+    double uptimeMs = 0, runMs = 0, solveMs = 0, waitMs = 0;    // Totals
+    double stageMs = 0;         // Measured, see StageTiming
+    double predictErrorMs = 0;  // Average |predicted - actual| run time
+};
+
+// Owns the robot link and runs jobs on it one after the other, in the order they came in.
+//
+// Solving is pipelined with the robot: a solver thread works on the next SOLVE jobs in the queue while the robot
+// is still busy with the ones before, so as long as the search time is shorter than a solve on the robot, the
+// robot never waits for the solver. The daemon also keeps track of the cube the robot will be holding once
+// everything queued is done, so a SOLVE without facelets (like after a SCRAMBLE) knows what to solve, and of the
+// orientation the cube is in for the next MOVE. When a job fails, everything queued after it is cancelled. The
+// robot itself keeps track of the cube it is turning (STATE, told the cube before every SOLVE), so unless it was
+// stopped in the middle of a move, a SOLVE without facelets can pick up from wherever it stopped.
+// The orientation comes from STATE too after a MOVE that failed, and if the robot can't tell, the next MOVE,
+// SOLVE or SCRAMBLE asks again and fails rather than plan from a guess.
+//
+// While there is nothing to do, the link is kept warm with a PING every keepAliveMs, and reconnected if that fails.
+class RobotDaemon
+{
+public:
+    RobotDaemon(RobotLink& robot, const DaemonOptions& options);
+    ~RobotDaemon();
+
+    // Queue a job. Returns its id, or 0 with the reason in error. delayMs < 0 uses the default
+    int solve(const std::string& facelets, int delayMs, std::string& error,     // Empty: what the robot will hold
+              double captureMs = -1, double classifyMs = -1);
+    int moves(const std::string& robotMoves, int delayMs, std::string& error);  // Like MOVE takes them ("URRf")
+    int sequence(const std::string& seq, std::string& error);                   // Like SEQ takes it
+    int scramble(int length, int delayMs, std::string& error);                  // Random moves
+
+    bool cancel(int id);
+    // Waits until the job is finished and copies it. False if there is no such job or the time ran out
+    bool wait(int id, Job& job, int timeoutMs);
+
+    std::string status();   // One line: queue, current jobs, link
+    std::string stats();    // One line: throughput and timings
+    DaemonStats counters();
+    void histograms(LatencyHistogram out[Job::N_KINDS][N_PHASES]);     // Copies, see JobPhase
+
+    // How many ms from now a SOLVE queued now would be done, going by the measured timing of this robot
+    double predictSolveDone();
+    bool isLinkUp();
+    // Nothing queued and no timed run yet, so predictSolveDone() only has the defaults to go by
+    bool wantsSample();
+
+    void stop();
+
+private:
+    RobotLink& robot;
+    DaemonOptions opt;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<int, Job> jobs;    // By id, finished ones are kept for a while for wait()
+    std::deque<int> order;      // Not run yet, in order
+    int nextId = 1;
+    bool quit = false;
+
+    // Where the robot will be once everything queued is done
+    CubieCube tail;
+    bool tailKnown = true;
+    int orientation;            // Right now, -1 after a MOVE that stopped where the robot couldn't say
+    bool linkUp = false;
+    std::mt19937 rng{std::random_device{}()};
+
+    // Stats
+    Job::Clock::time_point startTime;
+    int doneCount = 0, failedCount = 0, cancelledCount = 0, solveCount = 0;
+    double solveMs = 0, runMs = 0, waitMs = 0;
+    StageTiming timing;
+    int solvedStages = 0, solvedCount = 0;  // Of the solutions so far, to guess at solves that aren't done yet
+    double predictErrorMs = 0;  // Sum of |predicted - actual| run time
+    int predictCount = 0;
+    LatencyHistogram phases[Job::N_KINDS][N_PHASES];
+
+    std::thread solver, runner;
+
+    int add(Job job);
+    void failQueue(const std::string& reason);
+    bool recoverCube(CubieCube& cube, int& orientation, std::string& error);
+    void trim();
+    void solverLoop();
+    void runnerLoop();
+    bool execute(Job& job, int& orientation, bool& up, std::string& error);
+    double predictRun(const Job& job, int& orientation);
+    double averageSolveMs() const;
+    void recordPhases(const Job& job);
+};
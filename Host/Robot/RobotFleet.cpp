@@ -0,0 +1,179 @@
+#include "RobotFleet.h"
+#include <algorithm>
+#include <cstdio>
+
+RobotFleet::RobotFleet(const std::vector<RobotLink*>& robots, const DaemonOptions& options)
+{
+    for (size_t i = 0; i < robots.size(); i++)
+    {
+        DaemonOptions opt = options;
+        opt.firstId = (int)i + 1;
+        opt.idStep = (int)robots.size();
+        daemons.emplace_back(new RobotDaemon(*robots[i], opt));
+    }
+}
+
+RobotDaemon* RobotFleet::daemonOf(int id)
+{
+    if (id < 1)
+        return nullptr;
+    return daemons[(id - 1) % daemons.size()].get();
+}
+
+// With the lock held. The robot a SOLVE queued now would be done on first, skipping the ones that are down.
+// A robot that hasn't been timed yet goes by ROBOT_WAIT_STAGE_MS, slower than any measured one, so it would
+// never get a job to be timed on: it gets one first, as long as it is idle
+int RobotFleet::pick()
+{
+    for (int i = 0; i < size(); i++)
+    {
+        if (daemons[i]->isLinkUp() && daemons[i]->wantsSample())
+            return i;
+    }
+
+    int best = 0;
+    double bestMs = 0;
+    bool bestUp = false;
+    for (int i = 0; i < size(); i++)
+    {
+        bool up = daemons[i]->isLinkUp();
+        double ms = daemons[i]->predictSolveDone();
+        if (i == 0 || (up && !bestUp) || (up == bestUp && ms < bestMs))
+        {
+            best = i;
+            bestMs = ms;
+            bestUp = up;
+        }
+    }
+    return best;
+}
+
+bool RobotFleet::valid(int robot, std::string& error)
+{
+    if (robot >= size())
+    {
+        error = "robot";
+        return false;
+    }
+    return true;
+}
+
+int RobotFleet::solve(const std::string& facelets, int delayMs, int robot, std::string& error,
+                      double captureMs, double classifyMs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid(robot, error))
+        return 0;
+    if (robot < 0 && facelets.empty() && size() > 1)
+    {
+        error = "which robot";  // The cube is whatever one of them holds
+        return 0;
+    }
+    return daemons[robot < 0 ? pick() : robot]->solve(facelets, delayMs, error, captureMs, classifyMs);
+}
+
+int RobotFleet::moves(const std::string& robotMoves, int delayMs, int robot, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid(robot, error))
+        return 0;
+    return daemons[robot < 0 ? pick() : robot]->moves(robotMoves, delayMs, error);
+}
+
+int RobotFleet::sequence(const std::string& seq, int robot, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid(robot, error))
+        return 0;
+    return daemons[robot < 0 ? pick() : robot]->sequence(seq, error);
+}
+
+int RobotFleet::scramble(int length, int delayMs, int robot, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!valid(robot, error))
+        return 0;
+    return daemons[robot < 0 ? pick() : robot]->scramble(length, delayMs, error);
+}
+
+int RobotFleet::cycle(int length, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    RobotDaemon& daemon = *daemons[pick()];
+    if (!daemon.scramble(length, -1, error))
+        return 0;
+    return daemon.solve("", -1, error);
+}
+
+bool RobotFleet::cancel(int id)
+{
+    RobotDaemon* daemon = daemonOf(id);
+    return daemon && daemon->cancel(id);
+}
+
+bool RobotFleet::wait(int id, Job& job, int timeoutMs)
+{
+    RobotDaemon* daemon = daemonOf(id);
+    return daemon && daemon->wait(id, job, timeoutMs);
+}
+
+std::string RobotFleet::status(int robot)
+{
+    if (robot >= 0 && robot < size())
+        return daemons[robot]->status();
+    std::string out;
+    for (int i = 0; i < size(); i++)
+        out += (i ? " | " : "") + std::to_string(i) + ": " + daemons[i]->status();
+    return out;
+}
+
+std::string RobotFleet::stats(int robot)
+{
+    if (robot >= 0 && robot < size())
+        return daemons[robot]->stats();
+
+    // Throughput of the whole fleet, and how the jobs were split between the robots
+    DaemonStats total;
+    std::string split;
+    for (int i = 0; i < size(); i++)
+    {
+        DaemonStats st = daemons[i]->counters();
+        total.jobs += st.jobs;
+        total.solves += st.solves;
+        total.uptimeMs = std::max(total.uptimeMs, st.uptimeMs);
+        total.runMs += st.runMs;
+        total.solveMs += st.solveMs;
+        total.waitMs += st.waitMs;
+        split += (i ? "/" : "") + std::to_string(st.jobs);
+    }
+    double uptime = total.uptimeMs;
+    char line[256];
+    std::snprintf(line, sizeof(line), "robots=%d jobs=%d per_min=%.1f robot_busy=%.0f%% solve_ms_avg=%.0f waited_for_solver_ms=%.0f split=%s",
+                  size(), total.jobs, uptime > 0 ? total.jobs * 60000.0 / uptime : 0.0,
+                  uptime > 0 ? 100 * total.runMs / (uptime * size()) : 0.0, total.solves ? total.solveMs / total.solves : 0.0,
+                  total.waitMs, split.c_str());
+    return line;
+}
+
+std::string RobotFleet::metrics()
+{
+    std::string out = "# HELP cubed_job_phase_ms Time jobs spent in each phase, ms\n"
+                      "# TYPE cubed_job_phase_ms histogram\n";
+    LatencyHistogram phases[Job::N_KINDS][N_PHASES];
+    for (int i = 0; i < size(); i++)
+    {
+        daemons[i]->histograms(phases);
+        for (int k = 0; k < Job::N_KINDS; k++)
+        {
+            for (int p = 0; p < N_PHASES; p++)
+            {
+                if (!phases[k][p].count())
+                    continue;
+                std::string labels = "robot=\"" + std::to_string(i) + "\",kind=\"" + jobKindName((Job::Kind)k) +
+                                     "\",phase=\"" + jobPhaseName((JobPhase)p) + "\"";
+                phases[k][p].write(out, "cubed_job_phase_ms", labels);
+            }
+        }
+    }
+    return out;
+}
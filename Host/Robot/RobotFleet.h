@@ -0,0 +1,47 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "RobotDaemon.h"
+
+// Several robots, each with its own RobotDaemon (queue, solver thread and cube), behind one set of job ids.
+//
+// Jobs that say which robot they are for go there. The others go to the robot that would be done with them
+// first: every daemon predicts that from its own queue and the timing it measured on its own robot, so a robot
+// with slow servos or long settle times gets fewer cubes than a fast one, and one that is down gets none.
+// Job ids are handed out interleaved, so robot (id - 1) % size() has job id.
+class RobotFleet
+{
+public:
+    RobotFleet(const std::vector<RobotLink*>& robots, const DaemonOptions& options);
+
+    int size() const { return (int)daemons.size(); }
+
+    // Like RobotDaemon, robot < 0 picks one. A SOLVE without facelets needs a robot unless there is only one
+    int solve(const std::string& facelets, int delayMs, int robot, std::string& error,
+              double captureMs = -1, double classifyMs = -1);
+    int moves(const std::string& robotMoves, int delayMs, int robot, std::string& error);
+    int sequence(const std::string& seq, int robot, std::string& error);
+    int scramble(int length, int delayMs, int robot, std::string& error);
+    // A scramble and the solve after it, on the same robot. Returns the id of the solve
+    int cycle(int length, std::string& error);
+
+    bool cancel(int id);
+    bool wait(int id, Job& job, int timeoutMs);
+
+    std::string status(int robot = -1);     // All robots, or one
+    std::string stats(int robot = -1);
+
+    // The phase histograms of every robot (see JobPhase) in the Prometheus text format, as cubed_job_phase_ms
+    // with robot, kind and phase labels. cubelat reads these back
+    std::string metrics();
+
+private:
+    std::vector<std::unique_ptr<RobotDaemon>> daemons;
+    std::mutex mutex;   // One routing decision at a time, so two clients don't both pick the same idle robot
+
+    RobotDaemon* daemonOf(int id);
+    int pick();
+    bool valid(int robot, std::string& error);
+};
@@ -0,0 +1,117 @@
+#include "RobotLink.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+static int msLeft(Clock::time_point deadline)
+{
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+}
+
+// Returns true if the line was a status line and not a reply
+bool RobotLink::handleStatus(const std::string& line)
+{
+    if (line == "BUSY")
+    {
+        busy = true;
+        busyAt = Clock::now();
+    }
+    else if (line == "IDLE")
+    {
+        busy = false;
+        idleAt = Clock::now();
+    }
+    else if (line.compare(0, 6, "MOVED ") == 0)
+        moved = std::atoi(line.c_str() + 6);
+    else if (line.compare(0, 8, "SEQ ERR ") == 0)
+        error = line;
+    else
+        return false;
+    return true;
+}
+
+bool RobotLink::connect(int timeoutMs)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (msLeft(deadline) > 0)
+    {
+        if (command("PING", 500) == "PONG")
+            return true;
+    }
+    return false;
+}
+
+std::string RobotLink::command(const std::string& cmd, int timeoutMs)
+{
+    if (!serial.writeLine(cmd))
+        return "";
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::string line;
+    while (serial.readLine(line, std::max(msLeft(deadline), 0)))
+    {
+        if (handleStatus(line))
+            continue;
+        if (isOk(line) || line == "PONG" || line.compare(0, 3, "ERR") == 0 || line.compare(0, 6, "STATE ") == 0)
+            return line;
+        // Anything else is chatter, like the greeting after a reset
+    }
+    return "";
+}
+
+bool RobotLink::isOk(const std::string& reply)
+{
+    return reply == "OK" || reply.compare(0, 3, "OK ") == 0;
+}
+
+int RobotLink::etaMs(const std::string& reply)
+{
+    size_t at = reply.find(" eta=");
+    if (!isOk(reply) || at == std::string::npos)
+        return -1;
+    return std::atoi(reply.c_str() + at + 5);
+}
+
+bool RobotLink::poll(int timeoutMs)
+{
+    std::string line;
+    bool any = false;
+    while (serial.readLine(line, any ? 0 : timeoutMs))
+    {
+        handleStatus(line);
+        any = true;
+    }
+    return any;
+}
+
+bool RobotLink::waitIdle(int timeoutMs)
+{
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (busy && msLeft(deadline) > 0)
+        poll(msLeft(deadline));
+    return !busy;
+}
+
+std::string RobotLink::takeError()
+{
+    std::string e;
+    e.swap(error);
+    return e;
+}
+
+bool RobotLink::queryState(std::string& facelets, int& orientation, char& pending)
+{
+    // STATE <facelets|?> <orientation> <move|->
+    std::string reply = command("STATE");
+    char cube[64], move;
+    int o;
+    if (std::sscanf(reply.c_str(), "STATE %63s %d %c", cube, &o, &move) != 3)
+        return false;
+    facelets = cube[0] == '?' ? "" : cube;
+    orientation = o;
+    pending = move == '-' ? 0 : move;
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include "SerialLink.h"
+
+// The text API of the arduino (see Arduino/README.md) on top of a serial link.
+// Besides replying to commands, the robot sends BUSY/IDLE whenever that changes, "SEQ ERR <code>" when a
+// sequence fails and, while a MOVE stream is open, "MOVED <n>" after each finished move. Those are tracked here as they come in.
+class RobotLink
+{
+public:
+    explicit RobotLink(SerialLink& serial) : serial(serial) {}
+
+    // Opening the port resets the arduino, this waits until it answers PING
+    bool connect(int timeoutMs = 5000);
+
+    // Sends a command and waits for its reply ("OK", "ERR busy", "PONG", ...). Empty on timeout
+    std::string command(const std::string& cmd, int timeoutMs = 2000);
+
+    // True for "OK" and for "OK eta=<ms>", which is how MOVE replies
+    static bool isOk(const std::string& reply);
+    // How long the robot predicts the MOVE will take, from its "OK eta=<ms>". -1 if the reply has no eta
+    static int etaMs(const std::string& reply);
+
+    // Handle whatever the robot sends for up to timeoutMs. Returns false if nothing came
+    bool poll(int timeoutMs);
+    bool waitIdle(int timeoutMs);
+
+    bool isBusy() const { return busy; }
+    // When the last BUSY and IDLE came in, the robot's own start and end of a MOVE or SEQ
+    std::chrono::steady_clock::time_point busySince() const { return busyAt; }
+    std::chrono::steady_clock::time_point idleSince() const { return idleAt; }
+    int movesDone() const { return moved; }     // Quarter turns finished by the current MOVE
+    void resetMoves() { moved = 0; }
+
+    // "SEQ ERR <code>" if a sequence failed since the last call, empty if not
+    std::string takeError();
+
+    // What the robot thinks the cube looks like (STATE). False if it didn't say, like older firmware.
+    // facelets is empty if it doesn't know, pending is the move it was on when it was stopped, 0 if none
+    bool queryState(std::string& facelets, int& orientation, char& pending);
+
+private:
+    SerialLink& serial;
+    bool busy = false;
+    std::chrono::steady_clock::time_point busyAt, idleAt;
+    int moved = 0;
+    std::string error;
+
+    bool handleStatus(const std::string& line);
+};
@@ -0,0 +1,132 @@
+#include "SerialLink.h"
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+static speed_t baudConstant(int baud)
+{
+    switch (baud)
+    {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    default: return 0;
+    }
+}
+
+SerialLink::~SerialLink()
+{
+    close();
+    if (capture)
+        std::fclose(capture);
+}
+
+bool SerialLink::open(const std::string& path, int baud)
+{
+    close();
+    speed_t speed = baudConstant(baud);
+    if (speed == 0)
+        return false;
+
+    fd = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return false;
+
+    // Raw 8N1, no echo, no line editing. Fails harmlessly on things that aren't a tty
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    pending.clear();
+    return true;
+}
+
+void SerialLink::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+bool SerialLink::writeLine(const std::string& line)
+{
+    if (fd < 0)
+        return false;
+    std::string out = line + "\n";
+    size_t done = 0;
+    while (done < out.size())
+    {
+        ssize_t n = ::write(fd, out.data() + done, out.size() - done);
+        if (n < 0)
+            return false;
+        done += n;
+    }
+    log('>', line);
+    return true;
+}
+
+bool SerialLink::readLine(std::string& line, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (fd >= 0)
+    {
+        size_t nl = pending.find('\n');
+        if (nl != std::string::npos)
+        {
+            line = pending.substr(0, nl);
+            pending.erase(0, nl + 1);
+            if (!line.empty() && line.back() == '\r')   // The arduino ends lines with \r\n
+                line.pop_back();
+            log('<', line);
+            return true;
+        }
+
+        int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0)
+            return false;
+
+        pollfd p = {fd, POLLIN, 0};
+        if (poll(&p, 1, left) <= 0)
+            return false;
+
+        char buf[256];
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if (n <= 0)
+            return false;
+        pending.append(buf, n);
+    }
+    return false;
+}
+
+bool SerialLink::record(const std::string& path)
+{
+    if (capture)
+        std::fclose(capture);
+    capture = std::fopen(path.c_str(), "w");
+    if (!capture)
+        return false;
+    captureStart = std::chrono::steady_clock::now();
+    std::fprintf(capture, "# cube capture 1\n");
+    return true;
+}
+
+void SerialLink::log(char direction, const std::string& line)
+{
+    if (!capture)
+        return;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captureStart).count();
+    std::fprintf(capture, "%.3f %c %s\n", ms, direction, line.c_str());
+    std::fflush(capture);   // Whatever happens to the session, the capture up to here is there
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Line based serial port (USB serial, /dev/rfcomm* for the HC-06, or a pty), POSIX only
+class SerialLink
+{
+public:
+    ~SerialLink();
+
+    bool open(const std::string& path, int baud = 9600);
+    void close();
+    bool isOpen() const { return fd >= 0; }
+
+    bool writeLine(const std::string& line);    // Adds the '\n'
+
+    // Waits up to timeoutMs for a whole line, without the line ending. Returns false on timeout or error
+    bool readLine(std::string& line, int timeoutMs);
+
+    // Writes every line from here on to a capture file for cubereplay, one per line: the ms since the
+    // recording started, "> " for sent or "< " for received, and the line itself. Lines starting with # are comments
+    bool record(const std::string& path);
+
+private:
+    int fd = -1;
+    std::string pending;    // Received but not a whole line yet
+    FILE* capture = nullptr;
+    std::chrono::steady_clock::time_point captureStart;
+
+    void log(char direction, const std::string& line);
+};
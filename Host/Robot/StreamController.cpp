@@ -0,0 +1,176 @@
+#include "StreamController.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include "../Solver/Moves.h"
+#include "../Solver/MultiSearch.h"
+#include "../Solver/RobotCost.h"
+
+using Clock = std::chrono::steady_clock;
+
+static long msLeft(Clock::time_point deadline)
+{
+    return (long)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+}
+
+// A MultiSearch running on its own thread, so the robot can be looked after in the meantime
+class BackgroundSearch
+{
+public:
+    ~BackgroundSearch() { stop(); }
+
+    void start(const CubieCube& cube, int maxLength, int afterMove, long timeoutMs, int variants, int orientation)
+    {
+        stop();
+        stopFlag = false;
+        done = false;
+        found = false;
+        thread = std::thread([=]()
+        {
+            SearchOptions opt;
+            opt.maxLength = maxLength;
+            opt.afterMove = afterMove;
+            opt.timeoutMs = timeoutMs > 0 ? timeoutMs : 0;
+            opt.stop = &stopFlag;
+            opt.onSolution = [this](const std::vector<int>& solution)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                best = solution;
+                found = true;
+            };
+            MultiSearch search;
+            search.variants = variants;
+            search.orientation = orientation;
+            std::vector<int> solution;
+            search.solve(cube, opt, solution);
+            done = true;
+        });
+    }
+
+    void stop()
+    {
+        stopFlag = true;
+        if (thread.joinable())
+            thread.join();
+    }
+
+    bool isDone() const { return done; }
+
+    // Best solution found so far, false if there is none yet
+    bool result(std::vector<int>& solution)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (found)
+            solution = best;
+        return found;
+    }
+
+private:
+    std::thread thread;
+    std::atomic<bool> stopFlag{false};
+    std::atomic<bool> done{false};
+    std::mutex mutex;
+    std::vector<int> best;
+    bool found = false;
+};
+
+bool StreamController::run(const CubieCube& cube, const StreamOptions& opt, std::vector<int>& executed)
+{
+    executed.clear();
+    auto searchEnd = Clock::now() + std::chrono::milliseconds(opt.searchMs);
+    auto leadEnd = Clock::now() + std::chrono::milliseconds(opt.leadMs);
+
+    // ---- First solution ----
+    BackgroundSearch bg;
+    bg.start(cube, opt.maxLength, -1, opt.searchMs, opt.variants, opt.orientation);
+    std::vector<int> remaining;
+    while (!bg.isDone() && !(bg.result(remaining) && msLeft(leadEnd) <= 0))
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    bool searchDone = bg.isDone();  // Tried everything (or out of time) before the lead time was up
+    bg.stop();
+    if (!bg.result(remaining))
+    {
+        // Either already solved, or no solution of at most maxLength moves
+        return cube.isSolved();
+    }
+    if (opt.verbose)
+        std::fprintf(stderr, "First solution: %s (%zu moves)\n", movesToString(remaining).c_str(), remaining.size());
+
+    // ---- Stream it, improving the part that isn't committed yet ----
+    CubieCube state = cube;
+    int orientation = opt.orientation;  // Where the cube ends up after what has been sent
+    int sentTurns = 0;
+    bool streamOpen = false;
+    bool searching = false;
+    robot.resetMoves();
+
+    while (!remaining.empty())
+    {
+        if (searching && bg.isDone())
+            searchDone = true;
+        bool searchOver = searchDone || msLeft(searchEnd) <= 0;
+        bool robotNeedsMoves = !streamOpen || sentTurns - robot.movesDone() <= 1;
+        if (!searchOver && !robotNeedsMoves)
+        {
+            robot.poll(20);
+            continue;
+        }
+
+        if (searching)
+        {
+            bg.stop();
+            std::vector<int> better;
+            if (bg.result(better))
+            {
+                if (opt.verbose)
+                    std::fprintf(stderr, "Improved: %zu -> %zu moves left\n", remaining.size(), better.size());
+                remaining = better;
+            }
+            searching = false;
+        }
+
+        // Nothing left to search for, send all of it. Otherwise just the next chunk
+        size_t count = searchOver ? remaining.size() : std::min(remaining.size(), (size_t)opt.chunkMoves);
+        std::vector<int> chunk(remaining.begin(), remaining.begin() + count);
+        remaining.erase(remaining.begin(), remaining.begin() + count);
+        bool more = !remaining.empty();
+
+        std::string cmd;
+        if (!streamOpen)
+            cmd = "MOVE " + std::to_string(opt.delayMs) + " " + std::to_string(opt.orientation) + " " + movesToRobot(chunk);
+        else
+            cmd = "APPEND " + movesToRobot(chunk);
+        if (more)
+            cmd += " +";
+
+        std::string reply = robot.command(cmd);
+        if (!RobotLink::isOk(reply))
+        {
+            std::fprintf(stderr, "Robot said \"%s\" to \"%s\"\n", reply.c_str(), cmd.c_str());
+            if (streamOpen)
+                robot.command("SEQ C");     // Don't leave it waiting for moves that never come
+            return false;
+        }
+        if (opt.verbose)
+            std::fprintf(stderr, "Committed: %s (%zu left)\n", movesToString(chunk).c_str(), remaining.size());
+
+        streamOpen = true;
+        sentTurns += robotQuarterTurns(chunk);
+        state.applyMoves(chunk);
+        robotStages(chunk, orientation);
+        executed.insert(executed.end(), chunk.begin(), chunk.end());
+
+        if (more && msLeft(searchEnd) > 0)
+        {
+            // Only a shorter continuation is any use
+            bg.start(state, (int)remaining.size() - 1, chunk.back(), msLeft(searchEnd), opt.variants, orientation);
+            searching = true;
+            searchDone = false;
+        }
+    }
+
+    // Every move takes well under 5 seconds, even with a cube flip and long delays
+    return robot.waitIdle(10000 + 5000 * (sentTurns - robot.movesDone()));
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include "../Solver/CubieCube.h"
+#include "../Solver/MultiSearch.h"
+#include "RobotLink.h"
+
+struct StreamOptions
+{
+    int delayMs = 0;        // MOVE delay, 0 = wait for arrival
+    int orientation = 0;    // MOVE orientation the cube is in right now
+    int maxLength = 21;
+    long leadMs = 100;      // Search at least this long before the first move goes out (the robot needs 100ms to start anyway)
+    long searchMs = 5000;   // Stop improving after this long, everything left is sent then
+    int chunkMoves = 2;     // Moves committed at a time
+    int variants = N_VARIANTS;  // Cube symmetries searched in parallel, see MultiSearch
+    bool verbose = false;   // Print what gets committed to stderr
+};
+
+// Solves a cube while the robot is already turning it.
+//
+// The two-phase search finds a solution almost immediately and then keeps finding shorter ones. Instead of
+// waiting for it to finish, the first few moves of the best solution so far are committed to the robot with a
+// streaming MOVE, and from then on the search only looks for continuations from the cube after those moves.
+// So the committed prefix is part of every solution the search can still come up with, and any shorter
+// continuation it finds while the robot turns is simply what gets appended next. A new chunk is committed
+// whenever the robot is down to its last queued move, the rest goes out in one go when the search is done
+// or out of time.
+class StreamController
+{
+public:
+    explicit StreamController(RobotLink& robot) : robot(robot) {}
+
+    // Returns false if there is no solution or the robot said no. executed gets every move that was sent
+    bool run(const CubieCube& cube, const StreamOptions& options, std::vector<int>& executed);
+
+private:
+    RobotLink& robot;
+};
@@ -0,0 +1,253 @@
+#include "ColorScan.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+ScanColor averageColor(const uint32_t* pixels, int stride, int x, int y, int w, int h)
+{
+    uint64_t r = 0, g = 0, b = 0;
+    for (int iy = y; iy < y + h; iy++)
+    {
+        const uint32_t* p = pixels + (size_t)iy * stride + x;
+        int ix = 0;
+        // One row at a time in 32 bit lanes, a row of 255s would need 4 million pixels to overflow
+#if defined(__SSE2__)
+        __m128i mask = _mm_set1_epi32(0xff);
+        __m128i sr = _mm_setzero_si128(), sg = _mm_setzero_si128(), sb = _mm_setzero_si128();
+        for (; ix + 4 <= w; ix += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + ix));
+            sb = _mm_add_epi32(sb, _mm_and_si128(v, mask));
+            sg = _mm_add_epi32(sg, _mm_and_si128(_mm_srli_epi32(v, 8), mask));
+            sr = _mm_add_epi32(sr, _mm_and_si128(_mm_srli_epi32(v, 16), mask));
+        }
+        uint32_t lanes[3][4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[0]), sr);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[1]), sg);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes[2]), sb);
+        for (int i = 0; i < 4; i++)
+        {
+            r += lanes[0][i];
+            g += lanes[1][i];
+            b += lanes[2][i];
+        }
+#elif defined(__ARM_NEON)
+        uint32x4_t mask = vdupq_n_u32(0xff);
+        uint32x4_t sr = vdupq_n_u32(0), sg = vdupq_n_u32(0), sb = vdupq_n_u32(0);
+        for (; ix + 4 <= w; ix += 4)
+        {
+            uint32x4_t v = vld1q_u32(p + ix);
+            sb = vaddq_u32(sb, vandq_u32(v, mask));
+            sg = vaddq_u32(sg, vandq_u32(vshrq_n_u32(v, 8), mask));
+            sr = vaddq_u32(sr, vandq_u32(vshrq_n_u32(v, 16), mask));
+        }
+        r += vgetq_lane_u32(sr, 0) + (uint64_t)vgetq_lane_u32(sr, 1) + vgetq_lane_u32(sr, 2) + vgetq_lane_u32(sr, 3);
+        g += vgetq_lane_u32(sg, 0) + (uint64_t)vgetq_lane_u32(sg, 1) + vgetq_lane_u32(sg, 2) + vgetq_lane_u32(sg, 3);
+        b += vgetq_lane_u32(sb, 0) + (uint64_t)vgetq_lane_u32(sb, 1) + vgetq_lane_u32(sb, 2) + vgetq_lane_u32(sb, 3);
+#endif
+        for (; ix < w; ix++)
+        {
+            uint32_t v = p[ix];
+            r += (v >> 16) & 0xff;
+            g += (v >> 8) & 0xff;
+            b += v & 0xff;
+        }
+    }
+    float n = (float)w * h;
+    if (n <= 0)
+        return {0, 0, 0};
+    return {r / n, g / n, b / n};
+}
+
+void sampleFace(const uint32_t* pixels, int width, int height, int stride, float sampleScale, ScanColor out[9])
+{
+    // Same regions as sampleFaceColorsRaw() in the app
+    int tileW = width / 3, tileH = height / 3;
+    int sw = (int)(tileW * sampleScale), sh = (int)(tileH * sampleScale);
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            int x = col * tileW + (tileW - sw) / 2;
+            int y = row * tileH + (tileH - sh) / 2;
+            out[3 * row + col] = averageColor(pixels, stride, x, y, sw, sh);
+        }
+    }
+}
+
+struct Lab
+{
+    float l, a, b;
+};
+
+static float linear(float c)
+{
+    c /= 255;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float labF(float t)
+{
+    return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116;
+}
+
+// sRGB to CIE Lab with a D65 white point
+static Lab toLab(const ScanColor& c)
+{
+    float r = linear(c.r), g = linear(c.g), b = linear(c.b);
+    float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+    float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+    float fx = labF(x), fy = labF(y), fz = labF(z);
+    return {116 * fy - 16, 500 * (fx - fy), 200 * (fy - fz)};
+}
+
+// Shadows and uneven light change how bright a sticker looks a lot more than its hue, so lightness counts half
+#define LIGHTNESS_WEIGHT 0.5f
+
+static float distance(const Lab& p, const Lab& q)
+{
+    return std::sqrt(LIGHTNESS_WEIGHT * (p.l - q.l) * (p.l - q.l) + (p.a - q.a) * (p.a - q.a) + (p.b - q.b) * (p.b - q.b));
+}
+
+// Hungarian algorithm for a square cost matrix: the assignment of rows to columns with the lowest total.
+// O(n^3), nothing for n = 48
+static void assign(const std::vector<std::vector<float>>& cost, std::vector<int>& rowToColumn)
+{
+    int n = (int)cost.size();
+    const float inf = std::numeric_limits<float>::max();
+    std::vector<float> u(n + 1), v(n + 1);
+    std::vector<int> p(n + 1), way(n + 1);     // p[column] = row, 1 based, 0 is a dummy
+    for (int i = 1; i <= n; i++)
+    {
+        p[0] = i;
+        int j0 = 0;
+        std::vector<float> minv(n + 1, inf);
+        std::vector<bool> used(n + 1, false);
+        do
+        {
+            used[j0] = true;
+            int i0 = p[j0], j1 = 0;
+            float delta = inf;
+            for (int j = 1; j <= n; j++)
+            {
+                if (used[j])
+                    continue;
+                float cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j])
+                {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta)
+                {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++)
+            {
+                if (used[j])
+                {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do
+        {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    rowToColumn.assign(n, -1);
+    for (int j = 1; j <= n; j++)
+        rowToColumn[p[j] - 1] = j - 1;
+}
+
+int classifyStickers(const ScanColor colors[54], int faces[54], float* margins)
+{
+    Lab lab[54], centroid[6];
+    for (int i = 0; i < 54; i++)
+        lab[i] = toLab(colors[i]);
+    for (int f = 0; f < 6; f++)
+    {
+        centroid[f] = lab[9 * f + 4];
+        faces[9 * f + 4] = f;
+    }
+
+    // The 48 stickers that aren't centers against 8 free places in each group
+    std::vector<int> stickers;
+    for (int i = 0; i < 54; i++)
+    {
+        if (i % 9 != 4)
+            stickers.push_back(i);
+    }
+    std::vector<std::vector<float>> cost(48, std::vector<float>(48));
+    std::vector<int> column;
+
+    int rounds = 0;
+    for (bool changed = true; changed && rounds < 20; rounds++)
+    {
+        for (int k = 0; k < 48; k++)
+        {
+            for (int f = 0; f < 6; f++)
+            {
+                float d = distance(lab[stickers[k]], centroid[f]);
+                for (int slot = 0; slot < 8; slot++)
+                    cost[k][8 * f + slot] = d;
+            }
+        }
+        assign(cost, column);
+
+        changed = false;
+        for (int k = 0; k < 48; k++)
+        {
+            int f = column[k] / 8;
+            if (rounds == 0 || faces[stickers[k]] != f)
+                changed = true;
+            faces[stickers[k]] = f;
+        }
+
+        // Move every group's center to the middle of its 9 stickers
+        for (int f = 0; f < 6; f++)
+        {
+            Lab sum = {0, 0, 0};
+            for (int i = 0; i < 54; i++)
+            {
+                if (faces[i] != f)
+                    continue;
+                sum.l += lab[i].l;
+                sum.a += lab[i].a;
+                sum.b += lab[i].b;
+            }
+            centroid[f] = {sum.l / 9, sum.a / 9, sum.b / 9};
+        }
+    }
+
+    if (margins)
+    {
+        for (int i = 0; i < 54; i++)
+        {
+            float other = std::numeric_limits<float>::max();
+            for (int f = 0; f < 6; f++)
+            {
+                if (f != faces[i])
+                    other = std::fmin(other, distance(lab[i], centroid[f]));
+            }
+            margins[i] = other - distance(lab[i], centroid[faces[i]]);
+        }
+    }
+    return rounds;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// Sticker colors from the 6 face photos the app takes while scanning, and which face each sticker belongs to.
+// Plain C++ with no dependencies, so the app uses the same code through JNI (CubeSolver/app/src/main/jni).
+//
+// Averaging uses SSE2 on x86 and NEON on ARM (4 pixels at a time), plain C++ anywhere else.
+// Classifying doesn't compare every sticker to a fixed reference color like the app used to. A cube has exactly
+// 9 stickers of each color, so the 54 stickers are split into 6 groups of 9 around the centers (k-means where
+// every group has to take exactly 9, solved as an assignment problem), in CIE Lab where distances are closer to
+// what the eye sees. The lighting can tint everything and the groups still come out right, and a sticker that
+// looks halfway between two colors goes to whichever group still needs one.
+
+struct ScanColor
+{
+    float r, g, b;      // 0..255
+};
+
+// Average color of the middle part of each sticker of a face photo, in reading order.
+// pixels are ARGB_8888 like Bitmap.getPixels() gives them, stride is in pixels. sampleScale is how much of each
+// third of the photo is averaged (the app uses 0.4, the edges of a sticker are often shadow or plastic)
+void sampleFace(const uint32_t* pixels, int width, int height, int stride, float sampleScale, ScanColor out[9]);
+
+// Average of one rectangle
+ScanColor averageColor(const uint32_t* pixels, int stride, int x, int y, int w, int h);
+
+// colors are the 54 stickers, 9 per face, the center of face f is at 9 * f + 4.
+// faces gets the face (0..5) whose center each sticker matches, exactly 9 of each.
+// margins, if not null, gets how much farther the next best group is for each sticker (in Lab units, below 10 or
+// so is worth a second look; negative if it only got its group because the closer one was full).
+// Returns the number of k-means rounds it took
+int classifyStickers(const ScanColor colors[54], int faces[54], float* margins = nullptr);
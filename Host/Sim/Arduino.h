@@ -0,0 +1,63 @@
+#pragma once
+// Just enough of the Arduino core to build the firmware in Arduino/ for the PC, see Firmware.h
+#include <ctype.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// F() strings stay in flash on the nano, print() has to tell them apart there, so they get the type here too
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define INPUT 0
+#define OUTPUT 1
+#define LOW 0
+#define HIGH 1
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void pinMode(uint8_t pin, uint8_t mode);
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud);
+    void setTimeout(unsigned long ms) { timeoutMs = ms; }
+    int available();
+    int read();
+    int peek();
+    size_t readBytesUntil(char terminator, char* buffer, size_t length);
+    long parseInt();
+    int availableForWrite();
+    void flush();   // Waits until everything is sent
+
+    size_t write(uint8_t c);
+    size_t write(const char* s);
+    size_t print(const char* s) { return write(s); }
+    size_t print(const __FlashStringHelper* s) { return write((const char*)s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print((long)v); }
+    size_t print(unsigned int v) { return print((unsigned long)v); }
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int digits = 2);
+    template <typename T>
+    size_t println(T v)
+    {
+        return print(v) + println();
+    }
+    size_t println(double v, int digits) { return print(v, digits) + println(); }
+    size_t println() { return write("\r\n"); }
+
+private:
+    unsigned long timeoutMs = 1000;
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+// 1KB like the ATmega328P, starts out erased (0xFF). See Firmware.h to load an image
+class EEPROMClass
+{
+public:
+    EEPROMClass() { memset(data, 0xff, sizeof(data)); }
+
+    uint8_t read(int address) const { return data[address]; }
+    void write(int address, uint8_t value) { data[address] = value; }
+    void update(int address, uint8_t value) { data[address] = value; }
+    uint16_t length() const { return sizeof(data); }
+
+    template <typename T>
+    T& get(int address, T& t) const
+    {
+        memcpy(&t, data + address, sizeof(T));
+        return t;
+    }
+    template <typename T>
+    const T& put(int address, const T& t)
+    {
+        memcpy(data + address, &t, sizeof(T));
+        return t;
+    }
+
+    uint8_t data[1024];
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,341 @@
+#include "Firmware.h"
+#include <chrono>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "Servo.h"
+#include "../../Arduino/Calibrate.h"
+#include "../../Arduino/MyServo.h"
+#include "../../Arduino/StageTimer.h"
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+// In Arduino.ino
+void setup();
+void loop();
+
+static unsigned long clockUs = 0;
+static double realSpeed = 0;    // 0 while virtual
+static std::chrono::steady_clock::time_point realStart;
+static unsigned long realStartUs = 0;
+
+static std::string input, output;
+
+// The nano's serial port sends a byte every 10 bits at 9600 baud, out of a 64 byte buffer (63 usable). Writing to a
+// full buffer waits, like HardwareSerial::write() does
+#define SERIAL_BAUD 9600
+#define SERIAL_TX_ROOM 63
+#define SERIAL_BYTE_US (10 * 1000000UL / SERIAL_BAUD)
+static unsigned long txDoneUs = 0;  // When the last byte written is out
+static std::function<void(const std::string&)> outputCallback;
+static std::function<void(unsigned long)> inputWait;
+
+// The stage timer is an interrupt that comes the moment the clock gets there, in between two loop()s
+static bool timerArmed = false, timerBlocked = false;
+static unsigned long timerAt = 0;
+
+#define MAX_PINS 64
+static int servoPulses[MAX_PINS];
+
+// ---- Clock ----
+
+unsigned long firmwareMicros()
+{
+    if (realSpeed > 0)
+    {
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - realStart).count();
+        clockUs = realStartUs + (unsigned long)(us * realSpeed);
+    }
+    return clockUs;
+}
+
+static void timerCheck()
+{
+    if (timerArmed && !timerBlocked && (long)(firmwareMicros() - timerAt) >= 0)
+    {
+        timerArmed = false;
+        stageTimerFired();
+    }
+}
+
+void firmwareAdvance(unsigned long us)
+{
+    if (realSpeed != 0)
+        return;
+    unsigned long until = clockUs + us;
+    if (timerArmed && !timerBlocked && (long)(until - timerAt) >= 0)
+    {
+        if ((long)(timerAt - clockUs) > 0)
+            clockUs = timerAt;
+        timerCheck();
+    }
+    clockUs = until;
+}
+
+void firmwareRealTime(double speed)
+{
+    realStartUs = firmwareMicros();
+    realStart = std::chrono::steady_clock::now();
+    realSpeed = speed;
+}
+
+unsigned long micros() { return firmwareMicros(); }
+unsigned long millis() { return firmwareMicros() / 1000; }
+
+void delay(unsigned long ms)
+{
+    if (realSpeed == 0)
+    {
+        firmwareAdvance(ms * 1000);
+        return;
+    }
+    unsigned long until = firmwareMicros() + ms * 1000;
+    while ((long)(until - firmwareMicros()) > 0)
+        ;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void stageTimerBegin() {}
+
+void stageTimerArm(unsigned long atUs)
+{
+    timerAt = atUs;
+    timerArmed = true;
+}
+
+void stageTimerCancel()
+{
+    timerArmed = false;
+}
+
+void stageTimerBlock(bool block)
+{
+    timerBlocked = block;
+    if (!block)
+        timerCheck();   // It was due meanwhile
+}
+
+// ---- Running ----
+
+void firmwareStart()
+{
+    // On the chip the servos read their calibrations from EEPROM before setup(). Here their constructors ran
+    // before anybody could load an image (and maybe even before EEPROM's), so they read them again
+    for (int i = 0; i < NUM_SERVOS; i++)
+        servos[i].setCalibration(readCalibration((ServoType)i));
+    setup();
+}
+
+void firmwareLoop()
+{
+    timerCheck();   // Following the PC clock, it can only come this often
+    loop();
+    firmwareAdvance(FIRMWARE_LOOP_US);
+}
+
+void firmwareRunFor(unsigned long us)
+{
+    unsigned long until = firmwareMicros() + us;
+    while ((long)(until - firmwareMicros()) > 0)
+        firmwareLoop();
+}
+
+// ---- Serial ----
+
+void firmwareInput(const std::string& data)
+{
+    input += data;
+}
+
+void firmwareOnOutput(std::function<void(const std::string&)> callback)
+{
+    outputCallback = callback;
+}
+
+std::string firmwareOutput()
+{
+    std::string out;
+    out.swap(output);
+    return out;
+}
+
+void firmwareOnInputWait(std::function<void(unsigned long ms)> wait)
+{
+    inputWait = wait;
+}
+
+void HardwareSerial::begin(unsigned long) {}
+
+int HardwareSerial::available()
+{
+    return (int)input.size();
+}
+
+int HardwareSerial::read()
+{
+    if (input.empty())
+        return -1;
+    int c = (uint8_t)input[0];
+    input.erase(0, 1);
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    return input.empty() ? -1 : (uint8_t)input[0];
+}
+
+size_t HardwareSerial::readBytesUntil(char terminator, char* buffer, size_t length)
+{
+    size_t n = 0;
+    bool waited = false;
+    while (n < length)
+    {
+        if (input.empty())
+        {
+            // Like the real one, wait up to the timeout for the rest of the line, once
+            if (waited || !inputWait)
+                break;
+            inputWait(timeoutMs);
+            waited = true;
+            continue;
+        }
+        char c = input[0];
+        input.erase(0, 1);
+        if (c == terminator)
+            break;
+        buffer[n++] = c;
+    }
+    return n;
+}
+
+long HardwareSerial::parseInt()
+{
+    // Skips anything that isn't part of a number, like Stream::parseInt()
+    while (!input.empty() && !isdigit((unsigned char)input[0]) && input[0] != '-')
+        input.erase(0, 1);
+    size_t used = 0;
+    long value = 0;
+    try
+    {
+        value = std::stol(input, &used);
+    }
+    catch (...)
+    {
+    }
+    input.erase(0, used);
+    return value;
+}
+
+// Bytes still to go out
+static unsigned long txPending()
+{
+    long left = (long)(txDoneUs - firmwareMicros());
+    return left > 0 ? (left + SERIAL_BYTE_US - 1) / SERIAL_BYTE_US : 0;
+}
+
+static void txWaitUntil(unsigned long us)
+{
+    if (realSpeed == 0)
+    {
+        if ((long)(us - firmwareMicros()) > 0)
+            firmwareAdvance(us - firmwareMicros());     // The stage timer still comes meanwhile, it's an interrupt
+        return;
+    }
+    while ((long)(us - firmwareMicros()) > 0)
+        ;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    unsigned long pending = txPending();
+    return pending < SERIAL_TX_ROOM ? (int)(SERIAL_TX_ROOM - pending) : 0;
+}
+
+void HardwareSerial::flush()
+{
+    txWaitUntil(txDoneUs);
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return write(std::string(1, (char)c).c_str());
+}
+
+size_t HardwareSerial::write(const char* s)
+{
+    size_t n = strlen(s);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (txPending() >= SERIAL_TX_ROOM)
+            txWaitUntil(txDoneUs - (SERIAL_TX_ROOM - 1) * SERIAL_BYTE_US);   // Until one is out
+        unsigned long now = firmwareMicros();
+        txDoneUs = ((long)(txDoneUs - now) > 0 ? txDoneUs : now) + SERIAL_BYTE_US;
+    }
+    if (outputCallback)
+        outputCallback(std::string(s, n));
+    else
+        output.append(s, n);
+    return n;
+}
+
+size_t HardwareSerial::print(long v)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", v);
+    return write(buf);
+}
+
+size_t HardwareSerial::print(unsigned long v)
+{
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%lu", v);
+    return write(buf);
+}
+
+size_t HardwareSerial::print(double v, int digits)
+{
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%.*f", digits, v);
+    return write(buf);
+}
+
+// ---- Servos and EEPROM ----
+
+uint8_t Servo::attach(int p, int, int)
+{
+    pin = p;
+    if (pin >= 0 && pin < MAX_PINS)
+        servoPulses[pin] = pulse;
+    return 0;
+}
+
+void Servo::detach()
+{
+    if (pin >= 0 && pin < MAX_PINS)
+        servoPulses[pin] = 0;
+    pin = -1;
+}
+
+void Servo::write(int degrees)
+{
+    writeMicroseconds(MIN_PULSE_WIDTH + (long)degrees * (MAX_PULSE_WIDTH - MIN_PULSE_WIDTH) / 180);
+}
+
+void Servo::writeMicroseconds(int us)
+{
+    pulse = us;
+    if (pin >= 0 && pin < MAX_PINS)
+        servoPulses[pin] = us;
+}
+
+int firmwareServoPulse(int pin)
+{
+    return pin >= 0 && pin < MAX_PINS ? servoPulses[pin] : 0;
+}
+
+uint8_t* firmwareEeprom()
+{
+    return EEPROM.data;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// The firmware in Arduino/ built for the PC. Sim/ stands in for the Arduino core, Servo and EEPROM, so the
+// same API.cpp, SequenceManager and MyServo code runs, byte for byte the same serial protocol. Build the
+// firmware sources together with Sim/*.cpp (the .ino needs -x c++, see Host/README.md).
+//
+// The clock is virtual: it only moves when the simulation moves it, so a simulated solve takes no real time
+// and comes out the same every run. firmwareRealTime() makes it follow the PC clock instead, which is what
+// fwsim does to put the firmware behind a pty.
+
+#define FIRMWARE_LOOP_US 100    // How far the virtual clock moves per loop(), a nano does a loop about this fast
+
+void firmwareStart();                       // setup(), once
+void firmwareLoop();                        // loop() once
+void firmwareRunFor(unsigned long us);      // loop() until the clock is us further
+
+void firmwareAdvance(unsigned long us);
+void firmwareRealTime(double speed);        // 1 is real time, 10 is ten times as fast
+unsigned long firmwareMicros();
+
+// The serial port. Output goes to the callback as it is printed, or is kept for firmwareOutput() without one
+void firmwareInput(const std::string& data);
+void firmwareOnOutput(std::function<void(const std::string&)> output);
+std::string firmwareOutput();               // Everything printed since the last call
+
+// Called when the firmware wants more input than there is (readBytesUntil() without a whole line), with how
+// long it is willing to wait in ms. Anything that arrives goes in with firmwareInput(). Without it, the firmware
+// times out right away
+void firmwareOnInputWait(std::function<void(unsigned long ms)> wait);
+
+// What the servos are doing, by pin: the last pulse written, 0 while detached
+int firmwareServoPulse(int pin);
+
+// The 1KB EEPROM, to load a calibration image (like caltool makes) before firmwareStart()
+uint8_t* firmwareEeprom();
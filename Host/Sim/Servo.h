@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+
+#define MIN_PULSE_WIDTH 544
+#define MAX_PULSE_WIDTH 2400
+
+// Keeps the pulse of each pin where the simulation can see it (see Firmware.h)
+class Servo
+{
+public:
+    uint8_t attach(int pin, int min = MIN_PULSE_WIDTH, int max = MAX_PULSE_WIDTH);
+    void detach();
+    void write(int degrees);
+    void writeMicroseconds(int us);
+    int readMicroseconds() const { return pulse; }
+    bool attached() const { return pin >= 0; }
+
+private:
+    int pin = -1;
+    int pulse = 1500;
+};
@@ -0,0 +1,518 @@
+#include "CubieCube.h"
+#include <algorithm>
+#include <cstring>
+
+// Facelet indices, U1 = 0 ... B9 = 53
+enum Facelet
+{
+    U1, U2, U3, U4, U5, U6, U7, U8, U9,
+    R1, R2, R3, R4, R5, R6, R7, R8, R9,
+    F1, F2, F3, F4, F5, F6, F7, F8, F9,
+    D1, D2, D3, D4, D5, D6, D7, D8, D9,
+    L1, L2, L3, L4, L5, L6, L7, L8, L9,
+    B1, B2, B3, B4, B5, B6, B7, B8, B9
+};
+
+static const char faceChars[] = "URFDLB";
+
+// Facelets of each corner/edge position, starting with the U or D facelet (or F/B for the slice edges)
+static const uint8_t cornerFacelet[N_CORNERS][3] = {
+    {U9, R1, F3}, {U7, F1, L3}, {U1, L1, B3}, {U3, B1, R3},
+    {D3, F9, R7}, {D1, L9, F7}, {D7, B9, L7}, {D9, R9, B7}
+};
+static const uint8_t edgeFacelet[N_EDGES][2] = {
+    {U6, R2}, {U8, F2}, {U4, L2}, {U2, B2}, {D6, R8}, {D2, F8},
+    {D4, L8}, {D8, B8}, {F6, R4}, {F4, L6}, {B6, L4}, {B4, R6}
+};
+static const uint8_t cornerColor[N_CORNERS][3] = {
+    {FACE_U, FACE_R, FACE_F}, {FACE_U, FACE_F, FACE_L}, {FACE_U, FACE_L, FACE_B}, {FACE_U, FACE_B, FACE_R},
+    {FACE_D, FACE_F, FACE_R}, {FACE_D, FACE_L, FACE_F}, {FACE_D, FACE_B, FACE_L}, {FACE_D, FACE_R, FACE_B}
+};
+static const uint8_t edgeColor[N_EDGES][2] = {
+    {FACE_U, FACE_R}, {FACE_U, FACE_F}, {FACE_U, FACE_L}, {FACE_U, FACE_B}, {FACE_D, FACE_R}, {FACE_D, FACE_F},
+    {FACE_D, FACE_L}, {FACE_D, FACE_B}, {FACE_F, FACE_R}, {FACE_F, FACE_L}, {FACE_B, FACE_L}, {FACE_B, FACE_R}
+};
+
+// n choose k
+static int cnk(int n, int k)
+{
+    if (k > n)
+        return 0;
+    if (k > n / 2)
+        k = n - k;
+    int s = 1;
+    for (int i = n, j = 1; i != n - k; i--, j++)
+        s = s * i / j;
+    return s;
+}
+
+template <typename T>
+static void rotateLeft(T* arr, int left, int right)
+{
+    T temp = arr[left];
+    for (int i = left; i < right; i++)
+        arr[i] = arr[i + 1];
+    arr[right] = temp;
+}
+
+template <typename T>
+static void rotateRight(T* arr, int left, int right)
+{
+    T temp = arr[right];
+    for (int i = right; i > left; i--)
+        arr[i] = arr[i - 1];
+    arr[left] = temp;
+}
+
+CubieCube::CubieCube()
+{
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        cp[i] = i;
+        co[i] = 0;
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        ep[i] = i;
+        eo[i] = 0;
+    }
+}
+
+static CubieCube makeCube(const uint8_t* cp, const uint8_t* co, const uint8_t* ep, const uint8_t* eo)
+{
+    CubieCube c;
+    std::memcpy(c.cp, cp, N_CORNERS);
+    std::memcpy(c.co, co, N_CORNERS);
+    std::memcpy(c.ep, ep, N_EDGES);
+    std::memcpy(c.eo, eo, N_EDGES);
+    return c;
+}
+
+const CubieCube& CubieCube::basicMove(int face)
+{
+    static const uint8_t noCo[N_CORNERS] = {};
+    static const uint8_t noEo[N_EDGES] = {};
+
+    static const uint8_t cpU[] = {UBR, URF, UFL, ULB, DFR, DLF, DBL, DRB};
+    static const uint8_t epU[] = {UB, UR, UF, UL, DR, DF, DL, DB, FR, FL, BL, BR};
+
+    static const uint8_t cpR[] = {DFR, UFL, ULB, URF, DRB, DLF, DBL, UBR};
+    static const uint8_t coR[] = {2, 0, 0, 1, 1, 0, 0, 2};
+    static const uint8_t epR[] = {FR, UF, UL, UB, BR, DF, DL, DB, DR, FL, BL, UR};
+
+    static const uint8_t cpF[] = {UFL, DLF, ULB, UBR, URF, DFR, DBL, DRB};
+    static const uint8_t coF[] = {1, 2, 0, 0, 2, 1, 0, 0};
+    static const uint8_t epF[] = {UR, FL, UL, UB, DR, FR, DL, DB, UF, DF, BL, BR};
+    static const uint8_t eoF[] = {0, 1, 0, 0, 0, 1, 0, 0, 1, 1, 0, 0};
+
+    static const uint8_t cpD[] = {URF, UFL, ULB, UBR, DLF, DBL, DRB, DFR};
+    static const uint8_t epD[] = {UR, UF, UL, UB, DF, DL, DB, DR, FR, FL, BL, BR};
+
+    static const uint8_t cpL[] = {URF, ULB, DBL, UBR, DFR, UFL, DLF, DRB};
+    static const uint8_t coL[] = {0, 1, 2, 0, 0, 2, 1, 0};
+    static const uint8_t epL[] = {UR, UF, BL, UB, DR, DF, FL, DB, FR, UL, DL, BR};
+
+    static const uint8_t cpB[] = {URF, UFL, UBR, DRB, DFR, DLF, ULB, DBL};
+    static const uint8_t coB[] = {0, 0, 1, 2, 0, 0, 2, 1};
+    static const uint8_t epB[] = {UR, UF, UL, BR, DR, DF, DL, BL, FR, FL, UB, DB};
+    static const uint8_t eoB[] = {0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1};
+
+    static const CubieCube moves[6] = {
+        makeCube(cpU, noCo, epU, noEo),
+        makeCube(cpR, coR, epR, noEo),
+        makeCube(cpF, coF, epF, eoF),
+        makeCube(cpD, noCo, epD, noEo),
+        makeCube(cpL, coL, epL, noEo),
+        makeCube(cpB, coB, epB, eoB),
+    };
+    return moves[face];
+}
+
+void CubieCube::multiply(const CubieCube& b)
+{
+    uint8_t ncp[N_CORNERS], nco[N_CORNERS], nep[N_EDGES], neo[N_EDGES];
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        ncp[i] = cp[b.cp[i]];
+        nco[i] = (co[b.cp[i]] + b.co[i]) % 3;
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        nep[i] = ep[b.ep[i]];
+        neo[i] = (eo[b.ep[i]] + b.eo[i]) % 2;
+    }
+    std::memcpy(cp, ncp, N_CORNERS);
+    std::memcpy(co, nco, N_CORNERS);
+    std::memcpy(ep, nep, N_EDGES);
+    std::memcpy(eo, neo, N_EDGES);
+}
+
+void CubieCube::move(int m)
+{
+    const CubieCube& face = basicMove(m / 3);
+    for (int i = 0; i <= m % 3; i++)
+        multiply(face);
+}
+
+void CubieCube::applyMoves(const std::vector<int>& moves)
+{
+    for (int m : moves)
+        move(m);
+}
+
+CubieCube CubieCube::inverse() const
+{
+    CubieCube inv;
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        inv.cp[cp[i]] = i;
+    }
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        inv.co[i] = (3 - co[inv.cp[i]]) % 3;
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        inv.ep[ep[i]] = i;
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        inv.eo[i] = eo[inv.ep[i]];
+    }
+    return inv;
+}
+
+bool CubieCube::operator==(const CubieCube& other) const
+{
+    return std::memcmp(cp, other.cp, N_CORNERS) == 0 && std::memcmp(co, other.co, N_CORNERS) == 0 &&
+           std::memcmp(ep, other.ep, N_EDGES) == 0 && std::memcmp(eo, other.eo, N_EDGES) == 0;
+}
+
+// ====================
+// Facelets
+// ====================
+
+int CubieCube::fromFacelets(const std::string& facelets)
+{
+    if (facelets.size() != 54)
+        return 1;
+
+    uint8_t f[54];
+    int count[6] = {};
+    for (int i = 0; i < 54; i++)
+    {
+        const char* c = std::strchr(faceChars, facelets[i]);
+        if (!c || *c == '\0')
+            return 1;
+        f[i] = c - faceChars;
+        count[f[i]]++;
+    }
+    for (int i = 0; i < 6; i++)
+    {
+        if (count[i] != 9)
+            return 1;
+        if (f[9 * i + 4] != i)
+            return 1;   // Centers must be in URFDLB order
+    }
+
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        int ori;
+        for (ori = 0; ori < 3; ori++)
+        {
+            if (f[cornerFacelet[i][ori]] == FACE_U || f[cornerFacelet[i][ori]] == FACE_D)
+                break;
+        }
+        if (ori == 3)
+            return 4;
+        int col1 = f[cornerFacelet[i][(ori + 1) % 3]];
+        int col2 = f[cornerFacelet[i][(ori + 2) % 3]];
+        int j;
+        for (j = 0; j < N_CORNERS; j++)
+        {
+            if (col1 == cornerColor[j][1] && col2 == cornerColor[j][2])
+                break;
+        }
+        if (j == N_CORNERS)
+            return 4;
+        cp[i] = j;
+        co[i] = ori;
+    }
+
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        int j;
+        for (j = 0; j < N_EDGES; j++)
+        {
+            if (f[edgeFacelet[i][0]] == edgeColor[j][0] && f[edgeFacelet[i][1]] == edgeColor[j][1])
+            {
+                ep[i] = j;
+                eo[i] = 0;
+                break;
+            }
+            if (f[edgeFacelet[i][0]] == edgeColor[j][1] && f[edgeFacelet[i][1]] == edgeColor[j][0])
+            {
+                ep[i] = j;
+                eo[i] = 1;
+                break;
+            }
+        }
+        if (j == N_EDGES)
+            return 2;
+    }
+    return verify();
+}
+
+std::string CubieCube::toFacelets() const
+{
+    std::string s(54, '?');
+    for (int i = 0; i < 6; i++)
+        s[9 * i + 4] = faceChars[i];
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        for (int n = 0; n < 3; n++)
+            s[cornerFacelet[i][(n + co[i]) % 3]] = faceChars[cornerColor[cp[i]][n]];
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        for (int n = 0; n < 2; n++)
+            s[edgeFacelet[i][(n + eo[i]) % 2]] = faceChars[edgeColor[ep[i]][n]];
+    }
+    return s;
+}
+
+static int permutationParity(const uint8_t* perm, int n)
+{
+    int s = 0;
+    for (int i = n - 1; i > 0; i--)
+    {
+        for (int j = i - 1; j >= 0; j--)
+        {
+            if (perm[j] > perm[i])
+                s++;
+        }
+    }
+    return s % 2;
+}
+
+// Error codes match twophase.jar where it makes sense
+int CubieCube::verify() const
+{
+    int edgeCount[N_EDGES] = {};
+    int flipSum = 0;
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        edgeCount[ep[i]]++;
+        flipSum += eo[i];
+    }
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        if (edgeCount[i] != 1)
+            return 2;
+    }
+    if (flipSum % 2 != 0)
+        return 3;
+
+    int cornerCount[N_CORNERS] = {};
+    int twistSum = 0;
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        cornerCount[cp[i]]++;
+        twistSum += co[i];
+    }
+    for (int i = 0; i < N_CORNERS; i++)
+    {
+        if (cornerCount[i] != 1)
+            return 4;
+    }
+    if (twistSum % 3 != 0)
+        return 5;
+
+    if (permutationParity(ep, N_EDGES) != permutationParity(cp, N_CORNERS))
+        return 6;
+    return 0;
+}
+
+const char* CubieCube::errorText(int error)
+{
+    switch (error)
+    {
+    case 0: return "OK";
+    case 1: return "There are not exactly nine facelets of each color, or the centers are not in URFDLB order";
+    case 2: return "Not all 12 edges exist exactly once";
+    case 3: return "Flip error: one edge has to be flipped";
+    case 4: return "Not all 8 corners exist exactly once";
+    case 5: return "Twist error: one corner has to be twisted";
+    case 6: return "Parity error: two corners or two edges have to be exchanged";
+    default: return "Unknown error";
+    }
+}
+
+// ====================
+// Coordinates
+// ====================
+
+int CubieCube::getTwist() const
+{
+    int twist = 0;
+    for (int i = URF; i < DRB; i++)
+        twist = 3 * twist + co[i];
+    return twist;
+}
+
+void CubieCube::setTwist(int twist)
+{
+    int twistParity = 0;
+    for (int i = DRB - 1; i >= URF; i--)
+    {
+        co[i] = twist % 3;
+        twistParity += co[i];
+        twist /= 3;
+    }
+    co[DRB] = (3 - twistParity % 3) % 3;
+}
+
+int CubieCube::getFlip() const
+{
+    int flip = 0;
+    for (int i = UR; i < BR; i++)
+        flip = 2 * flip + eo[i];
+    return flip;
+}
+
+void CubieCube::setFlip(int flip)
+{
+    int flipParity = 0;
+    for (int i = BR - 1; i >= UR; i--)
+    {
+        eo[i] = flip % 2;
+        flipParity += eo[i];
+        flip /= 2;
+    }
+    eo[BR] = (2 - flipParity % 2) % 2;
+}
+
+// Position of the four slice edges (a < 495) and their order (b < 24). In phase 2 a is 0.
+int CubieCube::getSliceSorted() const
+{
+    int a = 0, x = 0;
+    uint8_t edge4[4];
+    for (int j = BR; j >= UR; j--)
+    {
+        if (ep[j] >= FR)
+        {
+            a += cnk(11 - j, x + 1);
+            edge4[3 - x] = ep[j];
+            x++;
+        }
+    }
+
+    int b = 0;
+    for (int j = 3; j > 0; j--)
+    {
+        int k = 0;
+        while (edge4[j] != j + 8)
+        {
+            rotateLeft(edge4, 0, j);
+            k++;
+        }
+        b = (j + 1) * b + k;
+    }
+    return N_PERM_4 * a + b;
+}
+
+void CubieCube::setSliceSorted(int idx)
+{
+    uint8_t sliceEdge[4] = {FR, FL, BL, BR};
+    static const uint8_t otherEdge[8] = {UR, UF, UL, UB, DR, DF, DL, DB};
+    int b = idx % N_PERM_4;
+    int a = idx / N_PERM_4;
+
+    for (int j = 1; j < 4; j++)
+    {
+        int k = b % (j + 1);
+        b /= j + 1;
+        while (k-- > 0)
+            rotateRight(sliceEdge, 0, j);
+    }
+
+    std::memset(ep, 0xFF, N_EDGES);
+    int x = 4;
+    for (int j = UR; j <= BR; j++)
+    {
+        if (a - cnk(11 - j, x) >= 0)
+        {
+            ep[j] = sliceEdge[4 - x];
+            a -= cnk(11 - j, x);
+            x--;
+        }
+    }
+    x = 0;
+    for (int j = UR; j <= BR; j++)
+    {
+        if (ep[j] == 0xFF)
+            ep[j] = otherEdge[x++];
+    }
+}
+
+int CubieCube::getCorners() const
+{
+    uint8_t perm[N_CORNERS];
+    std::memcpy(perm, cp, N_CORNERS);
+    int b = 0;
+    for (int j = DRB; j > URF; j--)
+    {
+        int k = 0;
+        while (perm[j] != j)
+        {
+            rotateLeft(perm, 0, j);
+            k++;
+        }
+        b = (j + 1) * b + k;
+    }
+    return b;
+}
+
+void CubieCube::setCorners(int idx)
+{
+    for (int i = 0; i < N_CORNERS; i++)
+        cp[i] = i;
+    for (int j = URF; j <= DRB; j++)
+    {
+        int k = idx % (j + 1);
+        idx /= j + 1;
+        while (k-- > 0)
+            rotateRight(cp, 0, j);
+    }
+}
+
+int CubieCube::getUdEdges() const
+{
+    uint8_t perm[8];
+    std::memcpy(perm, ep, 8);
+    int b = 0;
+    for (int j = DB; j > UR; j--)
+    {
+        int k = 0;
+        while (perm[j] != j)
+        {
+            rotateLeft(perm, 0, j);
+            k++;
+        }
+        b = (j + 1) * b + k;
+    }
+    return b;
+}
+
+void CubieCube::setUdEdges(int idx)
+{
+    for (int i = 0; i < N_EDGES; i++)
+        ep[i] = i;
+    for (int j = UR; j <= DB; j++)
+    {
+        int k = idx % (j + 1);
+        idx /= j + 1;
+        while (k-- > 0)
+            rotateRight(ep, 0, j);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Cube on the cubie level: which corner/edge sits where and how it is twisted/flipped.
+// Same conventions as Kociemba's two-phase algorithm (and twophase.jar used by the app),
+// so facelet strings are 54 characters in the order U1..U9 R1..R9 F1..F9 D1..D9 L1..L9 B1..B9.
+
+enum Corner { URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB };
+enum Edge { UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR };
+enum Face { FACE_U, FACE_R, FACE_F, FACE_D, FACE_L, FACE_B };
+
+#define N_CORNERS 8
+#define N_EDGES 12
+
+// Moves are numbered 3 * face + (quarter turns - 1): U, U2, U', R, R2, R', F, ... B'
+#define N_MOVES 18
+
+// Coordinate sizes
+#define N_TWIST 2187        // 3^7 corner orientations
+#define N_FLIP 2048         // 2^11 edge orientations
+#define N_SLICE 495         // 12 choose 4 positions of the FR, FL, BL, BR edges
+#define N_SLICE_SORTED 11880 // Positions and order of the FR, FL, BL, BR edges
+#define N_PERM_4 24
+#define N_CORNERS_PERM 40320 // 8! corner permutations
+#define N_UD_EDGES 40320    // 8! permutations of the U and D layer edges (phase 2 only)
+
+struct CubieCube
+{
+    uint8_t cp[N_CORNERS];
+    uint8_t co[N_CORNERS];
+    uint8_t ep[N_EDGES];
+    uint8_t eo[N_EDGES];
+
+    CubieCube();    // Solved cube
+
+    // Parse a 54 facelet string. Returns 0 if OK, or an error code (see errorText())
+    int fromFacelets(const std::string& facelets);
+    std::string toFacelets() const;
+
+    // Check the cube can actually be reached by turning faces. Returns 0 if OK, or an error code (see errorText())
+    int verify() const;
+    static const char* errorText(int error);
+
+    // this = this * other
+    void multiply(const CubieCube& other);
+    void move(int m);
+    void applyMoves(const std::vector<int>& moves);
+    CubieCube inverse() const;
+
+    bool operator==(const CubieCube& other) const;
+    bool isSolved() const { return *this == CubieCube(); }
+
+    // Coordinates
+    int getTwist() const;
+    void setTwist(int twist);
+    int getFlip() const;
+    void setFlip(int flip);
+    int getSlice() const { return getSliceSorted() / N_PERM_4; }
+    int getSliceSorted() const;
+    void setSliceSorted(int idx);
+    int getCorners() const;
+    void setCorners(int idx);
+    int getUdEdges() const;     // Only valid if the U and D edges are in the U and D layers (phase 2)
+    void setUdEdges(int idx);
+
+    static const CubieCube& basicMove(int face);
+};
@@ -0,0 +1,794 @@
+#include "GripperModel.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#define MAX_UNITS 63        // Commands a string may have, they are bits of a mask
+#define MAX_DEPS 2          // TIMELINE_MAX_DEPS, Timeline.h needs the Arduino headers
+#define MAX_STAGES 16       // Deeper than that the search gives up
+
+static const char servoChars[] = "rRlLfFbB";    // In ServoType order
+static const char stateChars[] = "CLRrl";       // In ServoState order
+
+static int servoIndex(char c)
+{
+    const char* p = std::strchr(servoChars, c);
+    return c && p ? (int)(p - servoChars) : -1;
+}
+
+static int stateIndex(char c)
+{
+    const char* p = std::strchr(stateChars, c);
+    return c && p ? (int)(p - stateChars) : -1;
+}
+
+// Which way a spinner points: R +1, L -1, C 0, -2 for the halfway states it doesn't go to
+static int spinnerTurn(int state)
+{
+    switch (state)
+    {
+    case STATE_C: return 0;
+    case STATE_R: return 1;
+    case STATE_L: return -1;
+    }
+    return -2;
+}
+
+// The face (URFDLB) a gripper holds with the cube turned over body times. Front and back always hold F and B,
+// right and left go around R U L D
+static int faceAt(int gripper, int body)
+{
+    static const int ring[4] = {1, 0, 4, 3};
+    if (gripper >= 2)
+        return gripper == 2 ? 2 : 5;
+    return ring[(gripper * 2 + body) % 4];
+}
+
+GripWorld::GripWorld() : body(0)
+{
+    for (int i = 0; i < MOVE_SERVOS; i++)
+        pos[i] = STATE_C;
+    for (int i = 0; i < 6; i++)
+        faces[i] = 0;
+}
+
+uint64_t GripWorld::key() const
+{
+    uint64_t k = body;
+    for (int i = 0; i < 6; i++)
+        k = k << 2 | faces[i];
+    for (int i = 0; i < MOVE_SERVOS; i++)
+        k = k << 3 | pos[i];
+    return k;
+}
+
+int GripModel::grip(int state) const
+{
+    switch (state)
+    {
+    case STATE_R: return 0;
+    case STATE_C: return 1;
+    case STATE_L: return 2;
+    case STATE_r: return partial ? 0 : -1;
+    case STATE_l: return partial ? 2 : -1;
+    }
+    return -1;
+}
+
+bool GripModel::held(const GripWorld& world, int without) const
+{
+    int g[4];
+    for (int i = 0; i < 4; i++)
+        g[i] = i == without ? 0 : grip(world.pos[2 * i + 1]);
+    for (int side = 0; side < 4; side += 2)
+    {
+        int other = std::max(g[side ^ 2], g[(side ^ 2) + 1]);
+        if (g[side] >= 2 && g[side + 1] >= 2)
+            return true;
+        if (g[side] >= 1 && g[side + 1] >= 1 && other >= 1)
+            return true;
+    }
+    return false;
+}
+
+// A spinner or a slider on its own
+static bool applyOne(const GripModel& model, GripWorld& world, int servo, int state)
+{
+    if (servo % 2 == 1)
+    {
+        if (model.grip(state) < 0)
+            return false;
+    }
+    else
+    {
+        if (spinnerTurn(state) < -1)
+            return false;
+        int gripper = servo / 2;
+        int delta = spinnerTurn(state) - spinnerTurn(world.pos[servo]);
+        if (delta != 0 && model.grip(world.pos[servo + 1]) > 0)
+        {
+            // It takes the face with it, the others have to hold the cube meanwhile
+            if (!model.faceTurns || !model.held(world, gripper))
+                return false;
+            int8_t& face = world.faces[faceAt(gripper, world.body)];
+            face = (int8_t)((face + delta + 4) % 4);
+        }
+    }
+    world.pos[servo] = (int8_t)state;
+    return model.held(world);
+}
+
+bool GripModel::apply(GripWorld& world, int count, const int* servos, const int* states) const
+{
+    if (count == 1)
+        return applyOne(*this, world, servos[0], states[0]);
+
+    // Front and back spinners at once. Both pressing with right and left clear they turn the cube over
+    int f = servos[0] == FRONT_SPINNER ? 0 : 1;
+    int b = 1 - f;
+    int df = spinnerTurn(states[f]) - spinnerTurn(world.pos[FRONT_SPINNER]);
+    int db = spinnerTurn(states[b]) - spinnerTurn(world.pos[BACK_SPINNER]);
+    if (flips && spinnerTurn(states[f]) >= -1 && spinnerTurn(states[b]) >= -1 && df != 0 && df == -db &&
+        grip(world.pos[FRONT_SLIDER]) >= 2 && grip(world.pos[BACK_SLIDER]) >= 2 &&
+        grip(world.pos[RIGHT_SLIDER]) == 0 && grip(world.pos[LEFT_SLIDER]) == 0)
+    {
+        world.body = (int8_t)((world.body + df + 4) % 4);
+        world.pos[FRONT_SPINNER] = (int8_t)states[f];
+        world.pos[BACK_SPINNER] = (int8_t)states[b];
+        return held(world);
+    }
+
+    // Otherwise it's two things that may happen either way round
+    GripWorld other = world;
+    if (!applyOne(*this, world, servos[0], states[0]) || !applyOne(*this, world, servos[1], states[1]))
+        return false;
+    if (!applyOne(*this, other, servos[1], states[1]) || !applyOne(*this, other, servos[0], states[0]))
+        return false;
+    return world == other;
+}
+
+// ---- Playing strings ----
+
+// A command of a SEQ string (with the second C of a spinner going to true center), or the front and back
+// spinners going out together
+struct GripUnit
+{
+    int count = 1;
+    int servos[2];
+    int states[2];
+    std::vector<int> deps;          // Units it waits for
+    int barrier = 0;                // Units before this one wait for W or a delay
+    std::string text;
+};
+
+static bool sameDeps(std::vector<int> a, std::vector<int> b)
+{
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    return a == b;
+}
+
+static bool parseUnits(const std::string& seq, std::vector<GripUnit>& units, std::string& why)
+{
+    int latest[MOVE_SERVOS];
+    std::fill(latest, latest + MOVE_SERVOS, -1);
+    std::vector<std::vector<int>> depServos;    // Which servos of each dependency a unit waits for
+    int barrier = 0;
+    for (size_t i = 0; i < seq.size(); )
+    {
+        char c = seq[i];
+        if (c == 'W' || c == '|' || std::isdigit((unsigned char)c))
+        {
+            while (i < seq.size() && std::isdigit((unsigned char)seq[i]))
+                i++;
+            if (!std::isdigit((unsigned char)c))
+                i++;
+            barrier = (int)units.size();
+            continue;
+        }
+
+        int servo = servoIndex(c);
+        int state = i + 1 < seq.size() ? stateIndex(seq[i + 1]) : -1;
+        if (servo < 0 || state < 0)
+        {
+            why = "can't read \"" + seq.substr(i) + "\"";
+            return false;
+        }
+        GripUnit unit;
+        unit.servos[0] = servo;
+        unit.states[0] = state;
+        unit.barrier = barrier;
+        unit.text = seq.substr(i, 2);
+        std::vector<int> servosOf;
+        for (i += 2; i < seq.size() && seq[i] == '@'; i += 3)
+        {
+            int dep = i + 1 < seq.size() ? servoIndex(seq[i + 1]) : -1;
+            int depState = i + 2 < seq.size() ? stateIndex(seq[i + 2]) : -1;
+            if (dep < 0 || depState < 0)
+            {
+                why = "can't read \"" + seq.substr(i) + "\"";
+                return false;
+            }
+            unit.text += seq.substr(i, 3);
+
+            // Like Timeline: the latest command of that servo so far, which has to go to that state.
+            // Before the string everything is at C
+            int at = latest[dep];
+            int atState = STATE_C;
+            if (at >= 0)
+                atState = units[at].states[units[at].servos[0] == dep ? 0 : 1];
+            if (atState != depState)
+            {
+                why = unit.text + " waits for a state its servo won't be in";
+                return false;
+            }
+            if (at >= 0)
+            {
+                unit.deps.push_back(at);
+                servosOf.push_back(dep);
+            }
+        }
+
+        GripUnit* last = !units.empty() && units.back().barrier == barrier ? &units.back() : nullptr;
+        if (last && unit.deps.empty())
+        {
+            bool again = false;
+            for (int k = 0; k < last->count; k++)
+                again = again || (last->servos[k] == servo && last->states[k] == state);
+            if (again)
+            {
+                last->text += unit.text;
+                continue;
+            }
+        }
+        if (last && last->count == 1 && ((last->servos[0] == FRONT_SPINNER && servo == BACK_SPINNER) ||
+                                         (last->servos[0] == BACK_SPINNER && servo == FRONT_SPINNER)) &&
+            sameDeps(last->deps, unit.deps))
+        {
+            last->count = 2;
+            last->servos[1] = servo;
+            last->states[1] = state;
+            last->text += unit.text;
+            for (int s : servosOf)
+                depServos.back().push_back(s);
+            latest[servo] = (int)units.size() - 1;
+            continue;
+        }
+        if (units.size() >= MAX_UNITS)
+        {
+            why = "too many commands";
+            return false;
+        }
+        std::sort(unit.deps.begin(), unit.deps.end());
+        unit.deps.erase(std::unique(unit.deps.begin(), unit.deps.end()), unit.deps.end());
+        units.push_back(unit);
+        depServos.push_back(servosOf);
+        latest[servo] = (int)units.size() - 1;
+    }
+
+    // Waiting for one spinner of a cube turning over says nothing about the other one
+    for (size_t u = 0; u < units.size(); u++)
+    {
+        for (int d : units[u].deps)
+        {
+            if (units[d].count < 2)
+                continue;
+            const std::vector<int>& s = depServos[u];
+            if (std::find(s.begin(), s.end(), units[d].servos[0]) == s.end() ||
+                std::find(s.begin(), s.end(), units[d].servos[1]) == s.end())
+            {
+                why = units[u].text + " waits for only one spinner of " + units[d].text;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint64_t below(int n)
+{
+    return n >= 64 ? ~0ULL : (1ULL << n) - 1;
+}
+
+struct PairHash
+{
+    size_t operator()(const std::pair<uint64_t, uint64_t>& p) const
+    {
+        return std::hash<uint64_t>()(p.first * 0x9E3779B97F4A7C15ULL ^ p.second);
+    }
+};
+
+// Goes through every order units may be done in, each unit waiting for the ones in its need mask
+struct GripExplorer
+{
+    const GripModel& model;
+    const std::vector<GripUnit>& units;
+    std::vector<uint64_t> need;
+    std::unordered_set<std::pair<uint64_t, uint64_t>, PairHash> seen;
+    std::vector<int> path;
+    GripWorld end;
+    bool ended = false;
+    std::string why;
+
+    GripExplorer(const GripModel& m, const std::vector<GripUnit>& u) : model(m), units(u), need(u.size(), 0) {}
+
+    std::string pathText() const
+    {
+        if (path.empty())
+            return "at the start";
+        std::string out = "after";
+        for (int u : path)
+            out += " " + units[u].text;
+        return out;
+    }
+
+    bool explore(uint64_t done, const GripWorld& world)
+    {
+        if (!seen.insert({done, world.key()}).second)
+            return true;
+        if (done == below((int)units.size()))
+        {
+            if (!ended)
+            {
+                end = world;
+                ended = true;
+            }
+            else if (!(end == world))
+            {
+                why = "the cube ends up different " + pathText();
+                return false;
+            }
+            return true;
+        }
+        for (size_t u = 0; u < units.size(); u++)
+        {
+            if ((done >> u & 1) || (need[u] & ~done))
+                continue;
+            GripWorld next = world;
+            if (!model.apply(next, units[u].count, units[u].servos, units[u].states))
+            {
+                why = units[u].text + " isn't safe " + pathText();
+                return false;
+            }
+            path.push_back((int)u);
+            if (!explore(done | 1ULL << u, next))
+                return false;
+            path.pop_back();
+        }
+        return true;
+    }
+};
+
+bool gripVerify(const GripModel& model, const std::string& seq, GripWorld& end, std::string& why)
+{
+    std::vector<GripUnit> units;
+    if (!parseUnits(seq, units, why))
+        return false;
+
+    // A command waits for what comes before W, its dependencies and the command of its servo before it. The
+    // firmware sends a servo on as soon as the one before went out though, so that one has to be done
+    // already through the rest
+    GripExplorer explorer(model, units);
+    std::vector<uint64_t> surely(units.size());
+    int latest[MOVE_SERVOS];
+    std::fill(latest, latest + MOVE_SERVOS, -1);
+    for (size_t u = 0; u < units.size(); u++)
+    {
+        uint64_t mask = below(units[u].barrier);
+        for (int d : units[u].deps)
+            mask |= 1ULL << d | surely[d];
+        surely[u] = mask;
+        explorer.need[u] = mask;
+        for (int k = 0; k < units[u].count; k++)
+        {
+            int before = latest[units[u].servos[k]];
+            if (before >= 0 && !(mask >> before & 1))
+            {
+                why = units[u].text + " may cut " + units[before].text + " short";
+                return false;
+            }
+            latest[units[u].servos[k]] = (int)u;
+        }
+    }
+
+    if (!explorer.explore(0, GripWorld()))
+    {
+        why = explorer.why;
+        return false;
+    }
+    end = explorer.end;
+    return true;
+}
+
+bool gripPlay(const GripModel& model, const std::string& seq, GripWorld& end, std::string& why)
+{
+    std::vector<GripUnit> units;
+    if (!parseUnits(seq, units, why))
+        return false;
+    end = GripWorld();
+    for (const GripUnit& unit : units)
+    {
+        if (!model.apply(end, unit.count, unit.servos, unit.states))
+        {
+            why = unit.text + " isn't safe";
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---- Search ----
+
+// The commands of a stage as units, front and back spinners together
+static std::vector<GripUnit> stageUnits(const GripStage& stage)
+{
+    std::vector<GripUnit> units;
+    int front = -1;
+    int back = -1;
+    for (const GripCommand& c : stage)
+    {
+        if (c.servo == FRONT_SPINNER)
+            front = c.state;
+        else if (c.servo == BACK_SPINNER)
+            back = c.state;
+        else
+        {
+            GripUnit unit;
+            unit.servos[0] = c.servo;
+            unit.states[0] = c.state;
+            units.push_back(unit);
+        }
+    }
+    if (front >= 0 || back >= 0)
+    {
+        GripUnit unit;
+        if (front >= 0)
+        {
+            unit.servos[0] = FRONT_SPINNER;
+            unit.states[0] = front;
+        }
+        if (back >= 0)
+        {
+            unit.count = front >= 0 ? 2 : 1;
+            unit.servos[unit.count - 1] = BACK_SPINNER;
+            unit.states[unit.count - 1] = back;
+        }
+        units.push_back(unit);
+    }
+    return units;
+}
+
+// Safe whichever order the commands of the stage get done in, end is where it leaves everything
+static bool stageSafe(const GripModel& model, const GripWorld& from, const GripStage& stage, GripWorld& end)
+{
+    std::vector<GripUnit> units = stageUnits(stage);
+    GripExplorer explorer(model, units);
+    if (!explorer.explore(0, from))
+        return false;
+    end = explorer.end;
+    return true;
+}
+
+struct SearchNode
+{
+    GripWorld world;
+    int depth;
+    std::vector<std::pair<uint64_t, GripStage>> from;     // The positions a stage before and the stage
+};
+
+std::vector<GripScript> gripSearch(const GripModel& model, const GripWorld& goal, const std::vector<int>& servos,
+                                   size_t limit, size_t& explored)
+{
+    // Front and back spinners first, together they do something else than each on its own, after that a stage
+    // that isn't safe only gets worse with more in it
+    std::vector<int> order;
+    for (int s : {FRONT_SPINNER, BACK_SPINNER})
+    {
+        if (std::find(servos.begin(), servos.end(), s) != servos.end())
+            order.push_back(s);
+    }
+    for (int s : servos)
+    {
+        if (s != FRONT_SPINNER && s != BACK_SPINNER)
+            order.push_back(s);
+    }
+
+    std::unordered_map<uint64_t, SearchNode> nodes;
+    GripWorld start;
+    nodes[start.key()] = {start, 0, {}};
+    std::vector<uint64_t> frontier = {start.key()};
+    uint64_t goalKey = goal.key();
+    for (int depth = 0; depth < MAX_STAGES && !frontier.empty() && !nodes.count(goalKey); depth++)
+    {
+        std::vector<uint64_t> next;
+        for (uint64_t key : frontier)
+        {
+            const GripWorld world = nodes[key].world;
+            GripStage stage;
+            std::function<void(size_t)> extend = [&](size_t i)
+            {
+                if (i == order.size())
+                {
+                    GripWorld end;
+                    if (stage.empty() || !stageSafe(model, world, stage, end))
+                        return;
+                    auto it = nodes.find(end.key());
+                    if (it == nodes.end())
+                    {
+                        nodes[end.key()] = {end, depth + 1, {{key, stage}}};
+                        next.push_back(end.key());
+                    }
+                    else if (it->second.depth == depth + 1)
+                        it->second.from.push_back({key, stage});
+                    return;
+                }
+                extend(i + 1);
+                int servo = order[i];
+                for (int state = STATE_C; state <= STATE_l; state++)
+                {
+                    bool usable = servo % 2 == 1 ? model.grip(state) >= 0 : spinnerTurn(state) >= -1;
+                    if (!usable || state == world.pos[servo])
+                        continue;
+                    stage.push_back({servo, state});
+                    GripWorld end;
+                    bool pairPending = servo == FRONT_SPINNER && i + 1 < order.size() && order[i + 1] == BACK_SPINNER;
+                    if (pairPending || stageSafe(model, world, stage, end))
+                        extend(i + 1);
+                    stage.pop_back();
+                }
+            };
+            extend(0);
+        }
+        frontier = next;
+    }
+    explored = nodes.size();
+
+    std::vector<GripScript> scripts;
+    if (!nodes.count(goalKey))
+        return scripts;
+    GripScript reversed;
+    std::function<void(uint64_t)> back = [&](uint64_t key)
+    {
+        if (scripts.size() >= limit)
+            return;
+        const SearchNode& node = nodes[key];
+        if (node.depth == 0)
+        {
+            scripts.push_back(GripScript(reversed.rbegin(), reversed.rend()));
+            return;
+        }
+        for (const auto& from : node.from)
+        {
+            reversed.push_back(from.second);
+            back(from.first);
+            reversed.pop_back();
+        }
+    };
+    back(goalKey);
+    return scripts;
+}
+
+// ---- Templates ----
+
+static std::string commandText(const GripCommand& c, GripTemplate kind)
+{
+    std::string out;
+    out += kind == GRIP_TURN ? (c.servo % 2 ? 'S' : 's') : servoChars[c.servo];
+    if (c.servo % 2 == 0 && c.state == STATE_R)
+        out += kind == GRIP_TURN ? 'd' : 'x';
+    else if (c.servo % 2 == 0 && c.state == STATE_L)
+        out += kind == GRIP_TURN ? 'e' : 'y';
+    else
+        out += stateChars[c.state];
+    return out;
+}
+
+// In servo order, but the back spinner right after the front one so they go out as one
+static GripStage ordered(GripStage stage)
+{
+    auto rank = [](int servo) { return servo == BACK_SPINNER ? 2 * FRONT_SPINNER + 1 : 2 * servo; };
+    std::sort(stage.begin(), stage.end(),
+              [&](const GripCommand& a, const GripCommand& b) { return rank(a.servo) < rank(b.servo); });
+    return stage;
+}
+
+std::vector<std::string> gripStagesTemplate(const GripScript& script, GripTemplate kind, bool closeLast)
+{
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < script.size(); i++)
+    {
+        std::string part;
+        for (const GripCommand& c : ordered(script[i]))
+        {
+            part += commandText(c, kind);
+            if (c.servo % 2 == 0 && c.state == STATE_C)
+                part += commandText(c, kind);   // Twice, true center
+        }
+        if (closeLast || i + 1 < script.size())
+            part += '|';
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+// A unit of a _deps template: a command, or front and back spinners going out together
+struct DepsUnit
+{
+    GripStage commands;
+    size_t stage;
+    std::vector<int> deps;      // Units, -1 - servo for the command that servo got before the template
+};
+
+static std::vector<std::string> depsParts(const std::vector<DepsUnit>& units, size_t stages, GripTemplate kind)
+{
+    // @ means the latest command of a servo so far. If the servo got another one since, it's that one
+    int latest[MOVE_SERVOS];
+    std::fill(latest, latest + MOVE_SERVOS, (int)STATE_C);
+    std::vector<std::string> parts(stages);
+    for (const DepsUnit& unit : units)
+    {
+        std::vector<int> servos;
+        for (int d : unit.deps)
+        {
+            if (d < 0)
+                servos.push_back(-1 - d);
+            for (size_t k = 0; d >= 0 && k < units[d].commands.size(); k++)
+                servos.push_back(units[d].commands[k].servo);
+        }
+        std::sort(servos.begin(), servos.end());
+        servos.erase(std::unique(servos.begin(), servos.end()), servos.end());
+        std::string waits;
+        for (int s : servos)
+            waits += "@" + commandText({s, latest[s]}, kind);
+        int count = (int)servos.size();
+
+        std::string& part = parts[unit.stage];
+        if (count > MAX_DEPS)
+        {
+            part += 'W';
+            waits.clear();
+        }
+        for (const GripCommand& c : unit.commands)
+        {
+            part += commandText(c, kind) + waits;
+            if (c.servo % 2 == 0 && c.state == STATE_C)
+                part += commandText(c, kind);
+            latest[c.servo] = c.state;
+        }
+    }
+    if (kind == GRIP_TURN)
+        parts.push_back("W");
+    return parts;
+}
+
+static std::string joined(const std::vector<std::string>& parts)
+{
+    std::string out;
+    for (const std::string& part : parts)
+        out += part;
+    return out;
+}
+
+std::vector<std::string> gripDepsTemplate(const GripScript& script, GripTemplate kind,
+                                          const std::function<double(const std::string&)>& cost)
+{
+    std::vector<DepsUnit> units;
+    std::vector<std::vector<int>> candidates;
+    std::vector<int> lastStage;
+    for (size_t i = 0; i < script.size(); i++)
+    {
+        GripStage stage = ordered(script[i]);
+        std::vector<int> thisStage;
+        for (size_t k = 0; k < stage.size(); k++)
+        {
+            DepsUnit unit;
+            unit.stage = i;
+            unit.commands.push_back(stage[k]);
+            if (stage[k].servo == FRONT_SPINNER && k + 1 < stage.size() && stage[k + 1].servo == BACK_SPINNER)
+                unit.commands.push_back(stage[++k]);
+
+            // What it may wait for: the stage before, or what a turn's own servos did before it
+            std::vector<int> may = lastStage;
+            if (i == 0 && kind == GRIP_TURN)
+                may = {-1 - RIGHT_SPINNER, -1 - RIGHT_SLIDER};
+            unit.deps = may;
+            candidates.push_back(may);
+            thisStage.push_back((int)units.size());
+            units.push_back(unit);
+        }
+        lastStage = thisStage;
+    }
+
+    // Waiting for everything is as safe as stages get, from there each command in turn picks the fewest
+    // dependencies that make it fastest
+    double best = cost(joined(depsParts(units, script.size(), kind)));
+    if (best < 0)
+        return {};
+    for (size_t u = 0; u < units.size(); u++)
+    {
+        const std::vector<int>& may = candidates[u];
+        auto width = [&](int d) { return d < 0 ? 1 : (int)units[d].commands.size(); };
+        auto tryDeps = [&](const std::vector<int>& deps)
+        {
+            std::vector<int> before = units[u].deps;
+            units[u].deps = deps;
+            double c = cost(joined(depsParts(units, script.size(), kind)));
+            bool better = c >= 0 && (c < best - 1e-6 || (c <= best + 1e-6 && deps.size() < before.size()));
+            if (better)
+                best = c;
+            else
+                units[u].deps = before;
+        };
+        tryDeps({});
+        for (size_t a = 0; a < may.size(); a++)
+        {
+            if (width(may[a]) <= MAX_DEPS)
+                tryDeps({may[a]});
+        }
+        for (size_t a = 0; a < may.size(); a++)
+        {
+            for (size_t b = a + 1; b < may.size(); b++)
+            {
+                if (width(may[a]) + width(may[b]) <= MAX_DEPS)
+                    tryDeps({may[a], may[b]});
+            }
+        }
+    }
+    return depsParts(units, script.size(), kind);
+}
+
+// ---- Comments ----
+
+static std::string listed(const std::vector<std::string>& names)
+{
+    std::string out;
+    for (size_t i = 0; i < names.size(); i++)
+        out += (i == 0 ? "" : i + 1 == names.size() ? " and " : ", ") + names[i];
+    return out;
+}
+
+std::string gripDescribe(const GripStage& stage, GripTemplate kind)
+{
+    static const char* sliders[] = {"RIGHT", "LEFT", "FRONT", "BACK"};
+    static const char* spinners[] = {"right", "left", "front", "back"};
+
+    // Group the servos that do the same
+    std::vector<std::pair<std::string, std::vector<std::string>>> groups;
+    for (const GripCommand& c : ordered(stage))
+    {
+        std::string what;
+        if (c.servo % 2 == 1)
+        {
+            static const char* slides[] = {"go back", "grab", "release", "release halfway", "grab halfway"};
+            what = slides[c.state];
+        }
+        else if (c.state == STATE_C)
+            what = "spin to true center";
+        else
+            what = std::string("turn ") + commandText(c, kind)[1];
+        std::string name = kind == GRIP_TURN ? (c.servo % 2 ? "slider" : "spinner")
+                                             : (c.servo % 2 ? sliders[c.servo / 2] : spinners[c.servo / 2]);
+        auto it = std::find_if(groups.begin(), groups.end(), [&](const auto& g) { return g.first == what; });
+        if (it == groups.end())
+            groups.push_back({what, {name}});
+        else
+            it->second.push_back(name);
+    }
+
+    std::string out;
+    for (const auto& group : groups)
+    {
+        std::string verb = group.first;
+        if (group.second.size() == 1)
+        {
+            size_t space = std::min(verb.find(' '), verb.size());
+            verb.insert(space, verb.compare(0, space, "go") == 0 ? "es" : "s");
+        }
+        out += (out.empty() ? "" : ", ") + listed(group.second) + " " + verb;
+    }
+    if (!out.empty())
+        out[0] = (char)std::toupper((unsigned char)out[0]);
+    return out;
+}
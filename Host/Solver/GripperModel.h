@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../../Arduino/MoveCore.h"
+
+// A model of the four grippers and the cube held between them. It tells whether servo commands (the templates
+// of Arduino/MoveCore.h, expanded) are safe, and searches for other ones (see Tools/TemplateSearch.cpp).
+//
+// Each gripper is a spinner and a slider, servo 2g and 2g + 1 in ServoType order (right, left, front, back,
+// g ^ 1 is the one across). A slider at R is clear of the cube, at C it touches it and at L it presses into it.
+// The cube stays put as long as it is held: both grippers across from each other press, or both touch and one
+// of the other two at least touches too. A spinner turning while its slider is clear only turns the gripper,
+// while it touches or presses it turns that face, and the cube has to be held without it meanwhile. Front and
+// back turning the same way together, both pressing while right and left are clear, turn the whole cube over.
+// A gripper only fits the cube square on, so spinners only go to C, R and L. Anything else isn't safe.
+//
+// Commands are taken to happen one at a time. A script is safe if every order its dependencies allow works
+// and ends with the same cube.
+
+struct GripWorld
+{
+    int8_t pos[MOVE_SERVOS];    // ServoState of every servo
+    int8_t body;                // Quarter turns of the whole cube around the front-back axis, 0 to 3
+    int8_t faces[6];            // Quarter turns of every face (URFDLB), 0 to 3
+
+    GripWorld();                // Everything at C, nothing turned
+    uint64_t key() const;
+    bool operator==(const GripWorld& other) const { return key() == other.key(); }
+};
+
+struct GripModel
+{
+    bool partial = false;       // Sliders may stop halfway: r is clear of the cube, l presses like L
+    bool faceTurns = true;      // A spinner may turn a face
+    bool flips = true;          // Front and back may turn the whole cube over
+
+    // How a slider state holds the cube: 0 clear, 1 touching, 2 pressing, -1 not a state it goes to
+    int grip(int state) const;
+    bool held(const GripWorld& world, int without = -1) const;
+
+    // One thing happening: a servo going to a state, or (count 2) the front and back spinners together.
+    // False if it isn't safe, world is left anywhere then
+    bool apply(GripWorld& world, int count, const int* servos, const int* states) const;
+};
+
+// Plays SEQ commands (W, | and delays wait for everything before them) through the model in every order the
+// dependencies leave open, from everything at C. True if all are safe and end the same, end is where.
+// Otherwise why says what went wrong
+bool gripVerify(const GripModel& model, const std::string& seq, GripWorld& end, std::string& why);
+
+// The same one command after the other, what the string means without the concurrency
+bool gripPlay(const GripModel& model, const std::string& seq, GripWorld& end, std::string& why);
+
+struct GripCommand
+{
+    int servo;      // ServoType
+    int state;      // ServoState
+};
+using GripStage = std::vector<GripCommand>;     // Commands that go out together
+using GripScript = std::vector<GripStage>;
+
+// The scripts with the fewest stages from everything at C to goal, only moving the given servos, every stage
+// safe in any order. At most limit of them, explored says how many positions it looked at
+std::vector<GripScript> gripSearch(const GripModel& model, const GripWorld& goal, const std::vector<int>& servos,
+                                   size_t limit, size_t& explored);
+
+// A face turn (the face on the right gripper, s S d e in MoveCore.h) or a flip (x y)
+enum GripTemplate { GRIP_TURN, GRIP_FLIP };
+
+// A script as a template with a stage per delay, a part per stage. Without closeLast, the last stage goes with
+// what comes after it
+std::vector<std::string> gripStagesTemplate(const GripScript& script, GripTemplate kind, bool closeLast);
+
+// A script as a _deps template, a part per stage (and the W at the end of a turn): every command waits for at
+// most two commands of the stage before, or W for everything, whichever cost() likes best. cost() gets the
+// whole template and says how long it takes, negative if it isn't safe. Empty if even W everywhere isn't
+std::vector<std::string> gripDepsTemplate(const GripScript& script, GripTemplate kind,
+                                          const std::function<double(const std::string&)>& cost);
+
+// What a stage does, in words, for the comments of the template table
+std::string gripDescribe(const GripStage& stage, GripTemplate kind);
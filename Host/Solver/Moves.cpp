@@ -0,0 +1,88 @@
+#include "Moves.h"
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+static const char faceChars[] = "URFDLB";
+
+bool parseMoves(const std::string& text, std::vector<int>& moves)
+{
+    moves.clear();
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token)
+    {
+        const char* face = std::strchr(faceChars, token[0]);
+        if (!face || *face == '\0' || token.size() > 2)
+            return false;
+        int power = 0;
+        if (token.size() == 1)
+            power = 0;
+        else if (token[1] == '2')
+            power = 1;
+        else if (token[1] == '\'')
+            power = 2;
+        else
+            return false;
+        moves.push_back(3 * (face - faceChars) + power);
+    }
+    return true;
+}
+
+std::string movesToString(const std::vector<int>& moves)
+{
+    static const char* powers[] = {"", "2", "'"};
+    std::string s;
+    for (int m : moves)
+    {
+        if (!s.empty())
+            s += ' ';
+        s += faceChars[m / 3];
+        s += powers[m % 3];
+    }
+    return s;
+}
+
+std::string movesToRobot(const std::vector<int>& moves)
+{
+    std::string s;
+    for (int m : moves)
+    {
+        char c = faceChars[m / 3];
+        switch (m % 3)
+        {
+        case 0: s += c; break;
+        case 1: s += c; s += c; break;
+        case 2: s += (char)(c - 'A' + 'a'); break;
+        }
+    }
+    return s;
+}
+
+int robotQuarterTurns(const std::vector<int>& moves)
+{
+    int n = 0;
+    for (int m : moves)
+        n += m % 3 == 1 ? 2 : 1;
+    return n;
+}
+
+bool parseRobotMoves(const std::string& text, std::vector<int>& moves)
+{
+    moves.clear();
+    size_t i = 0;
+    while (i < text.size())
+    {
+        char upper = (char)std::toupper((unsigned char)text[i]);
+        const char* face = std::strchr(faceChars, upper);
+        if (!face || *face == '\0')
+            return false;
+        // Quarter turns of this face in a row, counter-clockwise ones count as three
+        int turns = 0;
+        for (; i < text.size() && std::toupper((unsigned char)text[i]) == upper; i++)
+            turns += text[i] == upper ? 1 : 3;
+        if (turns % 4)
+            moves.push_back(3 * (face - faceChars) + turns % 4 - 1);
+    }
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Conversions between move numbers (3 * face + quarter turns - 1, see CubieCube.h) and text
+
+// "U R2 F'" style. Returns false on anything it doesn't understand
+bool parseMoves(const std::string& text, std::vector<int>& moves);
+std::string movesToString(const std::vector<int>& moves);
+
+// What the MOVE command of the robot takes: one character per quarter turn, lowercase counter-clockwise.
+// U2 becomes "UU", U' becomes "u" (same as parseCubeNotation() in the app)
+std::string movesToRobot(const std::vector<int>& moves);
+int robotQuarterTurns(const std::vector<int>& moves);
+// The other way around, runs of the same letter add up ("UU" is U2, "UUU" is U'). False on anything else
+bool parseRobotMoves(const std::string& text, std::vector<int>& moves);
@@ -0,0 +1,156 @@
+#include "MultiSearch.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "RobotCost.h"
+
+// 120 degree rotation of the whole cube around the URF-DBL diagonal (Kociemba's S_URF3), U -> R -> F -> U
+static CubieCube rotationURF()
+{
+    static const uint8_t cp[N_CORNERS] = {URF, DFR, DLF, UFL, UBR, DRB, DBL, ULB};
+    static const uint8_t co[N_CORNERS] = {1, 2, 1, 2, 2, 1, 2, 1};
+    static const uint8_t ep[N_EDGES] = {UF, FR, DF, FL, UB, BR, DB, BL, UR, DR, DL, UL};
+    static const uint8_t eo[N_EDGES] = {1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1, 1};
+    CubieCube s;
+    std::memcpy(s.cp, cp, N_CORNERS);
+    std::memcpy(s.co, co, N_CORNERS);
+    std::memcpy(s.ep, ep, N_EDGES);
+    std::memcpy(s.eo, eo, N_EDGES);
+    return s;
+}
+
+struct Rotation
+{
+    CubieCube cube;             // R
+    CubieCube inverse;
+    int toOriginal[N_MOVES];    // R^-1 * m * R, what a move on the rotated cube is on the original one
+    int toRotated[N_MOVES];
+};
+
+static const Rotation* rotations()
+{
+    static Rotation rot[3];
+    static std::once_flag once;
+    std::call_once(once, []()
+    {
+        CubieCube s = rotationURF();
+        for (int k = 0; k < 3; k++)
+        {
+            rot[k].inverse = rot[k].cube.inverse();
+            // Just see which move it turns into, rather than working it out by hand
+            for (int m = 0; m < N_MOVES; m++)
+            {
+                CubieCube c = rot[k].inverse;
+                CubieCube move;
+                move.move(m);
+                c.multiply(move);
+                c.multiply(rot[k].cube);
+                for (int j = 0; j < N_MOVES; j++)
+                {
+                    CubieCube other;
+                    other.move(j);
+                    if (other == c)
+                    {
+                        rot[k].toOriginal[m] = j;
+                        rot[k].toRotated[j] = m;
+                    }
+                }
+            }
+            if (k < 2)
+            {
+                rot[k + 1].cube = rot[k].cube;
+                rot[k + 1].cube.multiply(s);
+            }
+        }
+    });
+    return rot;
+}
+
+bool MultiSearch::solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution)
+{
+    const Rotation* rot = rotations();
+    getTables();    // Build them once here instead of every thread waiting on it
+
+    std::atomic<int> sharedBound{options.maxLength + 1};
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    std::vector<int> best;
+    int bestStages = 0;
+    bool found = false;
+
+    std::vector<std::thread> threads;
+    std::atomic<int> running{0};
+    int count = variants < 1 ? 1 : variants > N_VARIANTS ? N_VARIANTS : variants;
+    for (int v = 0; v < count; v++)
+    {
+        int k = v / 2;
+        bool inverted = v % 2 == 1;
+        // The move done before only means something at the start of a solution, an inverted one ends there
+        if (inverted && options.afterMove >= 0)
+            continue;
+
+        // R * cube * R^-1, and maybe inverted
+        CubieCube variant = rot[k].cube;
+        variant.multiply(cube);
+        variant.multiply(rot[k].inverse);
+        if (inverted)
+            variant = variant.inverse();
+
+        running++;
+        threads.emplace_back([&, k, inverted, variant]()
+        {
+            SearchOptions opt = options;
+            opt.stop = &stop;
+            opt.sharedBound = &sharedBound;
+            if (options.afterMove >= 0)
+                opt.afterMove = rot[k].toRotated[options.afterMove];
+            opt.onSolution = [&](const std::vector<int>& found1)
+            {
+                // Undo the inversion (reverse it and turn every move the other way), then the rotation
+                std::vector<int> mapped(found1.size());
+                for (size_t i = 0; i < found1.size(); i++)
+                {
+                    int m = inverted ? found1[found1.size() - 1 - i] : found1[i];
+                    if (inverted)
+                        m = 3 * (m / 3) + 2 - m % 3;
+                    mapped[i] = rot[k].toOriginal[m];
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                int endOrientation = orientation;
+                int stages = robotStages(mapped, endOrientation);
+                if (found && (mapped.size() > best.size() || (mapped.size() == best.size() && stages >= bestStages)))
+                    return;
+                best = mapped;
+                bestStages = stages;
+                found = true;
+                if (options.onSolution)
+                    options.onSolution(best);
+                if ((int)best.size() <= options.targetLength)
+                    stop = true;
+            };
+
+            Search search;
+            std::vector<int> unused;
+            search.solve(variant, opt, unused);
+            running--;
+        });
+    }
+
+    // The others keep going until they run out of time or tried everything, pass on a stop from outside
+    while (running > 0)
+    {
+        if (options.stop && options.stop->load())
+            stop = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    for (std::thread& t : threads)
+        t.join();
+
+    if (!found)
+        return false;
+    solution = best;
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include "CubieCube.h"
+#include "Search.h"
+
+#define N_VARIANTS 6    // 3 rotations around the URF-DBL diagonal, each as is and inverted
+
+// Runs the two-phase search on several versions of the same cube at once, one thread each.
+//
+// Rotating the whole cube (so the U, R and F axes swap roles) or inverting it doesn't change how many moves
+// it takes, but it does change which phase 1 the search stumbles on first, so one of the variants usually finds
+// a short solution a lot sooner than the cube itself would. All threads share the best length found so far,
+// so each only looks for solutions shorter than the best of all of them. Solutions are mapped back to the
+// original cube before they are reported. If two threads come up with equally short ones, the one the robot
+// does faster wins (see RobotCost.h).
+class MultiSearch
+{
+public:
+    int variants = N_VARIANTS;  // How many of the variants to run, 1 is the same as a plain Search
+    int orientation = 0;        // MOVE orientation the cube starts in, for picking the fastest solution
+
+    // Same as Search::solve(). options.onSolution gets the mapped solutions, and is never called from two threads at once
+    bool solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution);
+};
@@ -0,0 +1,166 @@
+#include "OptimalSearch.h"
+#include <algorithm>
+#include <mutex>
+#include "MultiSearch.h"
+#include "RobotCost.h"
+
+// Where each move takes the edge at each position, and whether it flips it
+static uint8_t edgeTo[N_MOVES][N_EDGES];
+static uint8_t edgeFlip[N_MOVES][N_EDGES];
+
+OptimalSearch::OptimalSearch()
+    : tables(getTables()), pdb(getOptimalTables())
+{
+    static std::once_flag once;
+    std::call_once(once, []()
+    {
+        for (int m = 0; m < N_MOVES; m++)
+        {
+            CubieCube c;
+            for (int p = 0; p <= m % 3; p++)
+                c.multiply(CubieCube::basicMove(m / 3));
+            for (int i = 0; i < N_EDGES; i++)
+            {
+                edgeTo[m][c.ep[i]] = i;
+                edgeFlip[m][c.ep[i]] = c.eo[i];
+            }
+        }
+    });
+}
+
+bool OptimalSearch::outOfTime()
+{
+    if (interrupted)
+        return true;
+    if ((++nodeCount & 0xFFF) == 0)
+    {
+        if ((opt->stop && opt->stop->load()) || std::chrono::steady_clock::now() > deadline)
+            interrupted = true;
+    }
+    return interrupted;
+}
+
+bool OptimalSearch::solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution)
+{
+    opt = &options;
+    started = std::chrono::steady_clock::now();
+    deadline = started + std::chrono::milliseconds(options.timeoutMs);
+    interrupted = false;
+    nodeCount = 0;
+    best.clear();
+    ruledOut = 0;
+    if (cube.isSolved())
+    {
+        solution.clear();
+        return true;
+    }
+
+    uint8_t pos[N_EDGES], ori[N_EDGES];
+    for (int i = 0; i < N_EDGES; i++)
+    {
+        pos[cube.ep[i]] = i;
+        ori[cube.ep[i]] = cube.eo[i];
+    }
+    int maxLength = std::min(options.maxLength, 30);
+    for (int depth = 0; depth <= maxLength; depth++)
+    {
+        search(cube.getCorners(), cube.getTwist(), pos, ori, depth, 0);
+        if (!best.empty() || interrupted)
+            break;
+        ruledOut = depth + 1;
+    }
+    if (best.empty())
+        return false;
+    solution = best;
+    return true;
+}
+
+// Returns true when the whole search should stop
+bool OptimalSearch::search(int corners, int twist, const uint8_t* pos, const uint8_t* ori, int togo, int n)
+{
+    if (outOfTime())
+        return true;
+
+    // Cheapest lookup first, most nodes are cut by one of them
+    int h = pdb.cornerDistance(corners * N_TWIST + twist);
+    if (h > togo)
+        return false;
+    h = std::max(h, pdb.edgeDistance(0, edge6Index(pos, ori, 0)));
+    if (h > togo)
+        return false;
+    h = std::max(h, pdb.edgeDistance(1, edge6Index(pos, ori, 1)));
+    if (h > togo)
+        return false;
+    if (h == 0)
+    {
+        // All three patterns solved is the whole cube solved, and togo is 0 since every shorter length failed
+        std::vector<int> found(moves, moves + n);
+        int orient = orientation;
+        int stages = robotStages(found, orient);
+        if (best.empty())
+        {
+            // Looking for a faster one gets as long again as finding this one took, at most
+            auto now = std::chrono::steady_clock::now();
+            deadline = std::min(deadline, now + (now - started));
+        }
+        if (best.empty() || stages < bestStages)
+        {
+            best = found;
+            bestStages = stages;
+        }
+        return false;   // Keep looking for one the robot does faster, at the same length
+    }
+
+    for (int m = 0; m < N_MOVES; m++)
+    {
+        int last = n > 0 ? moves[n - 1] : opt->afterMove;
+        if (last >= 0 && (m / 3 == last / 3 || m / 3 == last / 3 - 3))
+        {
+            m += 2;     // Same face twice, or opposite faces in the wrong order
+            continue;
+        }
+        uint8_t newPos[N_EDGES], newOri[N_EDGES];
+        for (int e = 0; e < N_EDGES; e++)
+        {
+            newPos[e] = edgeTo[m][pos[e]];
+            newOri[e] = ori[e] ^ edgeFlip[m][pos[e]];
+        }
+        moves[n] = m;
+        if (search(tables.cornersMove[corners][m], tables.twistMove[twist][m], newPos, newOri, togo - 1, n + 1))
+            return true;
+    }
+    return false;
+}
+
+bool solveShortest(const CubieCube& cube, const SearchOptions& options, int variants, int orientation,
+                   long optimalMs, std::vector<int>& solution, bool& optimal)
+{
+    optimal = false;
+    MultiSearch twoPhase;
+    twoPhase.variants = variants;
+    twoPhase.orientation = orientation;
+    std::vector<int> found;
+    bool ok = twoPhase.solve(cube, options, found);
+    if (ok)
+        solution = found;
+    if (optimalMs <= 0)
+        return ok;
+
+    // Only something shorter than the two-phase solution is worth the time
+    OptimalSearch search;
+    search.orientation = orientation;
+    SearchOptions opt = options;
+    opt.timeoutMs = optimalMs;
+    if (ok)
+        opt.maxLength = (int)found.size() - 1;
+    if (search.solve(cube, opt, found))
+    {
+        if (options.onSolution)
+            options.onSolution(found);
+        solution = found;
+        optimal = true;
+        return true;
+    }
+    optimal = ok && search.lowerBound() > opt.maxLength;
+    return ok;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include "CubieCube.h"
+#include "OptimalTables.h"
+#include "Search.h"
+#include "Tables.h"
+
+// Optimal solver: iterative deepening A* (Korf) with the pattern databases in OptimalTables.h.
+// It tries every length from the lower bound up, so the first solution it finds is as short as it gets. That can
+// take anything from milliseconds (up to 15 moves or so) to hours (most random cubes need 18), so it always runs
+// on a time budget, see solveShortest().
+class OptimalSearch
+{
+public:
+    OptimalSearch();
+
+    int orientation = 0;    // MOVE orientation the cube starts in. Of the shortest solutions, the one the robot
+                            // does fastest wins (it looks for more of them as long as finding the first took)
+
+    // Like Search::solve(): true if a solution of at most options.maxLength moves was found.
+    // Uses maxLength, timeoutMs, afterMove and stop
+    bool solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution);
+
+    // Every length below this is known not to work. If it is more than options.maxLength, there is no shorter
+    // solution than the one you had
+    int lowerBound() const { return ruledOut; }
+    bool wasInterrupted() const { return interrupted; }
+    long nodes() const { return nodeCount; }
+
+private:
+    const Tables& tables;
+    const OptimalTables& pdb;
+    const SearchOptions* opt = nullptr;
+    std::chrono::steady_clock::time_point started, deadline;
+    bool interrupted = false;
+    long nodeCount = 0;
+    int ruledOut = 0;
+
+    int moves[32];
+    std::vector<int> best;
+    int bestStages = 0;
+
+    bool outOfTime();
+    bool search(int corners, int twist, const uint8_t* pos, const uint8_t* ori, int togo, int n);
+};
+
+// Two-phase search first (options, with variants threads like MultiSearch), then the optimal search for up to
+// optimalMs more to find something shorter. optimal says whether the result is known to be the shortest.
+// Falls back to the two-phase solution when the optimal search runs out of time
+bool solveShortest(const CubieCube& cube, const SearchOptions& options, int variants, int orientation,
+                   long optimalMs, std::vector<int>& solution, bool& optimal);
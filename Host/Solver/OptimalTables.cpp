@@ -0,0 +1,218 @@
+#include "OptimalTables.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+#include "TableFile.h"
+#include "Tables.h"
+
+int edge6Index(const uint8_t* pos, const uint8_t* ori, int group)
+{
+    // Mixed radix 12 * 11 * ... * 7: each position counted among the ones the edges before it left free
+    int index = 0, flips = 0;
+    for (int k = 0; k < 6; k++)
+    {
+        int e = 6 * group + k;
+        int rank = pos[e];
+        for (int j = 0; j < k; j++)
+        {
+            if (pos[6 * group + j] < pos[e])
+                rank--;
+        }
+        index = index * (N_EDGES - k) + rank;
+        flips = flips << 1 | ori[e];
+    }
+    return index * 64 + flips;
+}
+
+static void edge6Positions(int index, uint8_t* pos)
+{
+    int ranks[6];
+    for (int k = 5; k >= 0; k--)
+    {
+        ranks[k] = index % (N_EDGES - k);
+        index /= N_EDGES - k;
+    }
+    bool used[N_EDGES] = {};
+    for (int k = 0; k < 6; k++)
+    {
+        int p = 0;
+        for (int free = ranks[k]; used[p] || free > 0; p++)
+        {
+            if (!used[p])
+                free--;
+        }
+        pos[k] = p;
+        used[p] = true;
+    }
+}
+
+static int distance(const uint8_t* table, long i)
+{
+    return (table[i >> 1] >> ((i & 1) * 4)) & 15;
+}
+
+static void setDistance(uint8_t* table, long i, int d)
+{
+    int shift = (i & 1) * 4;
+    table[i >> 1] = (table[i >> 1] & ~(15 << shift)) | d << shift;
+}
+
+// Breadth first search from the solved state, 15 means not reached yet. Once most states are done, it is
+// quicker to go over the ones that are left and look for a neighbour in the last layer than the other way around
+template <typename Next>
+static void buildPattern(uint8_t* table, long states, long solved, Next next)
+{
+    std::memset(table, 0xff, (states + 1) / 2);
+    setDistance(table, solved, 0);
+    long done = 1;
+    for (int depth = 0; done < states && depth < 14; depth++)
+    {
+        bool backwards = done > states / 2;
+        for (long i = 0; i < states; i++)
+        {
+            int d = distance(table, i);
+            if (backwards)
+            {
+                if (d != 15)
+                    continue;
+                for (int m = 0; m < N_MOVES; m++)
+                {
+                    if (distance(table, next(i, m)) == depth)
+                    {
+                        setDistance(table, i, depth + 1);
+                        done++;
+                        break;
+                    }
+                }
+            }
+            else if (d == depth)
+            {
+                for (int m = 0; m < N_MOVES; m++)
+                {
+                    long j = next(i, m);
+                    if (distance(table, j) == 15)
+                    {
+                        setDistance(table, j, depth + 1);
+                        done++;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void OptimalTables::build()
+{
+    const Tables& t = getTables();
+    CubieCube solved;
+    buildPattern(corners, N_CORNER_STATES, (long)solved.getCorners() * N_TWIST + solved.getTwist(), [&](long i, int m)
+    {
+        return (long)t.cornersMove[i / N_TWIST][m] * N_TWIST + t.twistMove[i % N_TWIST][m];
+    });
+
+    // Where a move takes the edge at each position, and whether it flips it
+    uint8_t to[N_MOVES][N_EDGES], flip[N_MOVES][N_EDGES];
+    for (int m = 0; m < N_MOVES; m++)
+    {
+        CubieCube c;
+        for (int p = 0; p <= m % 3; p++)
+            c.multiply(CubieCube::basicMove(m / 3));
+        for (int i = 0; i < N_EDGES; i++)
+        {
+            to[m][c.ep[i]] = i;
+            flip[m][c.ep[i]] = c.eo[i];
+        }
+    }
+
+    // Move table for the positions of 6 edges, with the orientation changes in the top bits. Both groups use it,
+    // only the solved state is different
+    std::vector<uint32_t> positionMove((size_t)N_EDGE6_POSITIONS * N_MOVES);
+    for (int i = 0; i < N_EDGE6_POSITIONS; i++)
+    {
+        uint8_t pos[6], moved[6], ori[6] = {};
+        edge6Positions(i, pos);
+        for (int m = 0; m < N_MOVES; m++)
+        {
+            uint32_t flips = 0;
+            for (int k = 0; k < 6; k++)
+            {
+                moved[k] = to[m][pos[k]];
+                flips = flips << 1 | flip[m][pos[k]];
+            }
+            positionMove[(size_t)i * N_MOVES + m] = (edge6Index(moved, ori, 0) / 64) | flips << 20;
+        }
+    }
+    for (int group = 0; group < 2; group++)
+    {
+        uint8_t pos[N_EDGES], ori[N_EDGES] = {};
+        for (int e = 0; e < N_EDGES; e++)
+            pos[e] = e;
+        buildPattern(edges[group], N_EDGE6_STATES, edge6Index(pos, ori, group), [&](long i, int m)
+        {
+            uint32_t moved = positionMove[(size_t)(i / 64) * N_MOVES + m];
+            return (long)(moved & 0xfffff) * 64 + ((i % 64) ^ (moved >> 20));
+        });
+    }
+}
+
+static std::mutex optimalMutex;
+static const OptimalTables* optimal = nullptr;
+static std::string source;
+
+static const OptimalTables* mapOptimal(const std::string& path, std::string& error)
+{
+    return static_cast<const OptimalTables*>(mapTableData(path, sizeof(OptimalTables), OPTIMAL_FILE_MAGIC,
+                                                          OPTIMAL_FILE_VERSION, false, error));
+}
+
+bool useOptimalTableFile(const std::string& path, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(optimalMutex);
+    if (optimal)
+    {
+        error = "optimal tables are already in use";
+        return false;
+    }
+    optimal = mapOptimal(path, error);
+    if (optimal)
+        source = path;
+    return optimal != nullptr;
+}
+
+const OptimalTables& getOptimalTables()
+{
+    std::lock_guard<std::mutex> lock(optimalMutex);
+    if (!optimal)
+    {
+        // No checksum here, reading 87MB would eat a good part of the time budget. maketables -c checks it
+        const char* env = std::getenv("CUBE_OPTIMAL_TABLES");
+        std::string path = env ? env : "cubeoptimal.bin";
+        std::string error;
+        optimal = mapOptimal(path, error);
+        if (optimal)
+        {
+            source = path;
+        }
+        else
+        {
+            if (env || access(path.c_str(), F_OK) == 0)
+                std::fprintf(stderr, "Not using optimal table file: %s\n", error.c_str());
+            std::fprintf(stderr, "Building the optimal solver tables, this takes a while (maketables -o saves them)\n");
+            OptimalTables* built = new OptimalTables;
+            built->build();
+            optimal = built;
+            source = "built in memory";
+        }
+    }
+    return *optimal;
+}
+
+const char* optimalTablesSource()
+{
+    std::lock_guard<std::mutex> lock(optimalMutex);
+    return source.c_str();
+}
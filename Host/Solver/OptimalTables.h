@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "CubieCube.h"
+
+// Pattern databases for the optimal solver (Korf, "Finding optimal solutions to Rubik's Cube using pattern
+// databases", 1997): the exact number of moves it takes to solve just the corners, just the first 6 edges
+// (UR..DF), and just the last 6 (DL..BR). The most of the three is a lower bound for the whole cube.
+// Distances are 4 bits each, two to a byte, about 87MB in all. Building them takes a minute or so, so they
+// live in their own table file (cubeoptimal.bin, see maketables -o).
+
+#define N_CORNER_STATES (N_CORNERS_PERM * N_TWIST)     // 88179840
+#define N_EDGE6_POSITIONS 665280                        // 12 * 11 * 10 * 9 * 8 * 7 ordered positions of 6 edges
+#define N_EDGE6_STATES (N_EDGE6_POSITIONS * 64)         // Times 2^6 orientations, 42577920
+
+#define OPTIMAL_FILE_MAGIC "CUBEPDB"
+#define OPTIMAL_FILE_VERSION 1
+
+struct OptimalTables
+{
+    uint8_t corners[N_CORNER_STATES / 2];       // cornerPerm * N_TWIST + twist
+    uint8_t edges[2][N_EDGE6_STATES / 2];       // edge6Index() of edges 0..5 and 6..11
+
+    int cornerDistance(int index) const { return (corners[index >> 1] >> ((index & 1) * 4)) & 15; }
+    int edgeDistance(int group, int index) const { return (edges[group][index >> 1] >> ((index & 1) * 4)) & 15; }
+
+    void build();
+};
+
+// Where edges 6 * group .. 6 * group + 5 are (pos[edge]) and how they are flipped (ori[edge]), as one number
+int edge6Index(const uint8_t* pos, const uint8_t* ori, int group);
+
+// Maps the file from $CUBE_OPTIMAL_TABLES or cubeoptimal.bin, and if there is no valid one, builds the tables in
+// memory (slow, with a word on stderr). Thread safe, the first call does the work
+const OptimalTables& getOptimalTables();
+bool useOptimalTableFile(const std::string& path, std::string& error);
+const char* optimalTablesSource();
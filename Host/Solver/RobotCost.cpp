@@ -0,0 +1,25 @@
+#include "RobotCost.h"
+
+int robotStages(const std::vector<int>& moves, int& orientation)
+{
+    int stages = 0;
+    for (int m : moves)
+    {
+        int needed = moveNeedsOrientation("URFDLB"[m / 3]);     // Move numbers go by face like CubieCube.h
+        if (needed >= 0 && needed != orientation)
+        {
+            stages += ROBOT_STAGES_PER_FLIP;
+            orientation = needed;
+        }
+        stages += ROBOT_STAGES_PER_TURN * (m % 3 == 1 ? 2 : 1);
+    }
+    return stages;
+}
+
+long robotTimeMs(const std::vector<int>& moves, int orientation, int delayMs)
+{
+    if (moves.empty())
+        return 0;
+    long stageMs = delayMs > 0 ? delayMs : ROBOT_WAIT_STAGE_MS;
+    return ROBOT_START_MS + stageMs * robotStages(moves, orientation);
+}
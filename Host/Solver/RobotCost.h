@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include "../../Arduino/MoveCore.h"
+
+// How long the robot takes for a solution, counted in MOVE stages (one stage is one delay in the appendMove() /
+// appendRotateCube() templates of the firmware, see Arduino/MoveCore.h, so multiply by the MOVE delay for ms).
+// The robot can't reach U and D in the normal orientation, or R and L in the inverted one, and flipping the
+// cube costs more than a turn, so two solutions of the same length can take quite different times.
+#define ROBOT_STAGES_PER_TURN 4     // Every quarter turn, a half turn is two of them
+#define ROBOT_STAGES_PER_FLIP 6
+
+// orientation is the MOVE orientation the cube starts in (0 normal, 1 inverted), it is updated to where it ends up
+int robotStages(const std::vector<int>& moves, int& orientation);
+
+// Simulated time for the robot to play moves with MOVE <delayMs>: the stages times the delay, plus the pause
+// startMoves() takes to attach the servos. With delay 0 (W, wait for the servos) a stage takes as long as the
+// slowest servo in it, ROBOT_WAIT_STAGE_MS is a typical figure for calibrated MG996R-class servos
+#define ROBOT_START_MS MOVE_START_MS
+#define ROBOT_WAIT_STAGE_MS 250
+long robotTimeMs(const std::vector<int>& moves, int orientation, int delayMs);
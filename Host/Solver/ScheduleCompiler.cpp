@@ -0,0 +1,252 @@
+#include "ScheduleCompiler.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "RobotCost.h"
+#include "../../Arduino/MoveCore.h"
+
+static const char servoChars[] = "rRlLfFbB";    // In ServoType order
+static const char stateChars[] = "CLRrl";       // In ServoState order
+
+// One servo command of the expanded solution
+struct ScheduleNode
+{
+    int servo;
+    int state;
+    int deps[2];    // Nodes it waits to arrive for, -1 if none
+    int move;
+};
+
+static int servoIndex(char c)
+{
+    const char* p = std::strchr(servoChars, c);
+    return c && p ? (int)(p - servoChars) : -1;
+}
+
+static int stateIndex(char c)
+{
+    const char* p = std::strchr(stateChars, c);
+    return c && p ? (int)(p - stateChars) : -1;
+}
+
+// The commands of every move in order, with their dependencies pointing at the nodes they mean
+static bool expand(const std::string& moves, int orientation, std::vector<ScheduleNode>& nodes, int& endOrientation,
+                   std::string& error)
+{
+    int last[SCHEDULE_SERVOS];
+    int lastState[SCHEDULE_SERVOS];
+    for (int i = 0; i < SCHEDULE_SERVOS; i++)
+    {
+        last[i] = -1;
+        lastState[i] = STATE_C;
+    }
+
+    CubeOrientation current = (CubeOrientation)orientation;
+    for (size_t m = 0; m < moves.size(); m++)
+    {
+        // The firmware's own template, the W at the end is what this gets rid of
+        char buf[SEQUENCE_BUFFER_SIZE] = "";
+        if (!appendMoveDeps(buf, sizeof(buf), current, moves[m]))
+        {
+            error = std::string("move ") + moves[m];
+            return false;
+        }
+        std::string seq = buf;
+        if (!seq.empty() && seq.back() == 'W')
+            seq.pop_back();
+        for (size_t i = 0; i < seq.size(); )
+        {
+            ScheduleNode node;
+            node.servo = servoIndex(seq[i]);
+            node.state = stateIndex(seq[i + 1]);
+            node.deps[0] = node.deps[1] = -1;
+            node.move = (int)m;
+            i += 2;
+            for (int d = 0; d < 2 && i < seq.size() && seq[i] == '@'; d++, i += 3)
+            {
+                int dep = servoIndex(seq[i + 1]);
+                if (dep < 0 || lastState[dep] != stateIndex(seq[i + 2]))
+                {
+                    error = "template";     // Like Timeline::push(), a dependency that would never be met
+                    return false;
+                }
+                node.deps[d] = last[dep];
+            }
+            last[node.servo] = (int)nodes.size();
+            lastState[node.servo] = node.state;
+            nodes.push_back(node);
+        }
+    }
+    endOrientation = current;
+    return true;
+}
+
+static bool holds(int state)
+{
+    return state == STATE_C || state == STATE_L;
+}
+
+// Start times for every node. perMove waits for every servo between moves like W, otherwise the rules in the header
+static double place(const std::vector<ScheduleNode>& nodes, const ServoCal* cal, bool perMove, std::vector<ScheduleStep>& steps)
+{
+    int last[SCHEDULE_SERVOS];               // Latest node of each servo
+    int beforeMove[SCHEDULE_SERVOS];         // Latest node of each servo in the moves before this one
+    int state[SCHEDULE_SERVOS];
+    int from[SCHEDULE_SERVOS], to[SCHEDULE_SERVOS];   // Pulses, from is where it may still be coming from
+    double frozenUntil[SCHEDULE_SERVOS];     // A face next to this slider is turning until then
+    int lastTurn[SCHEDULE_SERVOS / 2];       // Latest face turn of each spinner
+    for (int i = 0; i < SCHEDULE_SERVOS; i++)
+    {
+        last[i] = beforeMove[i] = -1;
+        state[i] = STATE_C;
+        from[i] = to[i] = cal[i].C_us;
+        frozenUntil[i] = 0;
+    }
+    for (int i = 0; i < SCHEDULE_SERVOS / 2; i++)
+        lastTurn[i] = -1;
+
+    steps.assign(nodes.size(), ScheduleStep());
+    double barrier = ROBOT_START_MS, makespan = ROBOT_START_MS;
+    int move = -1;
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        const ScheduleNode& node = nodes[n];
+        int s = node.servo;
+        if (node.move != move)
+        {
+            move = node.move;
+            barrier = makespan;
+            std::copy(last, last + SCHEDULE_SERVOS, beforeMove);
+        }
+
+        double t = perMove ? barrier : ROBOT_START_MS;
+        if (last[s] >= 0)
+            t = std::max(t, steps[last[s]].startMs);
+        for (int dep : node.deps)
+        {
+            if (dep >= 0)
+                t = std::max(t, steps[dep].arriveMs);
+        }
+
+        int face = s / 2;       // Servo pairs: right, left, front, back
+        int side = face < 2 ? 4 : 0;    // Slider of the first neighbouring pair is side + 1, then side + 3
+        bool turn = false;
+        if (!perMove && s % 2 == 0)
+        {
+            turn = holds(state[s + 1]) && holds(state[side + 1]) && holds(state[side + 3]);
+            if (turn)
+            {
+                // Within the move the template's own dependencies say when, it turns while those are still closing in
+                // after a flip
+                for (int p : {side + 1, side + 3})
+                {
+                    if (beforeMove[p] >= 0)
+                        t = std::max(t, steps[beforeMove[p]].arriveMs);
+                }
+                for (int f = 0; f < SCHEDULE_SERVOS / 2; f++)
+                {
+                    if (f / 2 != face / 2 && lastTurn[f] >= 0)
+                        t = std::max(t, steps[lastTurn[f]].arriveMs);
+                }
+            }
+        }
+        if (!perMove && s % 2 == 1)
+        {
+            t = std::max(t, frozenUntil[s]);
+            int opposite = (face ^ 1) * 2 + 1;
+            if (last[s] == beforeMove[s] && beforeMove[opposite] >= 0)
+                t = std::max(t, steps[beforeMove[opposite]].arriveMs);
+        }
+
+        // Without a ramp MyServo counts from the target before, like the pulse jumped there. A ramped servo sent
+        // somewhere else before it got there could be anywhere in between
+        int target = servoTargetPulse(cal[s], s, state[s], node.state);
+        bool moving = cal[s].accel > 0 && last[s] >= 0 && t < steps[last[s]].arriveMs;
+        int start = moving && std::abs(target - from[s]) > std::abs(target - to[s]) ? from[s] : to[s];
+        double arrive = t + servoTravelMs(cal[s], std::abs(target - start));
+
+        ScheduleStep& step = steps[n];
+        step.servo = servoChars[s];
+        step.state = stateChars[node.state];
+        step.startMs = t;
+        step.arriveMs = arrive;
+        step.move = node.move;
+
+        if (turn)
+        {
+            lastTurn[face] = (int)n;
+            frozenUntil[side + 1] = std::max(frozenUntil[side + 1], arrive);
+            frozenUntil[side + 3] = std::max(frozenUntil[side + 3], arrive);
+        }
+        last[s] = (int)n;
+        state[s] = node.state;
+        from[s] = start;
+        to[s] = target;
+        makespan = std::max(makespan, arrive);
+    }
+    return makespan;
+}
+
+bool compileSchedule(const std::string& robotMoves, int orientation, const ServoCal* cal, Schedule& out, std::string& error)
+{
+    std::vector<ScheduleNode> nodes;
+    if (!expand(robotMoves, orientation, nodes, out.endOrientation, error))
+        return false;
+
+    std::vector<ScheduleStep> perMove;
+    out.perMoveMs = place(nodes, cal, true, perMove);
+    out.makespanMs = place(nodes, cal, false, out.steps);
+    if (out.makespanMs > out.perMoveMs)
+    {
+        out.steps = perMove;    // Shouldn't happen, the rules only ever drop waits
+        out.makespanMs = out.perMoveMs;
+    }
+    std::stable_sort(out.steps.begin(), out.steps.end(),
+                     [](const ScheduleStep& a, const ScheduleStep& b) { return a.startMs < b.startMs; });
+    return true;
+}
+
+std::vector<std::string> scheduleSequences(const Schedule& schedule, size_t maxLength)
+{
+    // Steps that start in the same microsecond go out together, with the delay since the ones before
+    std::vector<std::string> groups;
+    long long prevUs = 0;
+    for (size_t i = 0; i < schedule.steps.size(); )
+    {
+        long long us = std::llround(schedule.steps[i].startMs * 1000);
+        std::string group;
+        if (i > 0)
+        {
+            long long gap = us - prevUs;
+            char delay[32];
+            if (gap % 1000 == 0)
+                std::snprintf(delay, sizeof(delay), "%lld", gap / 1000);
+            else
+            {
+                std::snprintf(delay, sizeof(delay), "%lld.%03lld", gap / 1000, gap % 1000);
+                while (delay[std::strlen(delay) - 1] == '0')
+                    delay[std::strlen(delay) - 1] = '\0';
+            }
+            group = delay;
+        }
+        for (; i < schedule.steps.size() && std::llround(schedule.steps[i].startMs * 1000) == us; i++)
+        {
+            group += schedule.steps[i].servo;
+            group += schedule.steps[i].state;
+        }
+        groups.push_back(group);
+        prevUs = us;
+    }
+
+    std::vector<std::string> out;
+    for (const std::string& group : groups)
+    {
+        if (out.empty() || out.back().size() + group.size() > maxLength)
+            out.push_back("");
+        out.back() += group;
+    }
+    return out;
+}
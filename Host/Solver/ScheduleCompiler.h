@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../../Arduino/Config.h"
+#include "../../Arduino/Types.h"
+
+#define SCHEDULE_SERVOS 8   // NUM_SERVOS, MyServo.h needs the Arduino headers
+
+// Turns a whole solution into one timed servo program, instead of the robot expanding it a move at a time.
+//
+// The moves are expanded with the firmware's own templates for MOVE 0 (appendMoveDeps() in Arduino/MoveCore.h),
+// whose @ dependencies already say what each servo waits for within a move (grip before turn, release before
+// recenter). Between two moves MOVE 0 waits until every servo arrived (W). Here a command only waits for what
+// it needs, which can be in any move before it:
+//   - a face turns once its own slider and both neighbouring sliders hold the cube (for sliders moved in the
+//     same move, the template's own dependencies decide), and the turn before it is done, unless that was the
+//     opposite face (they don't share any pieces)
+//   - while a face turns, the neighbouring sliders stay where they are
+//   - a slider only lets go of the cube or squeezes it once the opposite slider holds it again
+// Each command then starts as early as that allows (list scheduling in the order of the solution, the turns
+// can't go in any other order anyway). With only precedences to respect, that is the shortest possible program.
+// How long a servo takes comes from its calibration, worked out like MyServo does.
+//
+// The program plays back as a plain SEQ with delays, see scheduleSequences().
+
+struct ScheduleStep
+{
+    char servo;         // As in SEQ, "rRlLfFbB"
+    char state;         // "CLRrl"
+    double startMs;     // From the SEQ command, the first steps come after the ROBOT_START_MS attach pause
+    double arriveMs;    // There and settled
+    int move;           // Which move of the solution it is for
+};
+
+struct Schedule
+{
+    std::vector<ScheduleStep> steps;    // In the order they start
+    double makespanMs = 0;              // Until the last servo arrived
+    double perMoveMs = 0;               // The same moves one at a time like MOVE 0, for comparison
+    int endOrientation = 0;
+};
+
+// robotMoves as MOVE takes them ("URRf"), orientation is the one the cube is in (0 normal, 1 inverted).
+// cal has SCHEDULE_SERVOS calibrations in ServoType order. Every servo is assumed to start at C
+bool compileSchedule(const std::string& robotMoves, int orientation, const ServoCal* cal, Schedule& out, std::string& error);
+
+// The program as SEQ strings of at most maxLength characters. They are only split before a delay, so the first
+// goes out as "SEQ <first> +" and the rest with "APPEND <next> +" (the last without +), see SequenceManager::appendSequence()
+std::vector<std::string> scheduleSequences(const Schedule& schedule, size_t maxLength);
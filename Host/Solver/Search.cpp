@@ -0,0 +1,176 @@
+#include "Search.h"
+#include <algorithm>
+
+#define MAX_PHASE2_DEPTH 12 // Longer phase 2 searches take forever, a different phase 1 is faster
+
+Search::Search()
+    : tables(getTables())
+{
+}
+
+// Solutions have to be shorter than this
+int Search::bound() const
+{
+    if (opt->sharedBound)
+        return std::min(bestLength, opt->sharedBound->load());
+    return bestLength;
+}
+
+// Same face twice in a row, or opposite faces in both orders, only one of them is worth trying
+bool Search::redundant(int m, int n) const
+{
+    int last = n > 0 ? moves[n - 1] : opt->afterMove;
+    if (last < 0)
+        return false;
+    int face = m / 3, lastFace = last / 3;
+    return face == lastFace || face == lastFace - 3;
+}
+
+bool Search::outOfTime()
+{
+    if (interrupted)
+        return true;
+    // Checking the clock is slow compared to a node, so only do it now and then
+    if ((++nodeCount & 0x3FF) == 0)
+    {
+        if ((opt->stop && opt->stop->load()) || std::chrono::steady_clock::now() > deadline)
+            interrupted = true;
+    }
+    return interrupted;
+}
+
+bool Search::solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution)
+{
+    opt = &options;
+    start = cube;
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+    interrupted = false;
+    nodeCount = 0;
+    best.clear();
+    bestLength = std::min(options.maxLength, 30) + 1;
+
+    int twist = cube.getTwist();
+    int flip = cube.getFlip();
+    int sliceSorted = cube.getSliceSorted();
+
+    for (int depth1 = 0; depth1 < bound(); depth1++)
+    {
+        if (phase1(twist, flip, sliceSorted, depth1, 0))
+            break;
+    }
+
+    if (bestLength > std::min(options.maxLength, 30))
+        return false;
+    solution = best;
+    return true;
+}
+
+// Returns true when the whole search should stop
+bool Search::phase1(int twist, int flip, int sliceSorted, int togo, int n)
+{
+    if (outOfTime())
+        return true;
+
+    int slice = sliceSorted / N_PERM_4;
+    if (togo == 0)
+    {
+        // In the subgroup. If the last move was a phase 2 move, a shorter phase 1 already got here
+        if (twist == 0 && flip == 0 && slice == 0)
+        {
+            if (n > 0)
+            {
+                int last = moves[n - 1];
+                if (last / 3 == FACE_U || last / 3 == FACE_D || last % 3 == 1)
+                    return false;
+            }
+            return phase2Start(n);
+        }
+        return false;
+    }
+
+    int dist = std::max(tables.sliceTwistPrun[slice * N_TWIST + twist], tables.sliceFlipPrun[slice * N_FLIP + flip]);
+    if (dist > togo)
+        return false;
+    // Already in the subgroup with only a few moves to go. Leaving it and coming back that quickly
+    // ends up where phase 2 from here would get anyway
+    if (dist == 0 && togo <= 5)
+        return false;
+
+    for (int m = 0; m < N_MOVES; m++)
+    {
+        if (redundant(m, n))
+        {
+            m += 2;     // Skip the other powers of this face too
+            continue;
+        }
+        moves[n] = m;
+        if (phase1(tables.twistMove[twist][m], tables.flipMove[flip][m], tables.sliceSortedMove[sliceSorted][m],
+                   togo - 1, n + 1))
+            return true;
+    }
+    return false;
+}
+
+bool Search::phase2Start(int n1)
+{
+    // The phase 2 coordinates are only defined inside the subgroup, so get them from the actual cube
+    CubieCube c = start;
+    for (int i = 0; i < n1; i++)
+        c.move(moves[i]);
+    int corners = c.getCorners();
+    int udEdges = c.getUdEdges();
+    int sliceSorted = c.getSliceSorted();
+
+    int maxDepth = std::min(bound() - 1 - n1, MAX_PHASE2_DEPTH);
+    int dist = std::max(tables.cornersSlicePrun[corners * N_PERM_4 + sliceSorted],
+                        tables.udEdgesSlicePrun[udEdges * N_PERM_4 + sliceSorted]);
+
+    for (int depth2 = dist; depth2 <= maxDepth; depth2++)
+    {
+        if (phase2(corners, udEdges, sliceSorted, depth2, n1))
+        {
+            if (interrupted)
+                return true;
+
+            // Found a shorter one
+            bestLength = n1 + depth2;
+            best.assign(moves, moves + bestLength);
+            if (opt->sharedBound)
+            {
+                int shared = opt->sharedBound->load();
+                while (bestLength < shared && !opt->sharedBound->compare_exchange_weak(shared, bestLength))
+                    ;
+            }
+            if (opt->onSolution)
+                opt->onSolution(best);
+            return bestLength <= opt->targetLength;
+        }
+    }
+    return interrupted;
+}
+
+// Returns true when solved (or interrupted)
+bool Search::phase2(int corners, int udEdges, int sliceSorted, int togo, int n)
+{
+    if (togo == 0)
+        return corners == 0 && udEdges == 0 && sliceSorted == 0;
+    if (outOfTime())
+        return true;
+
+    int dist = std::max(tables.cornersSlicePrun[corners * N_PERM_4 + sliceSorted],
+                        tables.udEdgesSlicePrun[udEdges * N_PERM_4 + sliceSorted]);
+    if (dist > togo)
+        return false;
+
+    for (int k = 0; k < N_MOVES_2; k++)
+    {
+        int m = phase2Moves[k];
+        if (redundant(m, n))
+            continue;
+        moves[n] = m;
+        if (phase2(tables.cornersMove[corners][m], tables.udEdgesMove[udEdges][m], tables.sliceSortedMove[sliceSorted][m],
+                   togo - 1, n + 1))
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include "CubieCube.h"
+#include "Tables.h"
+
+struct SearchOptions
+{
+    int maxLength = 21;         // Longest solution worth reporting
+    int targetLength = 0;       // Stop as soon as a solution this short is found
+    long timeoutMs = 1000;      // Give up improving after this long (the best so far is kept)
+    int afterMove = -1;         // Move that was done right before, the solution won't start on its face
+    const std::atomic<bool>* stop = nullptr;    // Set from another thread to stop early
+
+    // Length of the best solution any search on the same cube has found so far (see MultiSearch).
+    // Only shorter solutions are looked for, and every solution found here lowers it
+    std::atomic<int>* sharedBound = nullptr;
+
+    // Called from the searching thread every time a shorter solution is found
+    std::function<void(const std::vector<int>&)> onSolution;
+};
+
+// Two-phase search (Kociemba). It finds a solution quickly and then keeps looking for shorter ones
+// until it runs out of time, gets stopped, or has tried every phase 1 length below the best solution.
+class Search
+{
+public:
+    Search();
+
+    // Returns true if a solution of at most maxLength moves was found, it is in solution (empty if already solved)
+    bool solve(const CubieCube& cube, const SearchOptions& options, std::vector<int>& solution);
+
+    // True if the last solve() ran out of time or was stopped, instead of finishing every phase 1 length
+    bool wasInterrupted() const { return interrupted; }
+    long nodes() const { return nodeCount; }
+
+private:
+    const Tables& tables;
+    const SearchOptions* opt = nullptr;
+    CubieCube start;
+    std::chrono::steady_clock::time_point deadline;
+    bool interrupted = false;
+    long nodeCount = 0;
+
+    int moves[32];
+    std::vector<int> best;
+    int bestLength = 0;     // Length of best, or maxLength + 1 while there is none
+
+    int bound() const;
+    bool redundant(int m, int n) const;
+    bool outOfTime();
+    bool phase1(int twist, int flip, int sliceSorted, int togo, int n);
+    bool phase2Start(int n1);
+    bool phase2(int corners, int udEdges, int sliceSorted, int togo, int n);
+};
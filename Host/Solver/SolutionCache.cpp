@@ -0,0 +1,99 @@
+#include "SolutionCache.h"
+#include <cerrno>
+#include <cstring>
+#include "Moves.h"
+#include "RobotCost.h"
+#include "Symmetry.h"
+
+SolutionCache::~SolutionCache()
+{
+    if (file)
+        std::fclose(file);
+}
+
+bool SolutionCache::open(const std::string& path, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file)
+        std::fclose(file);
+    entries.clear();
+
+    file = std::fopen(path.c_str(), "a+");
+    if (!file)
+    {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::rewind(file);
+    char key[64], moves[256];
+    long timeMs;
+    char line[512];
+    while (std::fgets(line, sizeof(line), file))
+    {
+        // Anything that doesn't look right (like a line cut short by a crash) is skipped
+        if (std::sscanf(line, "%63s %255s %ld", key, moves, &timeMs) != 3 || std::strlen(key) != 54)
+            continue;
+        std::vector<int> check;
+        if (std::strcmp(moves, "-") != 0 && !parseRobotMoves(moves, check))
+            continue;
+        keep(key, {std::strcmp(moves, "-") == 0 ? "" : moves, timeMs});
+    }
+    std::fseek(file, 0, SEEK_END);
+    return true;
+}
+
+bool SolutionCache::keep(const std::string& key, const Entry& entry)
+{
+    auto it = entries.find(key);
+    if (it != entries.end() && it->second.timeMs <= entry.timeMs)
+        return false;
+    entries[key] = entry;
+    return true;
+}
+
+bool SolutionCache::lookup(const std::string& facelets, std::vector<int>& solution, long& timeMs,
+                           int orientation, int delayMs)
+{
+    int sym;
+    std::string key = canonicalFacelets(facelets, sym);
+    std::string moves;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it == entries.end())
+            return false;
+        moves = it->second.moves;
+        timeMs = it->second.timeMs;
+    }
+    std::vector<int> canonical;
+    parseRobotMoves(moves, canonical);
+    solution = symmetryMoves(symmetryInverse(sym), canonical);
+    // The stored time is for the canonical cube, turned back the moves land on other faces
+    if (sym != 0 || orientation != 0 || delayMs != 0)
+        timeMs = robotTimeMs(solution, orientation, delayMs);
+    return true;
+}
+
+bool SolutionCache::store(const std::string& facelets, const std::vector<int>& solution)
+{
+    int sym;
+    std::string key = canonicalFacelets(facelets, sym);
+    std::vector<int> canonical = symmetryMoves(sym, solution);
+    Entry entry{movesToRobot(canonical), robotTimeMs(canonical, 0, 0)};
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!keep(key, entry))
+        return false;
+    if (file)
+    {
+        std::fprintf(file, "%s %s %ld\n", key.c_str(), entry.moves.empty() ? "-" : entry.moves.c_str(), entry.timeMs);
+        std::fflush(file);
+    }
+    return true;
+}
+
+size_t SolutionCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Solutions that were found before, kept in a file so the next run has them too.
+//
+// The key is the canonical facelet string (see Symmetry.h), so a cube that is only a turned or mirrored version
+// of one that was solved before is a hit as well. Every entry has the robot MOVE string of the solution (of the
+// canonical cube) and its simulated execution time (see robotTimeMs()).
+//
+// The file is plain text, one "<canonical facelets> <MOVE string, - if solved> <ms>" per line. New solutions are
+// appended, and when a cube is in there more than once, the fastest one wins. Safe to use from several threads.
+class SolutionCache
+{
+public:
+    ~SolutionCache();
+
+    // Loads the file and keeps it open for store(). Creates it if it isn't there
+    bool open(const std::string& path, std::string& error);
+
+    // The solution for facelets (turned back from the canonical cube) and how long the robot takes for it,
+    // starting in orientation with MOVE <delayMs>
+    bool lookup(const std::string& facelets, std::vector<int>& solution, long& timeMs,
+                int orientation = 0, int delayMs = 0);
+    // Keeps solution if the cache has nothing faster for the cube. Returns true if it was kept
+    bool store(const std::string& facelets, const std::vector<int>& solution);
+
+    size_t size();
+
+private:
+    struct Entry
+    {
+        std::string moves;      // MOVE string of the canonical cube's solution
+        long timeMs;            // Starting in orientation 0 with MOVE 0
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    FILE* file = nullptr;
+
+    bool keep(const std::string& key, const Entry& entry);
+};
@@ -0,0 +1,165 @@
+#include "Symmetry.h"
+#include <mutex>
+
+// Every facelet gets a point on the surface: the face normal times 2, plus -1..1 along the face.
+// Same layout as CubieCube.cpp: U is seen from above with B at the top, D from below with F at the top,
+// and the side faces with U at the top.
+struct Vec
+{
+    int x, y, z;
+    bool operator==(const Vec& o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+static const Vec normals[6] = {
+    {0, 1, 0}, {1, 0, 0}, {0, 0, 1}, {0, -1, 0}, {-1, 0, 0}, {0, 0, -1}   // U R F D L B
+};
+
+static Vec faceletPosition(int f)
+{
+    int face = f / 9, row = f % 9 / 3, col = f % 3;
+    switch (face)
+    {
+    case 0: return {col - 1, 2, row - 1};       // U
+    case 1: return {2, 1 - row, 1 - col};       // R
+    case 2: return {col - 1, 1 - row, 2};       // F
+    case 3: return {col - 1, -2, 1 - row};      // D
+    case 4: return {-2, 1 - row, col - 1};      // L
+    default: return {1 - col, 1 - row, -2};     // B
+    }
+}
+
+struct Symmetry
+{
+    int matrix[3][3];       // A signed permutation matrix
+    int det;
+    int facelet[54];        // Where each facelet goes
+    int face[6];            // Where each face (center) goes
+    int inverse;
+};
+
+static Vec transform(const Symmetry& s, const Vec& v)
+{
+    const int (*m)[3] = s.matrix;
+    return {m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+            m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+            m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z};
+}
+
+static const Symmetry* symmetries()
+{
+    static Symmetry sym[N_SYMMETRIES];
+    static std::once_flag once;
+    std::call_once(once, []()
+    {
+        static const int perms[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+        static const int permSign[6] = {1, -1, -1, 1, 1, -1};
+        Vec positions[54];
+        for (int f = 0; f < 54; f++)
+            positions[f] = faceletPosition(f);
+
+        // 6 axis permutations times 8 sign flips, the identity comes first
+        int n = 0;
+        for (int p = 0; p < 6; p++)
+        {
+            for (int signs = 0; signs < 8; signs++)
+            {
+                Symmetry& s = sym[n++];
+                s.det = permSign[p];
+                for (int r = 0; r < 3; r++)
+                {
+                    int sign = (signs >> r) & 1 ? -1 : 1;
+                    s.det *= sign;
+                    for (int c = 0; c < 3; c++)
+                        s.matrix[r][c] = c == perms[p][r] ? sign : 0;
+                }
+                for (int f = 0; f < 54; f++)
+                {
+                    Vec to = transform(s, positions[f]);
+                    for (int g = 0; g < 54; g++)
+                    {
+                        if (positions[g] == to)
+                            s.facelet[f] = g;
+                    }
+                }
+                for (int face = 0; face < 6; face++)
+                    s.face[face] = s.facelet[9 * face + 4] / 9;
+            }
+        }
+
+        for (int a = 0; a < N_SYMMETRIES; a++)
+        {
+            for (int b = 0; b < N_SYMMETRIES; b++)
+            {
+                bool identity = true;
+                for (int f = 0; f < 54 && identity; f++)
+                    identity = sym[b].facelet[sym[a].facelet[f]] == f;
+                if (identity)
+                    sym[a].inverse = b;
+            }
+        }
+    });
+    return sym;
+}
+
+static const char faceChars[] = "URFDLB";
+
+static int faceIndex(char c)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (faceChars[i] == c)
+            return i;
+    }
+    return -1;
+}
+
+std::string symmetryApply(int s, const std::string& facelets)
+{
+    const Symmetry& sym = symmetries()[s];
+    std::string out(54, '?');
+    for (int f = 0; f < 54 && f < (int)facelets.size(); f++)
+    {
+        int color = faceIndex(facelets[f]);
+        out[sym.facelet[f]] = color < 0 ? facelets[f] : faceChars[sym.face[color]];
+    }
+    return out;
+}
+
+int symmetryInverse(int s)
+{
+    return symmetries()[s].inverse;
+}
+
+int symmetryMove(int s, int m)
+{
+    const Symmetry& sym = symmetries()[s];
+    int power = m % 3;
+    if (sym.det < 0)
+        power = 2 - power;  // A mirror image turns the other way
+    return 3 * sym.face[m / 3] + power;
+}
+
+std::vector<int> symmetryMoves(int s, const std::vector<int>& moves)
+{
+    std::vector<int> out;
+    out.reserve(moves.size());
+    for (int m : moves)
+        out.push_back(symmetryMove(s, m));
+    return out;
+}
+
+std::string canonicalFacelets(const std::string& facelets, int& sym)
+{
+    std::string best = facelets;
+    sym = 0;
+    for (int s = 1; s < N_SYMMETRIES; s++)
+    {
+        std::string candidate = symmetryApply(s, facelets);
+        if (candidate < best)
+        {
+            best = candidate;
+            sym = s;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// The 48 symmetries of the cube (24 rotations, each also mirrored) on facelet strings.
+//
+// A symmetry moves every sticker to where the whole cube being turned (or mirrored) takes it, and renames
+// the colors after the centers, so the result is a normal facelet string again with the centers in URFDLB
+// order. A cube and all its symmetric versions take exactly the same number of moves to solve.
+
+#define N_SYMMETRIES 48     // Symmetry 0 is the identity
+
+std::string symmetryApply(int s, const std::string& facelets);
+int symmetryInverse(int s);
+
+// What move m turns into when the cube is turned/mirrored by s. A mirror also turns the direction around
+int symmetryMove(int s, int m);
+std::vector<int> symmetryMoves(int s, const std::vector<int>& moves);
+
+// The smallest of the 48 versions of facelets (so every symmetric version of a cube gives the same string),
+// and the symmetry that gives it: canonical == symmetryApply(sym, facelets).
+// A solution of the canonical cube solves facelets after symmetryMoves(symmetryInverse(sym), solution)
+std::string canonicalFacelets(const std::string& facelets, int& sym);
@@ -0,0 +1,112 @@
+#include "TableFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+uint64_t tableChecksum(const void* data, size_t size)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+bool writeTableData(const void* data, size_t size, const char* magic, uint32_t version,
+                    const std::string& path, std::string& error)
+{
+    TableFileHeader header = {};
+    std::strncpy(header.magic, magic, sizeof(header.magic) - 1);
+    header.version = version;
+    header.byteOrder = TABLE_FILE_BYTE_ORDER;
+    header.dataSize = size;
+    header.checksum = tableChecksum(data, size);
+
+    // Write to a temporary file and rename it, so a solver never maps a half written one
+    std::string tmp = path + ".tmp";
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        error = "cannot create " + tmp;
+        return false;
+    }
+    char page[TABLE_FILE_DATA_OFFSET] = {};
+    std::memcpy(page, &header, sizeof(header));
+    out.write(page, sizeof(page));
+    out.write(static_cast<const char*>(data), size);
+    out.close();
+    if (!out)
+    {
+        error = "cannot write " + tmp;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        error = "cannot rename " + tmp + " to " + path;
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+const void* mapTableData(const std::string& path, size_t size, const char* magic, uint32_t version,
+                         bool verify, std::string& error)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size != TABLE_FILE_DATA_OFFSET + size)
+    {
+        close(fd);
+        error = path + " has the wrong size, it was made for a different version";
+        return nullptr;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid
+    if (map == MAP_FAILED)
+    {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+
+    TableFileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    const char* data = static_cast<const char*>(map) + TABLE_FILE_DATA_OFFSET;
+    if (std::strncmp(header.magic, magic, sizeof(header.magic)) != 0)
+        error = path + " is not a " + magic + " table file";
+    else if (header.version != version || header.dataSize != size)
+        error = path + " is version " + std::to_string(header.version) + ", expected " + std::to_string(version);
+    else if (header.byteOrder != TABLE_FILE_BYTE_ORDER)
+        error = path + " was made on a machine with a different byte order";
+    else if (verify && tableChecksum(data, size) != header.checksum)
+        error = path + " is corrupt (checksum mismatch)";
+    else
+        return data;
+
+    munmap(map, st.st_size);
+    return nullptr;
+}
+
+bool writeTableFile(const Tables& tables, const std::string& path, std::string& error)
+{
+    return writeTableData(&tables, sizeof(Tables), TABLE_FILE_MAGIC, TABLE_FILE_VERSION, path, error);
+}
+
+const Tables* mapTableFile(const std::string& path, bool verify, std::string& error)
+{
+    return static_cast<const Tables*>(mapTableData(path, sizeof(Tables), TABLE_FILE_MAGIC, TABLE_FILE_VERSION, verify, error));
+}
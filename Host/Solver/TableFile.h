@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Tables.h"
+
+// Precomputed Tables in a file, so a solver doesn't have to build them first.
+// The file is mapped read-only, so it costs no time to load and every solver process on the machine
+// shares the same pages. Generate it with the maketables tool (see Host/README.md).
+//
+// Layout: TableFileHeader, zero padding up to TABLE_FILE_DATA_OFFSET, then the Tables struct as it is in memory.
+// That makes the file specific to the byte order and struct layout of the machine that wrote it, which is
+// what dataSize and byteOrder are there to catch.
+
+#define TABLE_FILE_MAGIC "CUBETBL"
+#define TABLE_FILE_VERSION 1            // Bump whenever Tables changes
+#define TABLE_FILE_DATA_OFFSET 4096     // Page aligned, so the mapped Tables are too
+#define TABLE_FILE_BYTE_ORDER 0x01020304
+
+struct TableFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t dataSize;      // sizeof(Tables), or whatever else the file holds
+    uint64_t checksum;      // FNV-1a of the data
+};
+
+uint64_t tableChecksum(const void* data, size_t size);
+
+// The same for any block of tables, with its own magic (7 characters) and version
+bool writeTableData(const void* data, size_t size, const char* magic, uint32_t version,
+                    const std::string& path, std::string& error);
+const void* mapTableData(const std::string& path, size_t size, const char* magic, uint32_t version,
+                         bool verify, std::string& error);
+
+bool writeTableFile(const Tables& tables, const std::string& path, std::string& error);
+
+// Returns the mapped tables, or nullptr with the reason in error. Set verify to false to skip the checksum,
+// which reads the whole file (a few milliseconds, most of it the page faults)
+const Tables* mapTableFile(const std::string& path, bool verify, std::string& error);
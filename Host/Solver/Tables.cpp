@@ -0,0 +1,146 @@
+#include "Tables.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unistd.h>
+#include "TableFile.h"
+
+const int phase2Moves[N_MOVES_2] = {0, 1, 2, 4, 7, 9, 10, 11, 13, 16};
+
+template <int N, typename Get, typename Set>
+static void buildMoveTable(uint16_t (*table)[N_MOVES], Get get, Set set, bool phase2Only)
+{
+    for (int i = 0; i < N; i++)
+    {
+        CubieCube c;
+        set(c, i);
+        for (int face = 0; face < 6; face++)
+        {
+            CubieCube d = c;
+            for (int power = 0; power < 3; power++)
+            {
+                d.multiply(CubieCube::basicMove(face));
+                int m = 3 * face + power;
+                bool inPhase2 = face == FACE_U || face == FACE_D || power == 1;
+                if (!phase2Only || inPhase2)
+                    table[i][m] = get(d);
+            }
+        }
+    }
+}
+
+// Breadth first search from the solved state, one layer per pass over the table
+static void buildPruning(int8_t* prun, int size1, int size2,
+                         const uint16_t (*move1)[N_MOVES], const uint16_t (*move2)[N_MOVES],
+                         const int* moves, int numMoves)
+{
+    int total = size1 * size2;
+    std::memset(prun, -1, total);
+    prun[0] = 0;
+    int done = 1;
+    for (int depth = 0; done < total; depth++)
+    {
+        for (int i = 0; i < total; i++)
+        {
+            if (prun[i] != depth)
+                continue;
+            int c1 = i / size2;
+            int c2 = i % size2;
+            for (int k = 0; k < numMoves; k++)
+            {
+                int m = moves[k];
+                int j = move1[c1][m] * size2 + move2[c2][m];
+                if (prun[j] < 0)
+                {
+                    prun[j] = depth + 1;
+                    done++;
+                }
+            }
+        }
+    }
+}
+
+void Tables::build()
+{
+    buildMoveTable<N_TWIST>(twistMove, [](const CubieCube& c) { return c.getTwist(); },
+                            [](CubieCube& c, int i) { c.setTwist(i); }, false);
+    buildMoveTable<N_FLIP>(flipMove, [](const CubieCube& c) { return c.getFlip(); },
+                           [](CubieCube& c, int i) { c.setFlip(i); }, false);
+    buildMoveTable<N_SLICE_SORTED>(sliceSortedMove, [](const CubieCube& c) { return c.getSliceSorted(); },
+                                   [](CubieCube& c, int i) { c.setSliceSorted(i); }, false);
+    buildMoveTable<N_CORNERS_PERM>(cornersMove, [](const CubieCube& c) { return c.getCorners(); },
+                                   [](CubieCube& c, int i) { c.setCorners(i); }, false);
+    std::memset(udEdgesMove, 0, sizeof(udEdgesMove));
+    buildMoveTable<N_UD_EDGES>(udEdgesMove, [](const CubieCube& c) { return c.getUdEdges(); },
+                               [](CubieCube& c, int i) { c.setUdEdges(i); }, true);
+
+    // The slice coordinate is sliceSorted / 24, this maps it through the sliceSorted table
+    static uint16_t sliceMove[N_SLICE][N_MOVES];
+    for (int i = 0; i < N_SLICE; i++)
+    {
+        for (int m = 0; m < N_MOVES; m++)
+            sliceMove[i][m] = sliceSortedMove[i * N_PERM_4][m] / N_PERM_4;
+    }
+
+    int allMoves[N_MOVES];
+    for (int m = 0; m < N_MOVES; m++)
+        allMoves[m] = m;
+
+    buildPruning(sliceTwistPrun, N_SLICE, N_TWIST, sliceMove, twistMove, allMoves, N_MOVES);
+    buildPruning(sliceFlipPrun, N_SLICE, N_FLIP, sliceMove, flipMove, allMoves, N_MOVES);
+    // In phase 2 the slice edges stay in the slice, so sliceSorted < 24 and the table is indexed directly
+    buildPruning(cornersSlicePrun, N_CORNERS_PERM, N_PERM_4, cornersMove, sliceSortedMove, phase2Moves, N_MOVES_2);
+    buildPruning(udEdgesSlicePrun, N_UD_EDGES, N_PERM_4, udEdgesMove, sliceSortedMove, phase2Moves, N_MOVES_2);
+}
+
+static std::mutex tablesMutex;
+static const Tables* tables = nullptr;
+static std::string source;
+
+bool useTableFile(const std::string& path, std::string& error)
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    if (tables)
+    {
+        error = "tables are already in use";
+        return false;
+    }
+    tables = mapTableFile(path, true, error);
+    if (tables)
+        source = path;
+    return tables != nullptr;
+}
+
+const Tables& getTables()
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    if (!tables)
+    {
+        const char* env = std::getenv("CUBE_TABLES");
+        std::string path = env ? env : "cubetables.bin";
+        std::string error;
+        tables = mapTableFile(path, true, error);
+        if (tables)
+        {
+            source = path;
+        }
+        else
+        {
+            // No file is fine, a bad one is worth a word
+            if (env || access(path.c_str(), F_OK) == 0)
+                std::fprintf(stderr, "Not using table file: %s\n", error.c_str());
+            Tables* built = new Tables;
+            built->build();
+            tables = built;
+            source = "built in memory";
+        }
+    }
+    return *tables;
+}
+
+const char* tablesSource()
+{
+    std::lock_guard<std::mutex> lock(tablesMutex);
+    return source.c_str();
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "CubieCube.h"
+
+// Move and pruning tables of the two-phase algorithm.
+// Everything is plain arrays in one struct (about 10MB), so it can be built once and shared by every search.
+//
+// Phase 1 brings the cube into the subgroup <U, D, R2, L2, F2, B2> (no twist, no flip, slice edges in the slice),
+// phase 2 solves it using only those moves.
+
+// Phase 2 moves: U, U2, U', R2, F2, D, D2, D', L2, B2
+#define N_MOVES_2 10
+extern const int phase2Moves[N_MOVES_2];
+
+struct Tables
+{
+    // Coordinate after a move, [coordinate][move]
+    uint16_t twistMove[N_TWIST][N_MOVES];
+    uint16_t flipMove[N_FLIP][N_MOVES];
+    uint16_t sliceSortedMove[N_SLICE_SORTED][N_MOVES];
+    uint16_t cornersMove[N_CORNERS_PERM][N_MOVES];
+    uint16_t udEdgesMove[N_UD_EDGES][N_MOVES];      // Only filled in for the phase 2 moves
+
+    // Lower bounds on the number of moves left, -1 while building
+    int8_t sliceTwistPrun[N_SLICE * N_TWIST];           // Phase 1, slice * N_TWIST + twist
+    int8_t sliceFlipPrun[N_SLICE * N_FLIP];             // Phase 1, slice * N_FLIP + flip
+    int8_t cornersSlicePrun[N_CORNERS_PERM * N_PERM_4]; // Phase 2, corners * N_PERM_4 + sliceSorted
+    int8_t udEdgesSlicePrun[N_UD_EDGES * N_PERM_4];     // Phase 2, udEdges * N_PERM_4 + sliceSorted
+
+    void build();
+};
+
+// The tables every search uses. The first call maps the table file ($CUBE_TABLES, or cubetables.bin in the
+// current directory, see TableFile.h) and if there is no valid one, builds them (a second or so). Thread safe
+const Tables& getTables();
+
+// Map this table file instead of looking for the default one. Only works before the first getTables()
+bool useTableFile(const std::string& path, std::string& error);
+
+// Where the tables came from, for -v output
+const char* tablesSource();
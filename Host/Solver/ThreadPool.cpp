@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+ThreadPool::ThreadPool(int threads)
+{
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; i++)
+        queues.emplace_back(new Worker);
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    pending++;
+    Worker& q = *queues[nextQueue++ % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.tasks.push_back(std::move(task));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return pending == 0; });
+}
+
+bool ThreadPool::take(int self, std::function<void()>& task)
+{
+    // Own queue first, newest task
+    {
+        Worker& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    // Then steal the oldest from the others
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        Worker& q = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.tasks.empty())
+        {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(int self)
+{
+    while (true)
+    {
+        std::function<void()> task;
+        if (take(self, task))
+        {
+            task();
+            if (--pending == 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (quit)
+            return;
+        // A task that landed in a queue right after take() looked is picked up after the timeout at the latest
+        wake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
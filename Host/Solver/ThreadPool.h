@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool.
+// Every worker has its own queue and takes its newest task first. When it runs dry, it takes the oldest task
+// from another worker's queue. Solves take anything from a millisecond to the whole time budget, so this keeps
+// every core busy without one shared queue everybody fights over.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads = 0);     // 0 = one per core
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    void wait();    // Until every submitted task is done
+
+    int size() const { return (int)workers.size(); }
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;               // For the condition variables only
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::atomic<int> pending{0};    // Submitted but not finished
+    std::atomic<int> nextQueue{0};
+    bool quit = false;
+
+    bool take(int self, std::function<void()>& task);
+    void run(int self);
+};
@@ -0,0 +1,464 @@
+// End to end benchmark: solves random scrambles and runs the solutions through the firmware's SequenceManager
+// (built for the PC, see Sim/) on the virtual clock, like the robot would with MOVE.
+//
+//   cubebench [options]
+//
+// Options:
+//   -n <n>        Number of scrambles (default 1000)
+//   -r <seed>     Random seed, the same seed gives the same scrambles (default 1)
+//   -m <n>        Longest solution to accept (default 21)
+//   -t <ms>       Search this long per cube like cubesolve does. Without it every cube gets the first solution
+//                 of at most -m moves, which doesn't depend on how fast the PC is
+//   -j <n>        With -t, search threads per cube (default 1)
+//   -d <ms>       MOVE delay (default 0, wait for the servos)
+//   -e <file>     EEPROM image with the calibrations (caltool makes these)
+//   -S            Compile each solution into one timed program (ScheduleCompiler.h) and play it as a streamed SEQ
+//                 instead of MOVE
+//   -T <file>     Table file (see cubesolve)
+//   -v            Print every solution with its time
+//
+// Reports the robot time per solve, the cube flips (appendRotateCube), the longest activeSequence and what a tick()
+// costs, then microbenchmarks of populateActiveSequenceMove and handleSequence. The last line is the number to
+// track: the average robot time per solve. CPU times are for this PC, a nano is a lot slower, but relative
+// changes carry over.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Sim/Firmware.h"
+#include "../Solver/Moves.h"
+#include "../Solver/MultiSearch.h"
+#include "../Solver/ScheduleCompiler.h"
+#include "../Solver/Search.h"
+#include "../Solver/Tables.h"
+#include "../Solver/ThreadPool.h"
+#include "../../Arduino/MyServo.h"
+#include "../../Arduino/SequenceManager.h"
+#include "../../Arduino/TxQueue.h"
+
+#define SCRAMBLE_LENGTH 25
+#define MAX_TICK_NS 10000   // Tick times are counted per ns up to here, anything longer in the last bucket
+#define SOLVE_LIMIT_MS 600000
+
+using Clock = std::chrono::steady_clock;
+
+// The SequenceManager internals, for the microbenchmarks (it is a friend)
+class SequenceBench
+{
+public:
+    static void setDelay(int delayMs)
+    {
+        seqManager.movesDelayMs = delayMs;
+        if (delayMs == 0)
+            std::strcpy(seqManager.delayToken, "W");
+        else
+            std::snprintf(seqManager.delayToken, sizeof(seqManager.delayToken), "%d", delayMs);
+    }
+
+    static void populate(char move, bool deps)
+    {
+        seqManager.activeSequence[0] = '\0';
+        if (deps)
+            seqManager.populateActiveSequenceMoveDeps(move);
+        else
+            seqManager.populateActiveSequenceMove(move);
+    }
+
+    static int handleSequence() { return seqManager.handleSequence(); }
+};
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static double elapsedNs(Clock::time_point from)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - from).count();
+}
+
+static std::vector<int> randomScramble(std::mt19937& rng)
+{
+    std::vector<int> moves;
+    while (moves.size() < SCRAMBLE_LENGTH)
+    {
+        int m = (int)(rng() % N_MOVES);
+        if (!moves.empty() && m / 3 == moves.back() / 3)
+            continue;
+        moves.push_back(m);
+    }
+    return moves;
+}
+
+struct Run
+{
+    double ms = 0;          // Robot time
+    int flips = 0;
+    size_t peakSequence = 0;
+    bool finished = false;
+};
+
+// Tick times, counted per ns
+static std::vector<long> tickCounts(MAX_TICK_NS + 1);
+static long ticks = 0;
+static double tickNs = 0, maxTickNs = 0;
+
+static double tickPercentile(double p)
+{
+    if (ticks == 0)
+        return 0;
+    long want = (long)(p / 100 * ticks), seen = 0;
+    for (size_t ns = 0; ns < tickCounts.size(); ns++)
+    {
+        seen += tickCounts[ns];
+        if (seen > want)
+            return (double)ns;
+    }
+    return MAX_TICK_NS;
+}
+
+// seqManager.tick(), counted in the tick times unless it failed
+static int timedTick()
+{
+    auto t0 = Clock::now();
+    int result = seqManager.tick();
+    double ns = elapsedNs(t0);
+    if (result < 0)
+        return result;
+
+    ticks++;
+    tickNs += ns;
+    maxTickNs = std::max(maxTickNs, ns);
+    tickCounts[std::min((size_t)ns, tickCounts.size() - 1)]++;
+    return result;
+}
+
+static Run runMoves(const std::string& moves, int delayMs)
+{
+    Run run;
+    seqManager.orientation = ORIENT_NORMAL;
+    CubeOrientation orientation = ORIENT_NORMAL;
+    double start = firmwareMicros() / 1000.0;
+    if (seqManager.startMoves(moves.c_str(), delayMs) != 0)
+        return run;
+    while (seqManager.isBusy() && firmwareMicros() / 1000.0 - start < SOLVE_LIMIT_MS)
+    {
+        if (timedTick() < 0)
+            return run;
+        txDrain();  // Like loop(), or BUSY/IDLE pile up until printing waits
+        if (seqManager.orientation != orientation)
+        {
+            run.flips++;
+            orientation = seqManager.orientation;
+        }
+        run.peakSequence = std::max(run.peakSequence, std::strlen(seqManager.activeSequence));
+        firmwareAdvance(FIRMWARE_LOOP_US);
+    }
+    run.ms = firmwareMicros() / 1000.0 - start;
+    run.finished = !seqManager.isBusy();
+    return run;
+}
+
+// The solution compiled into one program, sent like the host would: "SEQ <first part> +", then APPEND the rest
+// as soon as there is room. Also what the compiler expected it to take, and MOVE 0 by the same reckoning
+static Run runSchedule(const std::string& moves, double& expectMs, double& perMoveMs)
+{
+    Run run;
+    ServoCal cal[NUM_SERVOS];
+    for (int i = 0; i < NUM_SERVOS; i++)
+        cal[i] = servos[i].getCalibration();
+    Schedule schedule;
+    std::string error;
+    if (!compileSchedule(moves, ORIENT_NORMAL, cal, schedule, error))
+        return run;
+    expectMs = schedule.makespanMs;
+    perMoveMs = schedule.perMoveMs;
+
+    std::vector<std::string> parts = scheduleSequences(schedule, SEQUENCE_BUFFER_SIZE / 2);
+    size_t sent = 1;
+    double start = firmwareMicros() / 1000.0;
+    if (seqManager.startSequence(parts[0].c_str(), parts.size() > 1) != 0)
+        return run;
+    while (seqManager.isBusy() && firmwareMicros() / 1000.0 - start < SOLVE_LIMIT_MS)
+    {
+        if (sent < parts.size() && seqManager.appendSequence(parts[sent].c_str(), sent + 1 < parts.size()) == 0)
+            sent++;
+        if (timedTick() < 0)
+            return run;
+        txDrain();
+        run.peakSequence = std::max(run.peakSequence, std::strlen(seqManager.activeSequence));
+        firmwareAdvance(FIRMWARE_LOOP_US);
+    }
+    run.ms = firmwareMicros() / 1000.0 - start;
+    run.finished = !seqManager.isBusy();
+    return run;
+}
+
+// ns per populateActiveSequenceMove(), going through the moves in order with the orientation following along
+static double benchPopulate(const std::vector<std::string>& solutions, bool deps, int rounds)
+{
+    SequenceBench::setDelay(deps ? 0 : 20);
+    long calls = 0;
+    auto t0 = Clock::now();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (const std::string& s : solutions)
+        {
+            seqManager.orientation = ORIENT_NORMAL;
+            for (char c : s)
+            {
+                SequenceBench::populate(c, deps);
+                calls++;
+            }
+        }
+    }
+    return calls ? elapsedNs(t0) / calls : 0;
+}
+
+// ns per handleSequence() call and per whole sequence, for the sequence of a move with a flip ("U" from normal)
+static void benchHandleSequence(int delayMs, int rounds, double& perCall, double& perSequence)
+{
+    SequenceBench::setDelay(delayMs);
+    seqManager.orientation = ORIENT_NORMAL;
+    SequenceBench::populate('U', delayMs == 0);
+    std::string sequence = seqManager.activeSequence;
+
+    long calls = 0;
+    double ns = 0;
+    for (int r = 0; r < rounds; r++)
+    {
+        seqManager.startSequence(sequence.c_str());
+        unsigned long lastUpdate = 0;
+        while (seqManager.isBusy())
+        {
+            unsigned long now = millis();
+            if (now - lastUpdate >= MOTION_TICK_MS)
+            {
+                lastUpdate = now;
+                updateAllServos(now);
+            }
+            auto t0 = Clock::now();
+            SequenceBench::handleSequence();
+            ns += elapsedNs(t0);
+            calls++;
+            firmwareAdvance(FIRMWARE_LOOP_US);
+        }
+    }
+    perCall = calls ? ns / calls : 0;
+    perSequence = rounds ? ns / rounds : 0;
+}
+
+static void usage()
+{
+    std::cerr << "Usage: cubebench [-n scrambles] [-r seed] [-m maxlen] [-t ms [-j threads]] [-d delay | -S] [-e eeprom.eep] [-T tables] [-v]\n";
+}
+
+int main(int argc, char** argv)
+{
+    int count = 1000;
+    unsigned seed = 1;
+    int maxLength = 21;
+    long timeMs = 0;
+    int variants = 1;
+    int delayMs = 0;
+    bool verbose = false;
+    bool compiled = false;
+    const char* eepromFile = nullptr;
+    const char* tableFile = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-n") == 0 && hasValue)
+            count = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-r") == 0 && hasValue)
+            seed = (unsigned)std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-m") == 0 && hasValue)
+            maxLength = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-t") == 0 && hasValue)
+            timeMs = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-j") == 0 && hasValue)
+            variants = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-d") == 0 && hasValue)
+            delayMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-e") == 0 && hasValue)
+            eepromFile = argv[++i];
+        else if (std::strcmp(argv[i], "-T") == 0 && hasValue)
+            tableFile = argv[++i];
+        else if (std::strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (std::strcmp(argv[i], "-S") == 0)
+            compiled = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (count < 1)
+    {
+        usage();
+        return 2;
+    }
+
+    std::string error;
+    if (tableFile && !useTableFile(tableFile, error))
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    getTables();
+    if (eepromFile)
+    {
+        std::ifstream in(eepromFile, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Cannot open " << eepromFile << "\n";
+            return 1;
+        }
+        in.read(reinterpret_cast<char*>(firmwareEeprom()), 1024);
+    }
+
+    // ---- Solve ----
+    std::mt19937 rng(seed);
+    std::vector<CubieCube> cubes(count);
+    for (CubieCube& cube : cubes)
+        cube.applyMoves(randomScramble(rng));
+
+    std::vector<std::string> solutions(count);
+    std::vector<int> lengths(count, -1);
+    auto solveStart = Clock::now();
+    {
+        ThreadPool pool;
+        for (int i = 0; i < count; i++)
+        {
+            pool.submit([&, i]()
+            {
+                SearchOptions opt;
+                opt.maxLength = maxLength;
+                std::vector<int> solution;
+                bool ok;
+                if (timeMs > 0)
+                {
+                    opt.timeoutMs = timeMs;
+                    MultiSearch search;
+                    search.variants = variants;
+                    ok = search.solve(cubes[i], opt, solution);
+                }
+                else
+                {
+                    opt.targetLength = maxLength;
+                    opt.timeoutMs = SOLVE_LIMIT_MS;
+                    Search search;
+                    ok = search.solve(cubes[i], opt, solution);
+                }
+                if (ok)
+                {
+                    solutions[i] = movesToRobot(solution);
+                    lengths[i] = (int)solution.size();
+                }
+            });
+        }
+        pool.wait();
+    }
+    double solveSeconds = elapsedNs(solveStart) / 1e9;
+
+    // ---- Run them on the firmware ----
+    firmwareOnOutput([](const std::string&) {});
+    firmwareStart();
+    attachAllServos();
+
+    std::vector<double> times;
+    std::vector<std::string> solved;
+    long moves = 0, flips = 0;
+    double expectTotal = 0, perMoveTotal = 0;
+    int maxFlips = 0, unsolved = 0, stuck = 0;
+    size_t peakSequence = 0;
+    auto runStart = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        if (lengths[i] < 0)
+        {
+            unsolved++;
+            continue;
+        }
+        if (solutions[i].empty())
+            continue;   // Scrambled back to solved
+        double expectMs = 0, perMoveMs = 0;
+        Run run = compiled ? runSchedule(solutions[i], expectMs, perMoveMs) : runMoves(solutions[i], delayMs);
+        if (!run.finished)
+        {
+            stuck++;
+            continue;
+        }
+        if (verbose && compiled)
+            std::printf("%s %.0fms, compiled for %.0fms\n", solutions[i].c_str(), run.ms, expectMs);
+        else if (verbose)
+            std::printf("%s %.0fms %d flips\n", solutions[i].c_str(), run.ms, run.flips);
+        expectTotal += expectMs;
+        perMoveTotal += perMoveMs;
+        times.push_back(run.ms);
+        solved.push_back(solutions[i]);
+        moves += lengths[i];
+        flips += run.flips;
+        maxFlips = std::max(maxFlips, run.flips);
+        peakSequence = std::max(peakSequence, run.peakSequence);
+        // Let the servos finish their ramps like between two MOVEs
+        firmwareAdvance(1000000);
+        seqManager.tick();
+        txDrain();
+    }
+    double runSeconds = elapsedNs(runStart) / 1e9;
+    if (times.empty())
+    {
+        std::cerr << "Nothing was solved\n";
+        return 1;
+    }
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double t : times)
+        total += t;
+    double mean = total / times.size();
+    size_t n = times.size();
+
+    std::printf("Solved %d scrambles in %.1fs (%s), ran them in %.1fs\n", count, solveSeconds,
+                timeMs > 0 ? (std::to_string(timeMs) + "ms search each").c_str() : ("first solution of at most " + std::to_string(maxLength) + " moves").c_str(),
+                runSeconds);
+    if (unsolved || stuck)
+        std::printf("%d not solved, %d didn't finish on the robot\n", unsolved, stuck);
+    std::printf("Robot time per solve: mean %.0fms, p50 %.0f, p90 %.0f, p99 %.0f, max %.0f (%s)\n", mean,
+                percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 99), sorted.back(),
+                compiled ? "compiled SEQ" : ("MOVE " + std::to_string(delayMs)).c_str());
+    if (compiled)
+        std::printf("Compiled for %.0fms per solve, one move at a time would be %.0fms\n", expectTotal / n, perMoveTotal / n);
+    std::printf("Moves per solve %.1f, %.0fms per move\n", (double)moves / n, total / moves);
+    if (!compiled)
+        std::printf("Flips per solve %.2f, at most %d\n", (double)flips / n, maxFlips);
+    std::printf("Longest activeSequence %zu of %d bytes\n", peakSequence, SEQUENCE_BUFFER_SIZE);
+    std::printf("tick(): %ld calls, mean %.0fns, p50 %.0f, p99 %.0f, max %.0f\n", ticks, ticks ? tickNs / ticks : 0.0,
+                tickPercentile(50), tickPercentile(99), maxTickNs);
+
+    // ---- Microbenchmarks ----
+    int rounds = std::max(1, 200000 / (int)std::max<long>(1, moves));
+    std::printf("populateActiveSequenceMove: %.0fns per move\n", benchPopulate(solved, false, rounds));
+    std::printf("populateActiveSequenceMoveDeps: %.0fns per move\n", benchPopulate(solved, true, rounds));
+    double perCall, perSequence;
+    benchHandleSequence(20, 200, perCall, perSequence);
+    std::printf("handleSequence (delay 20, a turn with a flip): %.0fns per call, %.1fus per sequence\n", perCall, perSequence / 1000);
+    benchHandleSequence(0, 200, perCall, perSequence);
+    std::printf("handleSequence (W, a turn with a flip): %.0fns per call, %.1fus per sequence\n", perCall, perSequence / 1000);
+
+    std::printf("Score: %.0fms robot time per solve\n", mean);
+    return 0;
+}
@@ -0,0 +1,273 @@
+// Dump and restore the servo calibration store (see Arduino/CalStore.h) as text.
+// The text is the same table the calibration tool prints with "p", so Calibrations.info files can be restored directly.
+//
+//   caltool dump <eeprom.bin>               Print the table stored in an EEPROM image
+//   caltool restore <table> <eeprom.bin>    Write a table into an EEPROM image (created if it does not exist)
+//   caltool script <table>                  Print calibration mode commands that load a table over serial
+//
+// EEPROM images are raw dumps, like the ones avrdude reads and writes with -U eeprom:r:robot.eep:r
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../../Arduino/CalStore.h"
+#include "../../Arduino/Config.h"
+#include "../../Arduino/Types.h"
+
+#define EEPROM_SIZE 1024    // ATmega328P
+
+static const char* servoNames[CALSTORE_NUM_SERVOS] = {
+    "RIGHT_SPINNER", "RIGHT_SLIDER", "LEFT_SPINNER", "LEFT_SLIDER",
+    "FRONT_SPINNER", "FRONT_SLIDER", "BACK_SPINNER", "BACK_SLIDER"
+};
+
+static const int servoPins[CALSTORE_NUM_SERVOS] = {
+    RIGHT_SPINNER_PIN, RIGHT_SLIDER_PIN, LEFT_SPINNER_PIN, LEFT_SLIDER_PIN,
+    FRONT_SPINNER_PIN, FRONT_SLIDER_PIN, BACK_SPINNER_PIN, BACK_SLIDER_PIN
+};
+
+// The AVR is little endian, don't rely on the host being the same
+static uint16_t get16(const std::vector<uint8_t>& img, size_t addr)
+{
+    return img[addr] | (img[addr + 1] << 8);
+}
+
+static void put16(std::vector<uint8_t>& img, size_t addr, uint16_t value)
+{
+    img[addr] = value & 0xFF;
+    img[addr + 1] = value >> 8;
+}
+
+static CalRecord getRecord(const std::vector<uint8_t>& img, size_t addr)
+{
+    CalRecord rec;
+    rec.L_us = get16(img, addr);
+    rec.R_us = get16(img, addr + 2);
+    rec.C_us = get16(img, addr + 4);
+    rec.CD_us = get16(img, addr + 6);
+    rec.speed = get16(img, addr + 8);
+    rec.settleMs = get16(img, addr + 10);
+    rec.accel = get16(img, addr + 12);
+    return rec;
+}
+
+static void putRecord(std::vector<uint8_t>& img, size_t addr, const CalRecord& rec)
+{
+    put16(img, addr, rec.L_us);
+    put16(img, addr + 2, rec.R_us);
+    put16(img, addr + 4, rec.C_us);
+    put16(img, addr + 6, rec.CD_us);
+    put16(img, addr + 8, rec.speed);
+    put16(img, addr + 10, rec.settleMs);
+    put16(img, addr + 12, rec.accel);
+}
+
+static bool readImage(const char* path, std::vector<uint8_t>& img)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+    img.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (img.size() < EEPROM_SIZE)
+        img.resize(EEPROM_SIZE, 0xFF);
+    return true;
+}
+
+// Same rules as storedVersion() in Calibrate.cpp
+static int imageVersion(const std::vector<uint8_t>& img)
+{
+    uint16_t magic = get16(img, CALSTORE_ADDR);
+    if (magic == CALSTORE_LEGACY_MAGIC)
+        return 0;
+
+    uint8_t version = img[CALSTORE_ADDR + 2];
+    uint8_t count = img[CALSTORE_ADDR + 3];
+    uint16_t crc = get16(img, CALSTORE_ADDR + 4);
+    if (magic != CALSTORE_MAGIC || version < 1 || version > CALSTORE_VERSION || count != CALSTORE_NUM_SERVOS)
+        return -1;
+    if (calStoreCrc(&img[CALSTORE_RECORDS_ADDR], calStoreRecordsSize(version)) != crc)
+        return -1;
+    return version;
+}
+
+// Same as readRecord() in Calibrate.cpp, older versions get defaults for what they didn't have
+static CalRecord imageRecord(const std::vector<uint8_t>& img, int version, int index)
+{
+    CalRecord rec = {0, 0, 0, 0, CALSTORE_DEFAULT_SPEED, CALSTORE_DEFAULT_SETTLE_MS, CALSTORE_DEFAULT_ACCEL};
+    if (version == 0)
+    {
+        size_t addr = CALSTORE_LEGACY_DATA_ADDR + index * sizeof(CalRecordV0);
+        rec.L_us = get16(img, addr);
+        rec.R_us = get16(img, addr + 2);
+        rec.C_us = get16(img, addr + 4);
+        rec.CD_us = get16(img, addr + 6);
+    }
+    else if (version == 1)
+    {
+        size_t addr = CALSTORE_RECORDS_ADDR + index * sizeof(CalRecordV1);
+        rec.L_us = get16(img, addr);
+        rec.R_us = get16(img, addr + 2);
+        rec.C_us = get16(img, addr + 4);
+        rec.CD_us = get16(img, addr + 6);
+        rec.speed = get16(img, addr + 8);
+        rec.settleMs = get16(img, addr + 10);
+    }
+    else
+    {
+        rec = getRecord(img, CALSTORE_RECORDS_ADDR + index * sizeof(CalRecord));
+    }
+    return rec;
+}
+
+// Parse the rows of a "p" table: idx pin type L R C Dev [Speed Settle [Accel]]
+// Anything that doesn't start with a servo index (headers, notes) is skipped.
+static bool readTable(const char* path, CalRecord* records)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+
+    bool seen[CALSTORE_NUM_SERVOS] = {};
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line))
+    {
+        lineNo++;
+        std::istringstream row(line);
+        int idx, pin;
+        std::string type;
+        unsigned int L, R, C, CD;
+        if (!(row >> idx >> pin >> type >> L >> R >> C >> CD))
+            continue;
+
+        if (idx < 0 || idx >= CALSTORE_NUM_SERVOS)
+        {
+            std::cerr << path << ":" << lineNo << ": bad servo index " << idx << "\n";
+            return false;
+        }
+        if (type != servoNames[idx])
+            std::cerr << path << ":" << lineNo << ": warning: servo " << idx << " is " << servoNames[idx]
+                      << " but the table says " << type << "\n";
+
+        // Tables from before the timing columns existed just get the defaults
+        unsigned int speed = CALSTORE_DEFAULT_SPEED, settle = CALSTORE_DEFAULT_SETTLE_MS, accel = CALSTORE_DEFAULT_ACCEL;
+        if (row >> speed && row >> settle)
+            row >> accel;
+
+        records[idx] = {(uint16_t)L, (uint16_t)R, (uint16_t)C, (uint16_t)CD,
+                        (uint16_t)speed, (uint16_t)settle, (uint16_t)accel};
+        seen[idx] = true;
+    }
+
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+    {
+        if (!seen[i])
+        {
+            std::cerr << path << ": no row for servo " << i << " (" << servoNames[i] << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+static int dump(const char* imagePath)
+{
+    std::vector<uint8_t> img;
+    if (!readImage(imagePath, img))
+    {
+        std::cerr << "Cannot open " << imagePath << "\n";
+        return 1;
+    }
+
+    int version = imageVersion(img);
+    if (version < 0)
+    {
+        std::cerr << "No valid calibration store in " << imagePath << " (bad magic, version or CRC)\n";
+        return 1;
+    }
+
+    std::printf("Calibrations dumped from %s (layout version %d)\n\n", imagePath, version);
+    std::printf("Idx Pin Type     L(us) R(us) C(us) Dev(us) Speed(us/ms) Settle(ms) Accel(us/ms/s)\n");
+    std::printf("--- --- -------- ----- ----- ----- ------- ------------ ---------- --------------\n");
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+    {
+        CalRecord rec = imageRecord(img, version, i);
+        std::printf("%d   %d   %s %u  %u  %u  %u  %u  %u  %u\n", i, servoPins[i], servoNames[i],
+                    rec.L_us, rec.R_us, rec.C_us, rec.CD_us, rec.speed, rec.settleMs, rec.accel);
+    }
+    return 0;
+}
+
+static int restore(const char* tablePath, const char* imagePath)
+{
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    if (!readTable(tablePath, records))
+        return 1;
+
+    std::vector<uint8_t> img;
+    if (!readImage(imagePath, img))
+        img.assign(EEPROM_SIZE, 0xFF);  // Erased EEPROM
+
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+        putRecord(img, CALSTORE_RECORDS_ADDR + i * sizeof(CalRecord), records[i]);
+
+    put16(img, CALSTORE_ADDR, CALSTORE_MAGIC);
+    img[CALSTORE_ADDR + 2] = CALSTORE_VERSION;
+    img[CALSTORE_ADDR + 3] = CALSTORE_NUM_SERVOS;
+    put16(img, CALSTORE_ADDR + 4, calStoreCrc(&img[CALSTORE_RECORDS_ADDR], CALSTORE_RECORDS_SIZE));
+
+    std::ofstream out(imagePath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(img.data()), img.size());
+    if (!out)
+    {
+        std::cerr << "Cannot write " << imagePath << "\n";
+        return 1;
+    }
+    std::cerr << "Wrote " << CALSTORE_NUM_SERVOS << " calibrations to " << imagePath << "\n";
+    return 0;
+}
+
+// The bootloader can't write EEPROM, so the usual way in is the calibration mode over serial
+static int script(const char* tablePath)
+{
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    if (!readTable(tablePath, records))
+        return 1;
+
+    for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+    {
+        const CalRecord& r = records[i];
+        std::printf("i %d %u %u %u %u %u %u %u\n", i, r.L_us, r.R_us, r.C_us, r.CD_us, r.speed, r.settleMs, r.accel);
+    }
+    std::printf("w\n");
+    return 0;
+}
+
+static void usage()
+{
+    std::cerr << "Usage:\n"
+                 "  caltool dump <eeprom.bin>\n"
+                 "  caltool restore <table> <eeprom.bin>\n"
+                 "  caltool script <table>\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && std::strcmp(argv[1], "dump") == 0)
+        return dump(argv[2]);
+    if (argc == 4 && std::strcmp(argv[1], "restore") == 0)
+        return restore(argv[2], argv[3]);
+    if (argc == 3 && std::strcmp(argv[1], "script") == 0)
+        return script(argv[2]);
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,80 @@
+// Classify the sticker colors of 6 face photos, the same way the app does it (see Scan/ColorScan.h).
+// For trying out lighting and cameras on a PC, or checking photos the app got wrong.
+//
+//   colorscan [-s scale] face0.ppm ... face5.ppm
+//
+// Photos are binary PPM (P6, convert anything with "convert photo.jpg face0.ppm"), cropped to the face like the
+// app's scan grid. Prints a line per face with the face each sticker belongs to (0..5, the face whose center
+// it matches) and the sticker colors, and marks stickers whose margin is under 10 with a ?.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../Scan/ColorScan.h"
+
+// Reads a P6 file into ARGB pixels
+static bool readPpm(const char* path, std::vector<uint32_t>& pixels, int& width, int& height)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxValue;
+    if (!(in >> magic >> width >> height >> maxValue) || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+        return false;
+    in.get();   // The one whitespace after the header
+    std::vector<unsigned char> rgb((size_t)width * height * 3);
+    if (!in.read(reinterpret_cast<char*>(rgb.data()), rgb.size()))
+        return false;
+    pixels.resize((size_t)width * height);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = 0xff000000u | rgb[3 * i] << 16 | rgb[3 * i + 1] << 8 | rgb[3 * i + 2];
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    float scale = 0.4f;
+    int first = 1;
+    if (argc > 2 && std::strcmp(argv[1], "-s") == 0)
+    {
+        scale = (float)std::atof(argv[2]);
+        first = 3;
+    }
+    if (argc - first != 6)
+    {
+        std::cerr << "Usage: colorscan [-s scale] face0.ppm face1.ppm face2.ppm face3.ppm face4.ppm face5.ppm\n";
+        return 2;
+    }
+
+    ScanColor colors[54];
+    for (int f = 0; f < 6; f++)
+    {
+        std::vector<uint32_t> pixels;
+        int width, height;
+        if (!readPpm(argv[first + f], pixels, width, height))
+        {
+            std::cerr << "Cannot read " << argv[first + f] << " (binary PPM only)\n";
+            return 1;
+        }
+        sampleFace(pixels.data(), width, height, width, scale, colors + 9 * f);
+    }
+
+    int faces[54];
+    float margins[54];
+    int rounds = classifyStickers(colors, faces, margins);
+    for (int f = 0; f < 6; f++)
+    {
+        std::printf("Face %d:", f);
+        for (int i = 9 * f; i < 9 * f + 9; i++)
+            std::printf(" %d%s", faces[i], margins[i] < 10 ? "?" : " ");
+        std::printf("  ");
+        for (int i = 9 * f; i < 9 * f + 9; i++)
+            std::printf(" #%02x%02x%02x", (int)colors[i].r, (int)colors[i].g, (int)colors[i].b);
+        std::printf("\n");
+    }
+    std::fprintf(stderr, "%d rounds\n", rounds);
+    return 0;
+}
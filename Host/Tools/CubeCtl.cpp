@@ -0,0 +1,77 @@
+// Sends commands to cubed and prints the replies.
+//
+//   cubectl [-S socket] <command...>   One command, like: cubectl SOLVE <facelets>
+//   cubectl [-S socket]                One command per line from stdin
+//
+// Exits with 1 if a reply was ERR or FAILED.
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool readLine(int fd, std::string& pending, std::string& line)
+{
+    char buf[1024];
+    size_t end;
+    while ((end = pending.find('\n')) == std::string::npos)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+            return false;
+        pending.append(buf, n);
+    }
+    line = pending.substr(0, end);
+    pending.erase(0, end + 1);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* socketPath = "/tmp/cubed.sock";
+    int first = 1;
+    if (argc > 2 && std::strcmp(argv[1], "-S") == 0)
+    {
+        socketPath = argv[2];
+        first = 3;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        std::cerr << "cubed is not listening on " << socketPath << "\n";
+        return 1;
+    }
+
+    std::string command, pending, reply;
+    for (int i = first; i < argc; i++)
+        command += std::string(i > first ? " " : "") + argv[i];
+
+    bool failed = false;
+    bool fromStdin = command.empty();
+    while (!fromStdin || std::getline(std::cin, command))
+    {
+        if (!command.empty())
+        {
+            command += "\n";
+            if (write(fd, command.data(), command.size()) < 0 || !readLine(fd, pending, reply))
+            {
+                std::cerr << "cubed went away\n";
+                return 1;
+            }
+            std::printf("%s\n", reply.c_str());
+            std::fflush(stdout);
+            failed |= reply.compare(0, 3, "ERR") == 0 || reply.compare(0, 6, "FAILED") == 0;
+        }
+        if (!fromStdin)
+            break;
+    }
+    close(fd);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,355 @@
+// Robot control daemon: owns the serial links to the robots and runs jobs from a queue for each
+// (see Robot/RobotDaemon.h and Robot/RobotFleet.h).
+// Jobs come in over a Unix socket, one command per line, one reply line each (cubectl sends them).
+//
+//   cubed [options] -p <port> [-p <port> ...]
+//
+// Options:
+//   -p <port>     Serial port of a robot, or the pty of fwsim. Once per robot, the first is robot 0
+//   -S <path>     Socket to listen on (default /tmp/cubed.sock)
+//   -t <ms>       Search time per solve (default 1000)
+//   -m <n>        Longest solution to accept (default 21)
+//   -j <n>        Search threads per solve (default 6, see cubesolve)
+//   -d <ms>       MOVE delay for jobs that don't give one (default 0)
+//   -o <0|1>      Orientation the cube is in when the daemon starts (default 0)
+//   -k <ms>       PING the robot after being idle this long (default 2000)
+//   -T <file>     Table file (see cubesolve)
+//   -R <file>     Record the serial sessions for cubereplay, with more than one robot <file>.<robot>
+//   -M <file>     Write the phase histograms of the jobs there every few seconds, in the Prometheus text format
+//                 (for node_exporter's textfile collector, or cubelat)
+//   -v            Print every command and reply to stderr
+//
+// Commands (put @<robot> in front of one for a certain robot, otherwise it goes to the one that will be done first):
+//   SOLVE [facelets] [delay] [capture_ms=<ms>] [classify_ms=<ms>]
+//                              Solve a cube, without facelets the one the robot will be holding -> OK <id>.
+//                              A client that scanned the cube can say how long that took, for the histograms
+//   MOVES <moves> [delay]      Moves like MOVE takes them ("URRf") -> OK <id>
+//   SEQ <sequence>             A SEQ string -> OK <id>
+//   SCRAMBLE [n] [delay]       n random moves (default 25) -> OK <id>
+//   CYCLE <count> [n]          count times SCRAMBLE n and SOLVE, each pair on one robot -> OK <id of each SOLVE>
+//   WAIT <id> [ms]             Until the job is finished -> DONE <id> <moves|-> <timings> | FAILED <id> <why> | CANCELLED <id>
+//   CANCEL <id>                Stops it, on the robot too if it is running -> OK
+//   STATUS                     Queue and link of every robot -> STATUS ...
+//   STATS                      Throughput of all robots together, or of one with @<robot> -> STATS ...
+// Anything wrong -> ERR <reason>
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "../Robot/RobotFleet.h"
+#include "../Robot/RobotLink.h"
+#include "../Robot/SerialLink.h"
+#include "../Solver/Tables.h"
+
+#define METRICS_INTERVAL_MS 5000
+
+static const char* socketPath = "/tmp/cubed.sock";
+static bool verbose = false;
+
+static void usage()
+{
+    std::cerr << "Usage: cubed [-S socket] [-t ms] [-m maxlen] [-j threads] [-d delay] [-o orientation] [-k ms] [-T tables] [-R capture] [-M metrics] [-v] -p <port> [-p <port> ...]\n";
+}
+
+static double ms(Job::Clock::time_point a, Job::Clock::time_point b)
+{
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static std::string describe(const Job& job)
+{
+    char line[256];
+    if (job.state == Job::DONE)
+    {
+        // Waiting in line, solving (SOLVE only), and on the robot: until it said BUSY, then until IDLE
+        bool ran = job.busy >= job.started && job.idle >= job.busy;
+        std::snprintf(line, sizeof(line), "DONE %d %s queued_ms=%.0f solve_ms=%.0f run_ms=%.0f send_ms=%.0f execute_ms=%.0f",
+                      job.id, job.moves.empty() ? "-" : job.moves.c_str(), ms(job.queued, job.started),
+                      job.kind == Job::SOLVE ? ms(job.solving, job.solved) : 0.0, ms(job.started, job.finished),
+                      ran ? ms(job.started, job.busy) : 0.0, ran ? ms(job.busy, job.idle) : 0.0);
+        std::string out = line;
+        if (job.etaMs >= 0)
+            out += " eta_ms=" + std::to_string(job.etaMs);
+        return out;
+    }
+    std::string out = std::string(jobStateName(job.state)) + " " + std::to_string(job.id);
+    if (!job.error.empty())
+        out += " " + job.error;
+    return out;
+}
+
+static std::string handle(RobotFleet& fleet, const std::string& line)
+{
+    std::istringstream in(line);
+    std::string cmd;
+    in >> cmd;
+    int robot = -1;
+    if (cmd.size() > 1 && cmd[0] == '@')
+    {
+        robot = std::atoi(cmd.c_str() + 1);
+        if (robot < 0 || robot >= fleet.size())
+            return "ERR robot";
+        in >> cmd;
+    }
+    for (char& c : cmd)
+        c = (char)std::toupper((unsigned char)c);
+    std::string error;
+    int id = 0;
+
+    if (cmd == "SOLVE")
+    {
+        std::string facelets;
+        int delay = -1;
+        double captureMs = -1, classifyMs = -1;
+        std::string word;
+        while (in >> word)
+        {
+            if (word.size() == 54)
+                facelets = word;
+            else if (word.compare(0, 11, "capture_ms=") == 0)
+                captureMs = std::atof(word.c_str() + 11);
+            else if (word.compare(0, 12, "classify_ms=") == 0)
+                classifyMs = std::atof(word.c_str() + 12);
+            else
+                delay = std::atoi(word.c_str());
+        }
+        id = fleet.solve(facelets, delay, robot, error, captureMs, classifyMs);
+    }
+    else if (cmd == "MOVES")
+    {
+        std::string moves;
+        int delay = -1;
+        if (!(in >> moves))
+            return "ERR args";
+        in >> delay;
+        id = fleet.moves(moves, delay, robot, error);
+    }
+    else if (cmd == "SEQ")
+    {
+        std::string seq;
+        in >> seq;
+        id = fleet.sequence(seq, robot, error);
+    }
+    else if (cmd == "SCRAMBLE")
+    {
+        int n = 25, delay = -1;
+        in >> n >> delay;
+        id = fleet.scramble(n, delay, robot, error);
+    }
+    else if (cmd == "CYCLE")
+    {
+        int count = 0, n = 25;
+        if (!(in >> count) || count < 1)
+            return "ERR args";
+        in >> n;
+        std::string reply = "OK";
+        for (int i = 0; i < count; i++)
+        {
+            id = fleet.cycle(n, error);
+            if (!id)
+                return "ERR " + error;
+            reply += " " + std::to_string(id);
+        }
+        return reply;
+    }
+    else if (cmd == "WAIT")
+    {
+        int timeout = 24 * 3600 * 1000;
+        if (!(in >> id))
+            return "ERR args";
+        in >> timeout;
+        Job job;
+        if (!fleet.wait(id, job, timeout))
+            return "ERR no_job_or_timeout";
+        return describe(job);
+    }
+    else if (cmd == "CANCEL")
+    {
+        if (!(in >> id))
+            return "ERR args";
+        return fleet.cancel(id) ? "OK" : "ERR no_job";
+    }
+    else if (cmd == "STATUS")
+    {
+        return "STATUS " + fleet.status(robot);
+    }
+    else if (cmd == "STATS")
+    {
+        return "STATS " + fleet.stats(robot);
+    }
+    else
+    {
+        return "ERR unknown_command";
+    }
+    return id ? "OK " + std::to_string(id) : "ERR " + error;
+}
+
+static void serve(RobotFleet& fleet, int fd)
+{
+    std::string pending;
+    char buf[1024];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+        pending.append(buf, n);
+        size_t end;
+        while ((end = pending.find('\n')) != std::string::npos)
+        {
+            std::string line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty())
+                continue;
+            std::string reply = handle(fleet, line);
+            if (verbose)
+                std::fprintf(stderr, "%s -> %s\n", line.c_str(), reply.c_str());
+            reply += "\n";
+            if (write(fd, reply.data(), reply.size()) < 0)
+                break;
+        }
+    }
+    close(fd);
+}
+
+// Written to a temporary file and renamed, so a scrape never sees half of it
+static void writeMetrics(RobotFleet& fleet, const std::string& path)
+{
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(METRICS_INTERVAL_MS));
+        std::string text = fleet.metrics();
+        std::string temp = path + ".tmp";
+        FILE* f = std::fopen(temp.c_str(), "w");
+        if (!f)
+            continue;
+        bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        ok &= std::fclose(f) == 0;
+        if (ok)
+            std::rename(temp.c_str(), path.c_str());
+    }
+}
+
+static void quit(int)
+{
+    unlink(socketPath);
+    _exit(0);
+}
+
+int main(int argc, char** argv)
+{
+    DaemonOptions opt;
+    std::vector<const char*> ports;
+    const char* tableFile = nullptr;
+    const char* recordFile = nullptr;
+    const char* metricsFile = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-p") == 0 && hasValue)
+            ports.push_back(argv[++i]);
+        else if (std::strcmp(argv[i], "-S") == 0 && hasValue)
+            socketPath = argv[++i];
+        else if (std::strcmp(argv[i], "-t") == 0 && hasValue)
+            opt.searchMs = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-m") == 0 && hasValue)
+            opt.maxLength = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-j") == 0 && hasValue)
+            opt.variants = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-d") == 0 && hasValue)
+            opt.delayMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-o") == 0 && hasValue)
+            opt.orientation = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-k") == 0 && hasValue)
+            opt.keepAliveMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-T") == 0 && hasValue)
+            tableFile = argv[++i];
+        else if (std::strcmp(argv[i], "-R") == 0 && hasValue)
+            recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "-M") == 0 && hasValue)
+            metricsFile = argv[++i];
+        else if (std::strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (ports.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    std::string error;
+    if (tableFile && !useTableFile(tableFile, error))
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    getTables();
+
+    std::vector<std::unique_ptr<SerialLink>> serials;
+    std::vector<std::unique_ptr<RobotLink>> links;
+    std::vector<RobotLink*> robots;
+    for (const char* port : ports)
+    {
+        serials.emplace_back(new SerialLink);
+        if (!serials.back()->open(port))
+        {
+            std::cerr << "Cannot open " << port << "\n";
+            return 1;
+        }
+        if (recordFile)
+        {
+            std::string path = recordFile;
+            if (ports.size() > 1)
+                path += "." + std::to_string(serials.size() - 1);
+            if (!serials.back()->record(path))
+            {
+                std::cerr << "Cannot write " << path << "\n";
+                return 1;
+            }
+        }
+        links.emplace_back(new RobotLink(*serials.back()));
+        robots.push_back(links.back().get());
+    }
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+    unlink(socketPath);
+    if (server < 0 || bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(server, 16) != 0)
+    {
+        std::cerr << "Cannot listen on " << socketPath << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, quit);
+    std::signal(SIGTERM, quit);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    RobotFleet fleet(robots, opt);
+    if (metricsFile)
+        std::thread(writeMetrics, std::ref(fleet), std::string(metricsFile)).detach();
+    if (verbose)
+        std::fprintf(stderr, "Listening on %s\n", socketPath);
+    while (true)
+    {
+        int client = accept(server, nullptr, nullptr);
+        if (client >= 0)
+            std::thread(serve, std::ref(fleet), client).detach();
+    }
+}
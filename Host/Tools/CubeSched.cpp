@@ -0,0 +1,185 @@
+// Compiles a solution into one timed servo program (see Solver/ScheduleCompiler.h), prints it and can play it
+// on the robot.
+//
+//   cubesched [options] <moves>
+//
+// Moves are as MOVE takes them ("URRf"). Options:
+//   -e <file>   EEPROM image with the calibrations of the robot (caltool makes these), defaults otherwise
+//   -i          The cube is inverted on the robot (MOVE orientation 1)
+//   -p <port>   Play it: "SEQ <first> +", then APPEND the rest as the robot makes room, and wait for IDLE
+//   -b <baud>   With -p (default 9600)
+//
+// Prints the SEQ strings, how long the program takes and how long MOVE 0 would take for comparison.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../Robot/SerialLink.h"
+#include "../Solver/ScheduleCompiler.h"
+#include "../../Arduino/CalStore.h"
+
+#define EEPROM_SIZE 1024            // ATmega328P
+#define REPLY_TIMEOUT_MS 2000
+#define PLAY_TIMEOUT_MS 120000
+
+static bool loadCalibrations(const char* path, ServoCal* cal)
+{
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    if (path)
+    {
+        std::vector<uint8_t> image(EEPROM_SIZE, 0xFF);
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        in.read(reinterpret_cast<char*>(image.data()), image.size());
+        if (!calStoreReadImage(image.data(), records))
+            return false;
+    }
+    else
+    {
+        // What the firmware falls back to with nothing stored, like defaultRecord() in Calibrate.cpp
+        for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+        {
+            records[i] = {CALSTORE_DEFAULT_L_US, CALSTORE_DEFAULT_R_US, CALSTORE_DEFAULT_C_US, 0,
+                          CALSTORE_DEFAULT_SPEED, CALSTORE_DEFAULT_SETTLE_MS, CALSTORE_DEFAULT_ACCEL};
+        }
+    }
+    for (int i = 0; i < SCHEDULE_SERVOS; i++)
+    {
+        const CalRecord& r = records[i];
+        cal[i] = {r.L_us, r.R_us, r.C_us, r.CD_us, r.speed, r.settleMs, r.accel};
+    }
+    return true;
+}
+
+// Sends one command and returns the reply to it, skipping BUSY/IDLE and other notifications
+static bool command(SerialLink& link, const std::string& line, std::string& reply)
+{
+    if (!link.writeLine(line))
+        return false;
+    while (link.readLine(reply, REPLY_TIMEOUT_MS))
+    {
+        if (reply.compare(0, 2, "OK") == 0 || reply.compare(0, 3, "ERR") == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool play(const char* port, int baud, const std::vector<std::string>& parts, double& ms)
+{
+    SerialLink link;
+    if (!link.open(port, baud))
+    {
+        std::cerr << "Cannot open " << port << "\n";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string reply;
+    if (!command(link, "SEQ " + parts[0] + (parts.size() > 1 ? " +" : ""), reply) || reply != "OK")
+    {
+        std::cerr << "SEQ: " << reply << "\n";
+        return false;
+    }
+    for (size_t i = 1; i < parts.size(); )
+    {
+        if (!command(link, "APPEND " + parts[i] + (i + 1 < parts.size() ? " +" : ""), reply))
+        {
+            std::cerr << "The robot stopped answering\n";
+            return false;
+        }
+        if (reply == "OK")
+            i++;
+        else if (reply == "ERR full")
+            link.readLine(reply, 50);   // Some of it still has to play, try again in a bit
+        else
+        {
+            std::cerr << "APPEND: " << reply << "\n";
+            return false;
+        }
+    }
+    while (link.readLine(reply, PLAY_TIMEOUT_MS))
+    {
+        if (reply == "IDLE")
+        {
+            ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return true;
+        }
+    }
+    std::cerr << "No IDLE from the robot\n";
+    return false;
+}
+
+static void usage()
+{
+    std::cerr << "Usage: cubesched [-e eeprom.eep] [-i] [-p port [-b baud]] <moves>\n";
+}
+
+int main(int argc, char** argv)
+{
+    const char* eepromFile = nullptr;
+    const char* port = nullptr;
+    int baud = 9600;
+    int orientation = ORIENT_NORMAL;
+    std::string moves;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-e") == 0 && hasValue)
+            eepromFile = argv[++i];
+        else if (std::strcmp(argv[i], "-p") == 0 && hasValue)
+            port = argv[++i];
+        else if (std::strcmp(argv[i], "-b") == 0 && hasValue)
+            baud = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-i") == 0)
+            orientation = ORIENT_INVERT;
+        else if (argv[i][0] != '-' && moves.empty())
+            moves = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (moves.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    ServoCal cal[SCHEDULE_SERVOS];
+    if (!loadCalibrations(eepromFile, cal))
+    {
+        std::cerr << "No calibrations in " << eepromFile << "\n";
+        return 1;
+    }
+
+    Schedule schedule;
+    std::string error;
+    if (!compileSchedule(moves, orientation, cal, schedule, error))
+    {
+        std::cerr << "Cannot compile: " << error << "\n";
+        return 1;
+    }
+
+    // Half the buffer, so the next part fits in once the robot played the one before
+    std::vector<std::string> parts = scheduleSequences(schedule, SEQUENCE_BUFFER_SIZE / 2);
+    for (const std::string& part : parts)
+        std::printf("%s\n", part.c_str());
+    std::printf("%zu steps, %.0fms, MOVE 0 would take %.0fms, ends in orientation %d\n",
+                schedule.steps.size(), schedule.makespanMs, schedule.perMoveMs, schedule.endOrientation);
+
+    if (port)
+    {
+        double ms = 0;
+        if (!play(port, baud, parts, ms))
+            return 1;
+        std::printf("Played in %.0fms\n", ms);
+    }
+    return 0;
+}
@@ -0,0 +1,395 @@
+// Solve a cube with the two-phase algorithm, and optionally let the robot execute the solution.
+//
+//   cubesolve [options] <facelets>     Facelets are 54 characters URFDLB, in the same order as the app/twophase.jar
+//   cubesolve [options] -s "<moves>"   Solve the cube you get from a scramble like "R U2 F'"
+//   cubesolve [options] -b <file>      Solve every facelet string in a file (- for stdin), one per line
+//
+// Options:
+//   -t <ms>       Search time (default 1000)
+//   -m <n>        Longest solution to accept (default 21)
+//   -j <n>        Search this many symmetric versions of the cube at once, one thread each (1 to 6, default 6)
+//   -p <port>     Send the solution to the robot on this serial port (like /dev/ttyUSB0 or /dev/rfcomm0)
+//   -d <ms>       MOVE delay, 0 waits for the servos to arrive (default 0)
+//   -o <0|1>      Orientation the cube is in right now (default 0)
+//   -l <ms>       With -p, search at least this long before the first move goes out (default 100)
+//   -O <ms>       After the two-phase search, spend up to this long looking for an optimal solution (default 0, off)
+//   -w            With -p, wait for the search to finish and send the whole solution at once instead of streaming
+//   -T <file>     Table file to use (default $CUBE_TABLES or cubetables.bin, built in memory if there is none)
+//   -n <n>        With -b, solve this many cubes at once (default one per core)
+//   -C <file>     Solution cache, looked up before searching and updated after (see SolutionCache.h)
+//   -R <file>     With -p, record the serial session for cubereplay
+//   -v            Print what is going on to stderr
+//
+// With -p the robot starts turning as soon as the first solution is found, see StreamController.h
+//
+// With -b, the solutions are printed in the same order as the input, one per line, as MOVE strings ("URRf",
+// "-" if the cube is already solved, "ERR <code> <reason>" if it can't be solved). The search time is per cube,
+// and -j defaults to 1 since the cubes already keep every core busy. Solves per second and latency
+// percentiles go to stderr at the end.
+//
+// With -O, the two-phase solution is only a fallback: an IDA* search with big pattern databases (see
+// OptimalSearch.h) looks for the shortest solution there is, and gives up after the given time. With -p it implies
+// -w, since the optimal solution can start with different moves.
+//
+// With -C, a cube that is in the cache (or a turned/mirrored version of one that is) isn't searched at all, the
+// robot gets the cached solution in one MOVE.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "../Robot/RobotLink.h"
+#include "../Robot/SerialLink.h"
+#include "../Robot/StreamController.h"
+#include "../Solver/Moves.h"
+#include "../Solver/MultiSearch.h"
+#include "../Solver/OptimalSearch.h"
+#include "../Solver/RobotCost.h"
+#include "../Solver/SolutionCache.h"
+#include "../Solver/ThreadPool.h"
+
+static void usage()
+{
+    std::cerr << "Usage:\n"
+                 "  cubesolve [-t ms] [-m maxlen] [-j threads] [-O ms] [-T tables] [-C cache] [-p port [-d delay] [-o orientation] [-l ms] [-w] [-R capture]] [-v] <facelets>\n"
+                 "  cubesolve [options] -s \"<scramble>\"\n"
+                 "  cubesolve [-t ms] [-m maxlen] [-j threads] [-n threads] [-O ms] [-T tables] [-C cache] -b <file|->\n";
+}
+
+static bool openRobot(SerialLink& serial, RobotLink& robot, const char* port, const char* recordFile)
+{
+    if (!serial.open(port))
+    {
+        std::cerr << "Cannot open " << port << "\n";
+        return false;
+    }
+    if (recordFile && !serial.record(recordFile))
+    {
+        std::cerr << "Cannot write " << recordFile << "\n";
+        return false;
+    }
+    if (!robot.connect())
+    {
+        std::cerr << "No robot on " << port << "\n";
+        return false;
+    }
+    return true;
+}
+
+struct BatchResult
+{
+    std::string output;
+    double ms = 0;
+    int length = -1;    // -1 if not solved
+    bool cached = false;
+    bool optimal = false;
+};
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    size_t i = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+static int batch(const char* path, int threads, const SearchOptions& opt, int variants, long optimalMs,
+                 SolutionCache* cache)
+{
+    std::ifstream file;
+    if (std::strcmp(path, "-") != 0)
+    {
+        file.open(path);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = file.is_open() ? file : std::cin;
+
+    // First token of every line that has one, # starts a comment
+    std::vector<std::string> cubes;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream row(line);
+        std::string facelets;
+        if (row >> facelets && facelets[0] != '#')
+            cubes.push_back(facelets);
+    }
+
+    std::vector<BatchResult> results(cubes.size());
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < cubes.size(); i++)
+        {
+            pool.submit([&, i]()
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                BatchResult& r = results[i];
+                CubieCube cube;
+                int error = cube.fromFacelets(cubes[i]);
+                std::vector<int> solution;
+                long timeMs;
+                if (error)
+                    r.output = "ERR " + std::to_string(error) + " " + CubieCube::errorText(error);
+                else if (cache && cache->lookup(cubes[i], solution, timeMs))
+                    r.cached = true;
+                else if (!solveShortest(cube, opt, variants, 0, optimalMs, solution, r.optimal))
+                    r.output = "ERR 7 No solution found within the length and time limit";
+                else if (cache)
+                    cache->store(cubes[i], solution);
+                if (r.output.empty())
+                {
+                    r.output = solution.empty() ? "-" : movesToRobot(solution);
+                    r.length = (int)solution.size();
+                }
+                r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            });
+        }
+        threads = pool.size();
+        pool.wait();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> latencies;
+    int solved = 0, cached = 0, optimal = 0, already = 0;
+    long moves = 0;
+    for (const BatchResult& r : results)
+    {
+        std::printf("%s\n", r.output.c_str());
+        latencies.push_back(r.ms);
+        cached += r.cached;
+        optimal += r.optimal;
+        if (r.length >= 0)
+        {
+            solved++;
+            moves += r.length;
+            already += r.length == 0;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::fprintf(stderr, "Solved %d of %zu cubes in %.2fs on %d threads: %.1f solves/s\n",
+                 solved, cubes.size(), seconds, threads, seconds > 0 ? cubes.size() / seconds : 0.0);
+    std::fprintf(stderr, "Latency (ms): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+                 percentile(latencies, 50), percentile(latencies, 90), percentile(latencies, 99),
+                 latencies.empty() ? 0.0 : latencies.back());
+    if (optimalMs > 0)
+        std::fprintf(stderr, "Known to be optimal: %d of %d\n", optimal, solved);
+    if (cache)
+        std::fprintf(stderr, "Cache hits: %d of %zu, %zu cubes in the cache\n", cached, cubes.size(), cache->size());
+    if (already)
+        std::fprintf(stderr, "Already solved: %d\n", already);
+    if (solved > already)
+        std::fprintf(stderr, "Average solution length: %.2f moves\n", (double)moves / (solved - already));
+    return solved == (int)cubes.size() ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    long timeMs = 1000;
+    int maxLength = 21;
+    int variants = -1;     // Not given
+    int poolThreads = 0;
+    const char* batchFile = nullptr;
+    const char* port = nullptr;
+    int delayMs = 0;
+    int orientation = 0;
+    long leadMs = 100;
+    bool wholeSolution = false;
+    long optimalMs = 0;
+    bool verbose = false;
+    const char* tableFile = nullptr;
+    const char* cacheFile = nullptr;
+    const char* recordFile = nullptr;
+    const char* scramble = nullptr;
+    const char* facelets = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-t") == 0 && hasValue)
+            timeMs = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-m") == 0 && hasValue)
+            maxLength = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-j") == 0 && hasValue)
+            variants = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-p") == 0 && hasValue)
+            port = argv[++i];
+        else if (std::strcmp(argv[i], "-d") == 0 && hasValue)
+            delayMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-o") == 0 && hasValue)
+            orientation = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-l") == 0 && hasValue)
+            leadMs = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-s") == 0 && hasValue)
+            scramble = argv[++i];
+        else if (std::strcmp(argv[i], "-b") == 0 && hasValue)
+            batchFile = argv[++i];
+        else if (std::strcmp(argv[i], "-n") == 0 && hasValue)
+            poolThreads = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "-T") == 0 && hasValue)
+            tableFile = argv[++i];
+        else if (std::strcmp(argv[i], "-C") == 0 && hasValue)
+            cacheFile = argv[++i];
+        else if (std::strcmp(argv[i], "-R") == 0 && hasValue)
+            recordFile = argv[++i];
+        else if (std::strcmp(argv[i], "-O") == 0 && hasValue)
+            optimalMs = std::atol(argv[++i]);
+        else if (std::strcmp(argv[i], "-w") == 0)
+            wholeSolution = true;
+        else if (std::strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (argv[i][0] != '-' && !facelets)
+            facelets = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if ((facelets != nullptr) + (scramble != nullptr) + (batchFile != nullptr) != 1 || (batchFile && port))
+    {
+        usage();
+        return 2;
+    }
+    if (variants < 0)
+        variants = batchFile ? 1 : N_VARIANTS;
+
+    std::string error;
+    if (tableFile && !useTableFile(tableFile, error))
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    SolutionCache cache;
+    if (cacheFile && !cache.open(cacheFile, error))
+    {
+        std::cerr << "Cannot open cache " << error << "\n";
+        return 1;
+    }
+
+    if (batchFile)
+    {
+        SearchOptions opt;
+        opt.maxLength = maxLength;
+        opt.timeoutMs = timeMs;
+        return batch(batchFile, poolThreads, opt, variants, optimalMs, cacheFile ? &cache : nullptr);
+    }
+
+    CubieCube cube;
+    if (scramble)
+    {
+        std::vector<int> moves;
+        if (!parseMoves(scramble, moves))
+        {
+            std::cerr << "Bad scramble: " << scramble << "\n";
+            return 1;
+        }
+        cube.applyMoves(moves);
+    }
+    else
+    {
+        int error = cube.fromFacelets(facelets);
+        if (error)
+        {
+            std::cerr << "Error " << error << ": " << CubieCube::errorText(error) << "\n";
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string cubeFacelets = cube.toFacelets();
+    std::vector<int> solution;
+    long cachedMs;
+    bool cached = cacheFile && cache.lookup(cubeFacelets, solution, cachedMs, orientation, delayMs);
+    if (cached && verbose)
+        std::fprintf(stderr, "Cache hit after %lldus, the robot takes about %ldms\n", (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count(), cachedMs);
+
+    if (!cached)
+    {
+        getTables();
+        if (optimalMs > 0)
+            getOptimalTables();
+        if (verbose)
+            std::fprintf(stderr, "Tables ready after %lldms (%s%s%s)\n", (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count(), tablesSource(), optimalMs > 0 ? ", " : "",
+                optimalMs > 0 ? optimalTablesSource() : "");
+    }
+
+    // ---- Just solve it ----
+    if (!port || wholeSolution || cached || optimalMs > 0)
+    {
+        if (!cached)
+        {
+            SearchOptions opt;
+            opt.maxLength = maxLength;
+            opt.timeoutMs = timeMs;
+            if (verbose)
+                opt.onSolution = [](const std::vector<int>& s) { std::fprintf(stderr, "Found %zu moves\n", s.size()); };
+            bool optimal;
+            if (!solveShortest(cube, opt, variants, orientation, optimalMs, solution, optimal))
+            {
+                std::cerr << "No solution of at most " << maxLength << " moves found\n";
+                return 1;
+            }
+            if (verbose && optimalMs > 0)
+                std::fprintf(stderr, optimal ? "That is optimal\n" : "Not known to be optimal\n");
+            if (cacheFile)
+                cache.store(cubeFacelets, solution);
+        }
+        std::printf("%s\n", movesToString(solution).c_str());
+        if (!port || solution.empty())
+            return 0;
+
+        SerialLink serial;
+        RobotLink robot(serial);
+        if (!openRobot(serial, robot, port, recordFile))
+            return 1;
+        std::string reply = robot.command("MOVE " + std::to_string(delayMs) + " " + std::to_string(orientation) + " " +
+                                          movesToRobot(solution));
+        if (!RobotLink::isOk(reply))
+        {
+            std::cerr << "Robot said \"" << reply << "\"\n";
+            return 1;
+        }
+        if (verbose && RobotLink::etaMs(reply) >= 0)
+            std::fprintf(stderr, "The robot expects to take %d ms\n", RobotLink::etaMs(reply));
+        return robot.waitIdle(10000 + 5000 * robotQuarterTurns(solution)) ? 0 : 1;
+    }
+
+    // ---- Solve while the robot turns ----
+    SerialLink serial;
+    RobotLink robot(serial);
+    if (!openRobot(serial, robot, port, recordFile))
+        return 1;
+
+    StreamOptions opt;
+    opt.delayMs = delayMs;
+    opt.orientation = orientation;
+    opt.maxLength = maxLength;
+    opt.searchMs = timeMs;
+    opt.leadMs = leadMs;
+    opt.variants = variants;
+    opt.verbose = verbose;
+    StreamController controller(robot);
+    std::vector<int> executed;
+    bool ok = controller.run(cube, opt, executed);
+    // Streamed solutions are put together from several searches, but they solve the cube all the same
+    if (ok && cacheFile)
+        cache.store(cubeFacelets, executed);
+    std::printf("%s\n", movesToString(executed).c_str());
+    if (verbose)
+        std::fprintf(stderr, "%zu moves in %lldms\n", executed.size(), (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    return ok ? 0 : 1;
+}
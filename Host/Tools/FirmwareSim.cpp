@@ -0,0 +1,131 @@
+// Runs the robot firmware on the PC behind a pseudo terminal, so cubesolve, cubed and the rest can talk to it
+// like to a real robot (see Sim/Firmware.h).
+//
+//   fwsim [-s speed] [-e eeprom.eep] [-l link] [-v]
+//
+// Prints the pty path (like /dev/pts/5) and runs until killed.
+//   -s <x>     Run the firmware clock x times faster than real time (default 1)
+//   -e <file>  EEPROM image with the calibrations (caltool makes these), without one the firmware uses its defaults
+//   -l <path>  Also make a symlink to the pty here, for a fixed path like /tmp/robot0
+//   -v         Echo the serial traffic to stderr
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <poll.h>
+#include <pty.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+#include "../Sim/Firmware.h"
+
+static int master = -1;
+static const char* linkPath = nullptr;
+static bool verbose = false;
+
+static void readInput(int timeoutMs)
+{
+    pollfd p = {master, POLLIN, 0};
+    if (poll(&p, 1, timeoutMs) <= 0)
+        return;
+    char buf[256];
+    ssize_t n = read(master, buf, sizeof(buf));
+    if (n > 0)
+    {
+        firmwareInput(std::string(buf, n));
+        if (verbose)
+            std::fprintf(stderr, "> %.*s", (int)n, buf);
+    }
+}
+
+static void quit(int)
+{
+    if (linkPath)
+        unlink(linkPath);
+    _exit(0);
+}
+
+int main(int argc, char** argv)
+{
+    double speed = 1;
+    const char* eepromFile = nullptr;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-s") == 0 && hasValue)
+            speed = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "-e") == 0 && hasValue)
+            eepromFile = argv[++i];
+        else if (std::strcmp(argv[i], "-l") == 0 && hasValue)
+            linkPath = argv[++i];
+        else if (std::strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else
+        {
+            std::cerr << "Usage: fwsim [-s speed] [-e eeprom.eep] [-l link] [-v]\n";
+            return 2;
+        }
+    }
+
+    if (eepromFile)
+    {
+        std::ifstream in(eepromFile, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Cannot open " << eepromFile << "\n";
+            return 1;
+        }
+        in.read(reinterpret_cast<char*>(firmwareEeprom()), 1024);
+    }
+
+    int slave;
+    char name[128];
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0)
+    {
+        std::cerr << "openpty: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    // The slave stays open here too, so the pty survives clients coming and going
+
+    if (linkPath)
+    {
+        unlink(linkPath);
+        if (symlink(name, linkPath) != 0)
+        {
+            std::cerr << "Cannot link " << linkPath << ": " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    std::signal(SIGINT, quit);
+    std::signal(SIGTERM, quit);
+    std::printf("%s\n", name);
+    std::fflush(stdout);
+
+    firmwareOnOutput([](const std::string& s)
+    {
+        if (write(master, s.data(), s.size()) < 0 && verbose)
+            std::perror("write");
+        if (verbose)
+            std::fputs(s.c_str(), stderr);
+    });
+    firmwareOnInputWait([speed](unsigned long ms) { readInput((int)(ms / speed)); });
+    firmwareRealTime(speed);
+    firmwareStart();
+
+    while (true)
+    {
+        readInput(0);
+        firmwareLoop();
+        // A real loop() takes about this long, no need to burn a whole core on it
+        usleep((useconds_t)(FIRMWARE_LOOP_US / speed));
+    }
+}
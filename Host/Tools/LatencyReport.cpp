@@ -0,0 +1,116 @@
+// Reads the phase histograms cubed writes (-M) and prints their percentiles.
+//
+//   cubelat [options] <file> [<file> ...]
+//
+// A file is a metrics file as cubed writes it or as it was scraped, "-" reads stdin. The histograms of all
+// files are added up, so the metrics of several days or several daemons give one table. Options:
+//   -r          A table per robot, instead of all robots together
+//   -k <kind>   Only this kind of job (solve, moves, seq)
+//
+// For every kind of job and phase: how many, p50, p90, p99, max and mean, in ms. Percentiles are the top of
+// their bucket, within 1% (see Robot/LatencyHistogram.h).
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include "../Robot/LatencyHistogram.h"
+
+#define METRIC "cubed_job_phase_ms"
+
+// The value of one label in robot="0",kind="solve",phase="queue"
+static std::string label(const std::string& labels, const std::string& name)
+{
+    std::string key = name + "=\"";
+    size_t at = labels.find(key);
+    if (at == std::string::npos)
+        return "";
+    at += key.size();
+    return labels.substr(at, labels.find('"', at) - at);
+}
+
+static void usage()
+{
+    std::cerr << "Usage: cubelat [-r] [-k kind] <metrics file|-> [...]\n";
+}
+
+int main(int argc, char** argv)
+{
+    bool perRobot = false;
+    std::string onlyKind;
+    std::map<std::string, LatencyHistogram> read;
+    int files = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-r") == 0)
+            perRobot = true;
+        else if (std::strcmp(argv[i], "-k") == 0 && hasValue)
+            onlyKind = argv[++i];
+        else if (argv[i][0] != '-' || std::strcmp(argv[i], "-") == 0)
+        {
+            bool found;
+            if (std::strcmp(argv[i], "-") == 0)
+                found = readHistograms(std::cin, METRIC, read);
+            else
+            {
+                std::ifstream in(argv[i]);
+                if (!in)
+                {
+                    std::cerr << "Cannot open " << argv[i] << "\n";
+                    return 1;
+                }
+                found = readHistograms(in, METRIC, read);
+            }
+            if (!found)
+                std::cerr << "No " METRIC " in " << argv[i] << "\n";
+            files++;
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (files == 0)
+    {
+        usage();
+        return 2;
+    }
+
+    // Group by robot (or not) and kind, phases in the order they happen
+    static const char* phases[] = {"capture", "classify", "queue", "solve", "send", "execute", "total"};
+    std::map<std::string, std::map<std::string, LatencyHistogram>> tables;
+    for (const auto& entry : read)
+    {
+        std::string kind = label(entry.first, "kind");
+        if (!onlyKind.empty() && kind != onlyKind)
+            continue;
+        std::string title = perRobot ? "robot " + label(entry.first, "robot") + " " + kind : kind;
+        tables[title][label(entry.first, "phase")].add(entry.second);
+    }
+    if (tables.empty())
+    {
+        std::cerr << "No jobs\n";
+        return 1;
+    }
+
+    for (const auto& table : tables)
+    {
+        std::printf("%s\n%-10s %8s %10s %10s %10s %10s %10s\n", table.first.c_str(),
+                    "phase", "count", "p50", "p90", "p99", "max", "mean");
+        for (const char* phase : phases)
+        {
+            auto it = table.second.find(phase);
+            if (it == table.second.end() || it->second.count() == 0)
+                continue;
+            const LatencyHistogram& h = it->second;
+            std::printf("%-10s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", phase, (unsigned long long)h.count(),
+                        h.percentile(50), h.percentile(90), h.percentile(99), h.maxMs(), h.meanMs());
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Build the solver tables and write them to a table file (see Solver/TableFile.h), or check one.
+//
+//   maketables [file]        Write the tables (default cubetables.bin)
+//   maketables -c [file]     Check that a table file is valid for this build of the solver
+//   maketables -o [file]     Write the pattern databases of the optimal solver (default cubeoptimal.bin, 87MB)
+//   maketables -co [file]    Check those
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "../Solver/OptimalTables.h"
+#include "../Solver/TableFile.h"
+#include "../Solver/Tables.h"
+
+int main(int argc, char** argv)
+{
+    const char* flags = argc > 1 && argv[1][0] == '-' ? argv[1] + 1 : "";
+    bool check = std::strchr(flags, 'c') != nullptr;
+    bool optimal = std::strchr(flags, 'o') != nullptr;
+    int first = *flags ? 2 : 1;
+    if (argc > first + 1 || std::strspn(flags, "co") != std::strlen(flags))
+    {
+        std::cerr << "Usage: maketables [-c] [-o] [file]\n";
+        return 2;
+    }
+    std::string path = argc > first ? argv[first] : optimal ? "cubeoptimal.bin" : "cubetables.bin";
+    std::string error;
+
+    if (optimal)
+    {
+        if (!check)
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<OptimalTables> tables(new OptimalTables);
+            tables->build();
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (!writeTableData(tables.get(), sizeof(OptimalTables), OPTIMAL_FILE_MAGIC, OPTIMAL_FILE_VERSION, path, error))
+            {
+                std::cerr << error << "\n";
+                return 1;
+            }
+            std::printf("Built the optimal tables in %lldms, wrote %zu bytes to %s\n", ms,
+                        TABLE_FILE_DATA_OFFSET + sizeof(OptimalTables), path.c_str());
+        }
+        if (!mapTableData(path, sizeof(OptimalTables), OPTIMAL_FILE_MAGIC, OPTIMAL_FILE_VERSION, true, error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::printf("%s is valid (version %d)\n", path.c_str(), OPTIMAL_FILE_VERSION);
+        return 0;
+    }
+
+    if (!check)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<Tables> tables(new Tables);
+        tables->build();
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        if (!writeTableFile(*tables, path, error))
+        {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        std::printf("Built the tables in %lldms, wrote %zu bytes to %s\n", ms, TABLE_FILE_DATA_OFFSET + sizeof(Tables), path.c_str());
+    }
+
+    // Read it back the way the solver does
+    if (!mapTableFile(path, true, error))
+    {
+        std::cerr << error << "\n";
+        return 1;
+    }
+    std::printf("%s is valid (version %d)\n", path.c_str(), TABLE_FILE_VERSION);
+    return 0;
+}
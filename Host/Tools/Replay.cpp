@@ -0,0 +1,397 @@
+// Replays a recorded serial session (cubesolve -R, cubed -R) against the firmware built for the PC (see Sim/),
+// and compares how long the robot was busy with how long it was in the capture.
+//
+//   cubereplay [options] <capture>
+//
+// Options:
+//   -e <file>   EEPROM image with the calibrations of the robot (caltool makes these)
+//   -s <x>      The capture was made against fwsim -s x, its times are x times too short
+//   -o <file>   Write the replayed session as a capture, to compare the next firmware change against
+//   -f <pct>    Exit with 1 if the robot was busy more than pct percent longer than in the capture
+//   -a          Print every move, not just the ones that changed the most
+//
+// The firmware runs on the virtual clock, so a replay takes a fraction of a second and comes out the same every
+// time. Every command goes out as long after the line from the robot it followed in the capture (the 3rd IDLE,
+// say) as it did there, so a host that waited for the robot waits just the same in the replay, however much
+// faster or slower the robot got.
+//
+// A MOVE that isn't streamed doesn't say when each move is done, so the replay notes that itself (lines with "="
+// in its capture). For per-move times against a capture from a real robot, use a capture that streamed, or
+// compare against an earlier replay (-o).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../Sim/Firmware.h"
+#include "../../Arduino/SequenceManager.h"
+
+#define REPLAY_WAIT_LIMIT_MS 600000     // Give up on a line that doesn't come after this long (virtual)
+#define SHOW_MOVES 10                   // Biggest changes to print without -a
+#define SAME_PERCENT 2                  // A move that changed less than this counts as the same
+
+struct Event
+{
+    double ms;
+    char direction;     // '>' sent, '<' received, '=' noted by the replay
+    std::string text;
+};
+
+// One stretch between BUSY and IDLE
+struct Actuation
+{
+    std::string command;        // What started it
+    double startMs = 0, endMs = 0;
+    std::vector<double> moveMs; // How long each move took, if known
+};
+
+static bool loadCapture(const char* path, double scale, std::vector<Event>& events)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::istringstream fields(line);
+        Event e;
+        std::string direction;
+        if (!(fields >> e.ms >> direction) || direction.size() != 1)
+            continue;
+        e.ms *= scale;
+        e.direction = direction[0];
+        std::getline(fields >> std::ws, e.text);
+        events.push_back(e);
+    }
+    return true;
+}
+
+static void saveCapture(const char* path, const std::vector<Event>& events)
+{
+    FILE* f = std::fopen(path, "w");
+    if (!f)
+    {
+        std::cerr << "Cannot write " << path << "\n";
+        return;
+    }
+    std::fprintf(f, "# cube capture 1\n");
+    for (const Event& e : events)
+        std::fprintf(f, "%.3f %c %s\n", e.ms, e.direction, e.text.c_str());
+    std::fclose(f);
+}
+
+static std::vector<Actuation> actuations(const std::vector<Event>& events)
+{
+    // The replay's own notes if there are any, otherwise what the robot said while streaming
+    bool noted = std::any_of(events.begin(), events.end(), [](const Event& e) { return e.direction == '='; });
+    char movedFrom = noted ? '=' : '<';
+
+    std::vector<Actuation> out;
+    std::string lastCommand;
+    Actuation current;
+    bool busy = false;
+    double lastBoundary = 0;
+    for (const Event& e : events)
+    {
+        if (e.direction == '>')
+        {
+            if (e.text.compare(0, 4, "MOVE") == 0 || e.text.compare(0, 3, "SEQ") == 0)
+                lastCommand = e.text;
+        }
+        else if (e.direction == '<' && e.text == "BUSY" && !busy)
+        {
+            busy = true;
+            current = Actuation();
+            current.command = lastCommand;
+            current.startMs = lastBoundary = e.ms;
+        }
+        else if (e.direction == '<' && e.text == "IDLE" && busy)
+        {
+            busy = false;
+            current.endMs = e.ms;
+            out.push_back(current);
+        }
+        else if (busy && e.direction == movedFrom && e.text.compare(0, 6, "MOVED ") == 0)
+        {
+            current.moveMs.push_back(e.ms - lastBoundary);
+            lastBoundary = e.ms;
+        }
+    }
+    return out;
+}
+
+// ---- Replay ----
+
+static std::vector<Event> replayed;
+static std::map<std::string, std::vector<double>> seen;     // When each line came from the robot
+static std::string partial;
+static int lastMoved = 0;
+
+static double nowMs()
+{
+    return firmwareMicros() / 1000.0;
+}
+
+static void step()
+{
+    // A move is done before anything this loop prints about it (the IDLE after the last one)
+    size_t first = replayed.size();
+    double ms = nowMs();
+    firmwareLoop();
+    int moved = seqManager.movesFinished();
+    if (moved != lastMoved && moved > 0)
+        replayed.insert(replayed.begin() + first, {ms, '=', "MOVED " + std::to_string(moved)});
+    lastMoved = moved;
+}
+
+static void runUntil(double ms)
+{
+    while (nowMs() < ms)
+        step();
+}
+
+// Until the robot said text for the count-th time. Returns when, or -1 if it never did
+static double runUntilSeen(const std::string& text, int count)
+{
+    double limit = nowMs() + REPLAY_WAIT_LIMIT_MS;
+    while ((int)seen[text].size() < count && nowMs() < limit)
+        step();
+    return (int)seen[text].size() < count ? -1 : seen[text][count - 1];
+}
+
+static int replay(const std::vector<Event>& capture)
+{
+    firmwareOnOutput([](const std::string& s)
+    {
+        partial += s;
+        size_t end;
+        while ((end = partial.find('\n')) != std::string::npos)
+        {
+            std::string line = partial.substr(0, end);
+            partial.erase(0, end + 1);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            replayed.push_back({nowMs(), '<', line});
+            seen[line].push_back(nowMs());
+        }
+    });
+    firmwareStart();
+
+    int lost = 0;   // Commands whose line never came
+    std::map<std::string, int> count;
+    const Event* anchor = nullptr;
+    int anchorCount = 0;
+    for (const Event& e : capture)
+    {
+        if (e.direction == '<')
+        {
+            anchor = &e;
+            anchorCount = ++count[e.text];
+            continue;
+        }
+        if (e.direction != '>')
+            continue;
+
+        double from = 0;
+        if (anchor)
+        {
+            from = runUntilSeen(anchor->text, anchorCount);
+            if (from < 0)
+            {
+                lost++;
+                from = nowMs();
+            }
+        }
+        runUntil(from + (e.ms - (anchor ? anchor->ms : 0)));
+        firmwareInput(e.text + "\n");
+        replayed.push_back({nowMs(), '>', e.text});
+    }
+
+    // Let the last command finish
+    double limit = nowMs() + REPLAY_WAIT_LIMIT_MS;
+    step();
+    while (seqManager.isBusy() && nowMs() < limit)
+        step();
+    runUntil(nowMs() + 100);
+    return lost;
+}
+
+// ---- Report ----
+
+static double total(const std::vector<Actuation>& list)
+{
+    double ms = 0;
+    for (const Actuation& a : list)
+        ms += a.endMs - a.startMs;
+    return ms;
+}
+
+static size_t moveCount(const std::vector<Actuation>& list)
+{
+    size_t n = 0;
+    for (const Actuation& a : list)
+        n += a.moveMs.size();
+    return n;
+}
+
+static std::string shorten(const std::string& s, size_t n)
+{
+    return s.size() <= n ? s : s.substr(0, n - 2) + "..";
+}
+
+static void usage()
+{
+    std::cerr << "Usage: cubereplay [-e eeprom.eep] [-s speed] [-o replay.txt] [-f percent] [-a] <capture>\n";
+}
+
+int main(int argc, char** argv)
+{
+    const char* eepromFile = nullptr;
+    const char* outFile = nullptr;
+    const char* captureFile = nullptr;
+    double scale = 1;
+    double failPercent = -1;
+    bool all = false;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-e") == 0 && hasValue)
+            eepromFile = argv[++i];
+        else if (std::strcmp(argv[i], "-s") == 0 && hasValue)
+            scale = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "-o") == 0 && hasValue)
+            outFile = argv[++i];
+        else if (std::strcmp(argv[i], "-f") == 0 && hasValue)
+            failPercent = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "-a") == 0)
+            all = true;
+        else if (argv[i][0] != '-' && !captureFile)
+            captureFile = argv[i];
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!captureFile || scale <= 0)
+    {
+        usage();
+        return 2;
+    }
+
+    std::vector<Event> capture;
+    if (!loadCapture(captureFile, scale, capture))
+    {
+        std::cerr << "Cannot open " << captureFile << "\n";
+        return 1;
+    }
+    if (eepromFile)
+    {
+        std::ifstream in(eepromFile, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "Cannot open " << eepromFile << "\n";
+            return 1;
+        }
+        in.read(reinterpret_cast<char*>(firmwareEeprom()), 1024);
+    }
+
+    int lost = replay(capture);
+    if (outFile)
+        saveCapture(outFile, replayed);
+
+    std::vector<Actuation> before = actuations(capture), after = actuations(replayed);
+    double beforeMs = total(before), afterMs = total(after);
+    double change = beforeMs > 0 ? 100 * (afterMs - beforeMs) / beforeMs : 0;
+    std::printf("Capture: %zu actuations, %zu timed moves, busy %.0fms\n", before.size(), moveCount(before), beforeMs);
+    std::printf("Replay:  %zu actuations, %zu timed moves, busy %.0fms (%+.0fms, %+.1f%%)\n", after.size(), moveCount(after),
+                afterMs, afterMs - beforeMs, change);
+
+    // The robot's answers should be the same, just at other times. What it says when it starts up is in the
+    // capture only if opening the port reset it, and who knows where, so that doesn't count
+    std::vector<std::string> startup;
+    for (size_t i = 0; i < replayed.size() && replayed[i].direction == '<'; i++)
+        startup.push_back(replayed[i].text);
+    std::vector<std::string> said[2];
+    const std::vector<Event>* sessions[2] = {&capture, &replayed};
+    for (int i = 0; i < 2; i++)
+    {
+        for (const Event& e : *sessions[i])
+        {
+            if (e.direction == '<' && std::find(startup.begin(), startup.end(), e.text) == startup.end())
+                said[i].push_back(e.text);
+        }
+    }
+    size_t same = 0;
+    while (same < said[0].size() && same < said[1].size() && said[0][same] == said[1][same])
+        same++;
+    if (same < said[0].size() || same < said[1].size())
+        std::printf("The robot said something else from line %zu on: \"%s\" instead of \"%s\"\n", same + 1,
+                    same < said[1].size() ? said[1][same].c_str() : "", same < said[0].size() ? said[0][same].c_str() : "");
+    if (lost)
+        std::printf("%d commands were sent without the line they waited for in the capture\n", lost);
+
+    // Actuations and moves side by side, in order
+    struct Change
+    {
+        size_t actuation, move;
+        double before, after;
+    };
+    std::vector<Change> moves;
+    if (!before.empty())
+        std::printf("\n  #  capture_ms  replay_ms  change  command\n");
+    for (size_t i = 0; i < before.size() && i < after.size(); i++)
+    {
+        double b = before[i].endMs - before[i].startMs, a = after[i].endMs - after[i].startMs;
+        std::printf("%3zu  %10.0f %10.0f %+6.1f%%  %s\n", i + 1, b, a, b > 0 ? 100 * (a - b) / b : 0.0,
+                    shorten(before[i].command, 40).c_str());
+        for (size_t m = 0; m < before[i].moveMs.size() && m < after[i].moveMs.size(); m++)
+            moves.push_back({i + 1, m + 1, before[i].moveMs[m], after[i].moveMs[m]});
+    }
+
+    if (moves.empty())
+    {
+        if (!before.empty())
+            std::printf("\nNo per-move times in the capture (only a streamed MOVE has them), compare against a replay (-o) for those\n");
+    }
+    else
+    {
+        int slower = 0, faster = 0;
+        double sumBefore = 0, sumAfter = 0;
+        for (const Change& c : moves)
+        {
+            sumBefore += c.before;
+            sumAfter += c.after;
+            double pct = c.before > 0 ? 100 * (c.after - c.before) / c.before : 0;
+            if (pct > SAME_PERCENT)
+                slower++;
+            else if (pct < -SAME_PERCENT)
+                faster++;
+        }
+        std::printf("\n%zu moves, %.0fms -> %.0fms on average, %d slower and %d faster by more than %d%%\n", moves.size(),
+                    sumBefore / moves.size(), sumAfter / moves.size(), slower, faster, SAME_PERCENT);
+        if (!all)
+        {
+            std::stable_sort(moves.begin(), moves.end(), [](const Change& a, const Change& b)
+            {
+                return std::fabs(a.after - a.before) > std::fabs(b.after - b.before);
+            });
+            if (moves.size() > SHOW_MOVES)
+                moves.resize(SHOW_MOVES);
+        }
+        std::printf("  #  move  capture_ms  replay_ms  change\n");
+        for (const Change& c : moves)
+            std::printf("%3zu  %4zu  %10.0f %10.0f %+6.0fms\n", c.actuation, c.move, c.before, c.after, c.after - c.before);
+    }
+
+    return failPercent >= 0 && change > failPercent ? 1 : 0;
+}
@@ -0,0 +1,562 @@
+// Looks for faster face turn and flip templates (the ones in Arduino/MoveCore.h) on a model of the grippers
+// (see Solver/GripperModel.h) and prints the ones that beat what is there now, to paste over them.
+//
+//   cubetpl [options]
+//
+// Options:
+//   -e <file>   EEPROM image with the calibrations of the robot (caltool makes these), defaults otherwise
+//   -p          Sliders may stop halfway (r, l) where that is enough, it's less to travel
+//   -k <n>      Work out the dependencies of the n most promising scripts of each (default 20)
+//   -w <file>   Write them into that MoveCore.h instead of printing them
+//   -v          Print every script it tries
+//
+// The search goes through every order of commands and stages that keeps the cube held, and keeps the ones with
+// the fewest stages. For MOVE <delay> that is what counts, the time they take breaks ties. For MOVE 0 each of
+// them gets dependencies that make it as fast as it gets, timed like predictMoves() does over BENCH_SCRAMBLES
+// scrambles. Everything has to be safe in the model whatever order the robot gets its commands done in, and do
+// what the templates there now do. The report says whether those are safe, and how long both take.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../Solver/GripperModel.h"
+#include "../../Arduino/CalStore.h"
+#include "../../Arduino/MoveCore.h"
+
+#define EEPROM_SIZE 1024            // ATmega328P
+#define BENCH_SCRAMBLES 10
+#define BENCH_MOVES 25
+#define SCRIPT_LIMIT 5000           // Shortest scripts it looks at, of each
+#define MIN_GAIN 0.01               // Less than 1% faster isn't worth changing templates that work
+
+static ServoCal cal[MOVE_SERVOS];
+static GripModel model;
+static std::vector<std::string> bench;
+static bool verbose = false;
+
+static bool loadCalibrations(const char* path)
+{
+    CalRecord records[CALSTORE_NUM_SERVOS];
+    if (path)
+    {
+        std::vector<uint8_t> image(EEPROM_SIZE, 0xFF);
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        in.read(reinterpret_cast<char*>(image.data()), image.size());
+        if (!calStoreReadImage(image.data(), records))
+            return false;
+    }
+    else
+    {
+        // What the firmware falls back to with nothing stored, like defaultRecord() in Calibrate.cpp
+        for (int i = 0; i < CALSTORE_NUM_SERVOS; i++)
+        {
+            records[i] = {CALSTORE_DEFAULT_L_US, CALSTORE_DEFAULT_R_US, CALSTORE_DEFAULT_C_US, 0,
+                          CALSTORE_DEFAULT_SPEED, CALSTORE_DEFAULT_SETTLE_MS, CALSTORE_DEFAULT_ACCEL};
+        }
+    }
+    for (int i = 0; i < MOVE_SERVOS; i++)
+    {
+        const CalRecord& r = records[i];
+        cal[i] = {r.L_us, r.R_us, r.C_us, r.CD_us, r.speed, r.settleMs, r.accel};
+    }
+    return true;
+}
+
+static std::string joined(const std::vector<std::string>& parts)
+{
+    std::string out;
+    for (const std::string& part : parts)
+        out += part;
+    return out;
+}
+
+// A template filled in, | becomes delayToken
+static std::string expanded(const std::string& tpl, const char* from, const char* to, const char* delayToken)
+{
+    std::vector<char> buf(tpl.size() * 2 + 1, '\0');
+    appendTemplate(buf.data(), buf.size(), tpl.c_str(), from, to, delayToken);
+    return buf.data();
+}
+
+// A face turn of spinner (r, l, f or b) turning dir (R or L)
+static std::string turnFor(const std::string& tpl, char spinner, char dir, const char* delayToken)
+{
+    char to[5] = {spinner, (char)std::toupper(spinner), dir, dir == 'R' ? 'L' : 'R', '\0'};
+    return expanded(tpl, "sSde", to, delayToken);
+}
+
+// A flip with the front spinner turning x (R to INVERT)
+static std::string flipFor(const std::string& tpl, char x, const char* delayToken)
+{
+    char to[3] = {x, x == 'R' ? 'L' : 'R', '\0'};
+    return expanded(tpl, "xy", to, delayToken);
+}
+
+// Whether a turn and a flip (empty to leave one out) are safe wherever they get used: every face turned both
+// ways on its own, and each flip with a right or left turn after it, or on its own without a turn. They have to
+// do what nowTurn and nowFlip (the ones in MoveCore.h) do
+static bool check(const std::string& turn, const std::string& flip, const std::string& nowTurn,
+                  const std::string& nowFlip, std::string& why)
+{
+    std::vector<std::pair<std::string, std::string>> runs;
+    if (!turn.empty())
+    {
+        for (char spinner : std::string("rlfb"))
+        {
+            for (char dir : std::string("RL"))
+                runs.push_back({turnFor(turn, spinner, dir, "W"), turnFor(nowTurn, spinner, dir, "W")});
+        }
+    }
+    if (!flip.empty())
+    {
+        for (char x : std::string("RL"))
+        {
+            if (turn.empty())
+                runs.push_back({flipFor(flip, x, "W") + "W", flipFor(nowFlip, x, "W") + "W"});
+            for (char spinner : turn.empty() ? std::string() : std::string("rl"))
+            {
+                for (char dir : std::string("RL"))
+                {
+                    runs.push_back({flipFor(flip, x, "W") + turnFor(turn, spinner, dir, "W"),
+                                    flipFor(nowFlip, x, "W") + turnFor(nowTurn, spinner, dir, "W")});
+                }
+            }
+        }
+    }
+
+    for (const auto& run : runs)
+    {
+        GripWorld end, expected;
+        std::string error;
+        if (!gripPlay(model, run.second, expected, error))
+        {
+            why = "MoveCore.h: " + run.second + ": " + error;
+            return false;
+        }
+        if (!gripVerify(model, run.first, end, error))
+        {
+            why = run.first + ": " + error;
+            return false;
+        }
+        if (!(end == expected))
+        {
+            why = run.first + " turns the cube differently";
+            return false;
+        }
+    }
+    return true;
+}
+
+// How long the benchmark takes with these templates, played like predictMoves() does. delayToken is what | becomes,
+// "W" to time stage templates as if every stage waited for its servos. stages counts the stages
+static double benchMs(const std::string& turn, const std::string& flip, const char* delayToken, int& stages)
+{
+    auto calOf = [](int servo) { return cal[servo]; };
+    double total = 0;
+    stages = 0;
+    for (const std::string& moves : bench)
+    {
+        MoveTimer timer;
+        moveTimerStart(timer, false, calOf);
+        CubeOrientation orientation = ORIENT_NORMAL;
+        for (char m : moves)
+        {
+            int needed = moveNeedsOrientation(m);
+            if (needed >= 0 && needed != orientation)
+            {
+                moveTimerPlay(timer, flipFor(flip, needed == ORIENT_INVERT ? 'R' : 'L', delayToken).c_str(), false,
+                              calOf);
+                orientation = (CubeOrientation)needed;
+            }
+            char to[5];
+            moveTurnPlaceholders(m, to);
+            moveTimerPlay(timer, expanded(turn, "sSde", to, delayToken).c_str(), false, calOf);
+        }
+        total += timer.parseAt;
+        stages += timer.stages;
+    }
+    return total;
+}
+
+// A template as the C of MoveCore.h, a line per part
+static std::string definition(const char* name, const std::vector<std::string>& parts,
+                              const std::vector<std::string>& comments)
+{
+    std::string out = std::string("static const char ") + name + "[] MOVE_PROGMEM =\n";
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        std::string line = "    \"" + parts[i] + "\"" + (i + 1 == parts.size() ? ";" : "");
+        line.resize(std::max(line.size() + 1, (size_t)32), ' ');
+        out += line + "// " + comments[i] + "\n";
+    }
+    return out;
+}
+
+static std::vector<std::string> describe(const GripScript& script, GripTemplate kind, size_t parts)
+{
+    std::vector<std::string> comments;
+    for (const GripStage& stage : script)
+        comments.push_back(gripDescribe(stage, kind));
+    if (parts > script.size())
+        comments.push_back("The next move needs the whole cube held again");
+    return comments;
+}
+
+// Puts definitions over the ones with the same names in a MoveCore.h
+static bool writeInto(const char* path, const std::vector<std::pair<std::string, std::string>>& definitions)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line); )
+        lines.push_back(line);
+    in.close();
+
+    for (const auto& d : definitions)
+    {
+        std::string head = "static const char " + d.first + "[] MOVE_PROGMEM =";
+        auto start = std::find(lines.begin(), lines.end(), head);
+        if (start == lines.end())
+            return false;
+        auto end = start;
+        while (end != lines.end() && end->substr(0, end->find("//")).find("\";") == std::string::npos)
+            end++;
+        if (end == lines.end())
+            return false;
+        std::vector<std::string> replacement;
+        std::istringstream text(d.second);
+        for (std::string line; std::getline(text, line); )
+            replacement.push_back(line);
+        size_t at = start - lines.begin();
+        lines.erase(start, end + 1);
+        lines.insert(lines.begin() + at, replacement.begin(), replacement.end());
+    }
+
+    std::ofstream out(path);
+    for (const std::string& line : lines)
+        out << line << "\n";
+    return (bool)out;
+}
+
+// Quarter turns of the spinners and moves of the sliders, to break ties towards the one that moves less
+static int motion(const GripScript& script)
+{
+    int at[MOVE_SERVOS] = {};     // STATE_C
+    int total = 0;
+    for (const GripStage& stage : script)
+    {
+        for (const GripCommand& c : stage)
+        {
+            auto turn = [](int state) { return state == STATE_R ? 1 : state == STATE_L ? -1 : 0; };
+            total += c.servo % 2 == 0 ? std::abs(turn(c.state) - turn(at[c.servo])) : 1;
+            at[c.servo] = c.state;
+        }
+    }
+    return total;
+}
+
+// A found template with the script it came from
+struct Found
+{
+    GripScript script;
+    std::vector<std::string> parts;
+    double ms = -1;
+    int stages = 0;
+
+    // Fewer stages if they count, less time, less motion
+    bool beats(const Found& other, bool byStages) const
+    {
+        if (other.ms < 0)
+            return true;
+        if (byStages && stages != other.stages)
+            return stages < other.stages;
+        if (ms != other.ms)
+            return ms < other.ms;
+        return motion(script) < motion(other.script);
+    }
+};
+
+// With -p: one slider command after the other stops halfway instead (r for R, l for L), wherever that is still
+// safe and faster. evaluate() makes the template of a script, ms negative if it isn't safe
+static Found halfway(Found best, bool byStages, const std::function<Found(const GripScript&)>& evaluate)
+{
+    if (!model.partial || best.ms < 0)
+        return best;
+    for (size_t i = 0; i < best.script.size(); i++)
+    {
+        for (size_t k = 0; k < best.script[i].size(); k++)
+        {
+            const GripCommand& c = best.script[i][k];
+            if (c.servo % 2 == 0 || (c.state != STATE_R && c.state != STATE_L))
+                continue;
+            GripScript script = best.script;
+            script[i][k].state = c.state == STATE_R ? STATE_r : STATE_l;
+            Found found = evaluate(script);
+            if (found.ms >= 0 && found.beats(best, byStages))
+                best = found;
+        }
+    }
+    return best;
+}
+
+static bool report(const char* name, bool safe, const std::string& why)
+{
+    std::printf("%-22s %s\n", name, safe ? "safe" : ("NOT safe: " + why).c_str());
+    return safe;
+}
+
+static void usage()
+{
+    std::cerr << "Usage: cubetpl [-e eeprom.eep] [-p] [-k n] [-w MoveCore.h] [-v]\n";
+}
+
+int main(int argc, char** argv)
+{
+    const char* eepromFile = nullptr;
+    const char* writeFile = nullptr;
+    size_t keep = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "-e") == 0 && hasValue)
+            eepromFile = argv[++i];
+        else if (std::strcmp(argv[i], "-w") == 0 && hasValue)
+            writeFile = argv[++i];
+        else if (std::strcmp(argv[i], "-k") == 0 && hasValue)
+            keep = std::max(1, std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-p") == 0)
+            model.partial = true;
+        else if (std::strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    if (!loadCalibrations(eepromFile))
+    {
+        std::cerr << "No calibrations in " << eepromFile << "\n";
+        return 1;
+    }
+    for (int i = 0; i < BENCH_SCRAMBLES; i++)
+    {
+        char moves[BENCH_MOVES + 1];
+        scrambleMoves(i + 1, BENCH_MOVES, moves, sizeof(moves));
+        bench.push_back(moves);
+    }
+
+    // How the templates there now do. A turn is checked after a flip only if that flip is safe on its own,
+    // otherwise everything would fail on the flip
+    const std::string nowTurn = moveTurnTemplate, nowFlip = moveFlipTemplate;
+    const std::string nowTurnDeps = moveTurnTemplateDeps, nowFlipDeps = moveFlipTemplateDeps;
+    std::string why;
+    bool turnSafe = report("moveTurnTemplate", check(nowTurn, "", nowTurn, nowFlip, why), why);
+    bool flipSafe = report("moveFlipTemplate", check("", nowFlip, nowTurn, nowFlip, why) &&
+                                               check(nowTurn, nowFlip, nowTurn, nowFlip, why), why);
+    bool turnDepsSafe = report("moveTurnTemplateDeps", check(nowTurnDeps, "", nowTurnDeps, nowFlipDeps, why), why);
+    bool flipDepsSafe = report("moveFlipTemplateDeps", check("", nowFlipDeps, nowTurnDeps, nowFlipDeps, why) &&
+                                                       check(nowTurnDeps, nowFlipDeps, nowTurnDeps, nowFlipDeps, why), why);
+
+    // What they do is the goal: the face on the right gripper turned R, the cube turned over with x = R
+    GripWorld turnGoal, flipGoal;
+    if (!gripPlay(model, turnFor(nowTurn, 'r', 'R', "W"), turnGoal, why) ||
+        !gripPlay(model, flipFor(nowFlip, 'R', "W") + "W", flipGoal, why))
+    {
+        std::cerr << "The templates in MoveCore.h don't play: " << why << "\n";
+        return 1;
+    }
+    size_t explored;
+    // The search only uses whole positions, -p tries halfway ones on what it found
+    GripModel turnModel = model;
+    turnModel.partial = false;
+    turnModel.flips = false;
+    std::vector<GripScript> turns = gripSearch(turnModel, turnGoal, {RIGHT_SPINNER, RIGHT_SLIDER}, SCRIPT_LIMIT, explored);
+    std::printf("Face turns: %zu scripts of %zu stages (%zu positions)\n", turns.size(),
+                turns.empty() ? 0 : turns[0].size(), explored);
+    GripModel flipModel = turnModel;
+    flipModel.flips = true;
+    flipModel.faceTurns = false;
+    std::vector<GripScript> flips = gripSearch(flipModel, flipGoal, {0, 1, 2, 3, 4, 5, 6, 7}, SCRIPT_LIMIT, explored);
+    std::printf("Flips: %zu scripts of %zu stages (%zu positions)\n", flips.size(),
+                flips.empty() ? 0 : flips[0].size(), explored);
+    if (turns.empty() || flips.empty())
+    {
+        std::cerr << "Found no way to do it\n";
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::string>> definitions;
+    auto replace = [&](const char* name, const Found& found, GripTemplate kind)
+    {
+        definitions.push_back({name, definition(name, found.parts, describe(found.script, kind, found.parts.size()))});
+        return joined(found.parts);
+    };
+    auto print = [&](const Found& found, const std::string& error)
+    {
+        if (verbose)
+            std::printf("  %s: %s\n", joined(found.parts).c_str(), found.ms >= 0 ? std::to_string(found.ms).c_str()
+                                                                                : error.c_str());
+    };
+
+    // Stage templates: the fewest stages, then the least time if each stage only waited for its servos. A flip
+    // may leave its last stage to the turn after it
+    int nowStages, stages;
+    benchMs(nowTurn, nowFlip, "W", nowStages);
+    const std::string turnContext = flipSafe ? nowFlip : "";
+    auto stagesTurn = [&](const GripScript& script)
+    {
+        Found found = {script, gripStagesTemplate(script, GRIP_TURN, true)};
+        if (check(joined(found.parts), turnContext, nowTurn, nowFlip, why))
+            found.ms = benchMs(joined(found.parts), nowFlip, "W", found.stages);
+        print(found, why);
+        return found;
+    };
+    Found turn;
+    for (const GripScript& script : turns)
+    {
+        Found found = stagesTurn(script);
+        if (found.ms >= 0 && found.beats(turn, true))
+            turn = found;
+    }
+    turn = halfway(turn, true, stagesTurn);
+    std::string turnTpl = nowTurn;
+    if (turn.ms >= 0 && joined(turn.parts) != nowTurn && (!turnSafe || turn.stages < nowStages))
+        turnTpl = replace("moveTurnTemplate", turn, GRIP_TURN);
+
+    int withTurnStages;
+    benchMs(turnTpl, nowFlip, "W", withTurnStages);
+    bool closeLast = false;
+    auto stagesFlip = [&](const GripScript& script)
+    {
+        Found found = {script, gripStagesTemplate(script, GRIP_FLIP, closeLast)};
+        if (check(turnTpl, joined(found.parts), nowTurn, nowFlip, why))
+            found.ms = benchMs(turnTpl, joined(found.parts), "W", found.stages);
+        print(found, why);
+        return found;
+    };
+    Found flip;
+    bool flipCloses = false;
+    for (const GripScript& script : flips)
+    {
+        for (bool close : {false, true})
+        {
+            closeLast = close;
+            Found found = stagesFlip(script);
+            if (found.ms >= 0 && found.beats(flip, true))
+            {
+                flip = found;
+                flipCloses = close;
+            }
+        }
+    }
+    closeLast = flipCloses;
+    flip = halfway(flip, true, stagesFlip);
+    std::string flipTpl = nowFlip;
+    if (flip.ms >= 0 && joined(flip.parts) != nowFlip && (!flipSafe || flip.stages < withTurnStages))
+        flipTpl = replace("moveFlipTemplate", flip, GRIP_FLIP);
+    benchMs(turnTpl, flipTpl, "W", stages);
+    std::printf("MOVE <delay>: %d stages for the benchmark, %d now\n", stages, nowStages);
+
+    // _deps templates: dependencies for the scripts that are fastest with every stage waiting for its servos,
+    // then the fastest of those
+    auto promising = [&](const std::vector<GripScript>& scripts, GripTemplate kind, const std::string& other)
+    {
+        std::vector<std::pair<double, size_t>> ranked;
+        for (size_t i = 0; i < scripts.size(); i++)
+        {
+            std::string tpl = joined(gripStagesTemplate(scripts[i], kind, true));
+            ranked.push_back({kind == GRIP_TURN ? benchMs(tpl, other, "W", stages) : benchMs(other, tpl, "W", stages), i});
+        }
+        std::sort(ranked.begin(), ranked.end());
+        ranked.resize(std::min(ranked.size(), keep));
+        return ranked;
+    };
+
+    double nowMs = benchMs(nowTurnDeps, nowFlipDeps, nullptr, stages);
+    const std::string depsContext = flipDepsSafe ? nowFlipDeps : "";
+    auto depsTurn = [&](const GripScript& script)
+    {
+        Found found = {script, gripDepsTemplate(script, GRIP_TURN, [&](const std::string& tpl)
+        {
+            std::string ignore;
+            bool safe = check(tpl, depsContext, nowTurnDeps, nowFlipDeps, ignore);
+            return safe ? benchMs(tpl, nowFlipDeps, nullptr, stages) : -1.0;
+        })};
+        if (!found.parts.empty())
+            found.ms = benchMs(joined(found.parts), nowFlipDeps, nullptr, found.stages);
+        print(found, "not safe");
+        return found;
+    };
+    Found turnDeps;
+    for (const auto& candidate : promising(turns, GRIP_TURN, nowFlipDeps))
+    {
+        Found found = depsTurn(turns[candidate.second]);
+        if (found.ms >= 0 && found.beats(turnDeps, false))
+            turnDeps = found;
+    }
+    turnDeps = halfway(turnDeps, false, depsTurn);
+    std::string turnDepsTpl = nowTurnDeps;
+    if (turnDeps.ms >= 0 && joined(turnDeps.parts) != nowTurnDeps &&
+        (!turnDepsSafe || turnDeps.ms < nowMs * (1 - MIN_GAIN)))
+        turnDepsTpl = replace("moveTurnTemplateDeps", turnDeps, GRIP_TURN);
+
+    double withTurnMs = benchMs(turnDepsTpl, nowFlipDeps, nullptr, stages);
+    auto depsFlip = [&](const GripScript& script)
+    {
+        Found found = {script, gripDepsTemplate(script, GRIP_FLIP, [&](const std::string& tpl)
+        {
+            std::string ignore;
+            bool safe = check(turnDepsTpl, tpl, nowTurnDeps, nowFlipDeps, ignore);
+            return safe ? benchMs(turnDepsTpl, tpl, nullptr, stages) : -1.0;
+        })};
+        if (!found.parts.empty())
+            found.ms = benchMs(turnDepsTpl, joined(found.parts), nullptr, found.stages);
+        print(found, "not safe");
+        return found;
+    };
+    Found flipDeps;
+    for (const auto& candidate : promising(flips, GRIP_FLIP, turnDepsTpl))
+    {
+        Found found = depsFlip(flips[candidate.second]);
+        if (found.ms >= 0 && found.beats(flipDeps, false))
+            flipDeps = found;
+    }
+    flipDeps = halfway(flipDeps, false, depsFlip);
+    std::string flipDepsTpl = nowFlipDeps;
+    if (flipDeps.ms >= 0 && joined(flipDeps.parts) != nowFlipDeps &&
+        (!flipDepsSafe || flipDeps.ms < withTurnMs * (1 - MIN_GAIN)))
+        flipDepsTpl = replace("moveFlipTemplateDeps", flipDeps, GRIP_FLIP);
+    std::printf("MOVE 0: %.0f ms for the benchmark, %.0f now\n", benchMs(turnDepsTpl, flipDepsTpl, nullptr, stages), nowMs);
+
+    if (definitions.empty())
+    {
+        std::printf("Nothing better than what MoveCore.h has\n");
+        return 0;
+    }
+    if (writeFile)
+    {
+        if (!writeInto(writeFile, definitions))
+        {
+            std::fprintf(stderr, "Cannot write the templates into %s\n", writeFile);
+            return 1;
+        }
+        std::printf("Wrote %zu templates into %s\n", definitions.size(), writeFile);
+        return 0;
+    }
+    std::printf("\n");
+    for (const auto& d : definitions)
+        std::printf("%s\n", d.second.c_str());
+    return 0;
+}